@@ -0,0 +1,227 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ARCReplacer::ARCReplacer(size_t num_frames) : replacer_size_(num_frames), frames_(num_frames) {}
+
+auto ARCReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  if (curr_size_ == 0) {
+    return false;
+  }
+
+  // Take from T1 while it is above its target size, from T2 otherwise. If every frame of that list is pinned, fall
+  // back to the other one.
+  const bool prefer_t1 = !t1_.empty() && t1_.size() > target_t1_size_;
+  auto victim = FindVictim(prefer_t1 ? t1_ : t2_);
+  if (victim == INVALID_FRAME_ID) {
+    victim = FindVictim(prefer_t1 ? t2_ : t1_);
+  }
+  BUSTUB_ASSERT(victim != INVALID_FRAME_ID, "curr_size_ counts an evictable frame that is in neither list");
+
+  // Remember the evicted page in the ghost list matching the list it came from.
+  const auto page_id = frames_[victim].page_id_;
+  last_victim_ = {victim, page_id, frames_[victim].list_};
+  if (frames_[victim].list_ == ListType::T1) {
+    b1_.push_front(page_id);
+    b1_map_[page_id] = b1_.begin();
+  } else {
+    b2_.push_front(page_id);
+    b2_map_[page_id] = b2_.begin();
+  }
+
+  Untrack(victim);
+  *frame_id = victim;
+  return true;
+}
+
+void ARCReplacer::Restore(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  auto &entry = frames_[frame_id];
+  if (last_victim_.frame_id_ != frame_id || entry.list_ != ListType::NONE) {
+    return;
+  }
+
+  // Take the page back out of its ghost list, so that the next access to it is a plain hit, and put the frame back at
+  // the LRU end of its list: it was the least recently used evictable frame there.
+  const bool from_t1 = last_victim_.list_ == ListType::T1;
+  auto &ghosts = from_t1 ? b1_ : b2_;
+  auto &ghost_map = from_t1 ? b1_map_ : b2_map_;
+  if (auto it = ghost_map.find(last_victim_.page_id_); it != ghost_map.end()) {
+    ghosts.erase(it->second);
+    ghost_map.erase(it);
+  }
+  auto &list = from_t1 ? t1_ : t2_;
+  list.push_back(frame_id);
+  entry.page_id_ = last_victim_.page_id_;
+  entry.list_ = last_victim_.list_;
+  entry.is_evictable_ = true;
+  entry.pos_ = std::prev(list.end());
+  curr_size_++;
+  last_victim_ = Victim();
+}
+
+void ARCReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  auto &entry = frames_[frame_id];
+  if (entry.list_ != ListType::NONE) {
+    if (entry.page_id_ == page_id) {
+      // Cache hit: the page has now been seen at least twice.
+      t2_.splice(t2_.begin(), entry.list_ == ListType::T1 ? t1_ : t2_, entry.pos_);
+      entry.list_ = ListType::T2;
+      return;
+    }
+    // The frame was reused for another page without going through Evict or Remove.
+    Untrack(frame_id);
+  }
+
+  const size_t capacity = replacer_size_;
+  if (auto b1_it = b1_map_.find(page_id); b1_it != b1_map_.end()) {
+    // T1 evicted this page too early, so let T1 grow.
+    target_t1_size_ = std::min(capacity, target_t1_size_ + std::max<size_t>(b2_.size() / b1_.size(), 1));
+    b1_.erase(b1_it->second);
+    b1_map_.erase(b1_it);
+    t2_.push_front(frame_id);
+    entry.list_ = ListType::T2;
+  } else if (auto b2_it = b2_map_.find(page_id); b2_it != b2_map_.end()) {
+    // T2 evicted this page too early, so let T2 grow at the expense of T1.
+    const auto delta = std::max<size_t>(b1_.size() / b2_.size(), 1);
+    target_t1_size_ = target_t1_size_ > delta ? target_t1_size_ - delta : 0;
+    b2_.erase(b2_it->second);
+    b2_map_.erase(b2_it);
+    t2_.push_front(frame_id);
+    entry.list_ = ListType::T2;
+  } else {
+    // A page we know nothing about. Keep T1 + B1 within the capacity and the whole directory within twice of it.
+    if (t1_.size() + b1_.size() >= capacity) {
+      if (!b1_.empty()) {
+        PopGhost(&b1_, &b1_map_);
+      }
+    } else if (t1_.size() + t2_.size() + b1_.size() + b2_.size() >= 2 * capacity && !b2_.empty()) {
+      PopGhost(&b2_, &b2_map_);
+    }
+    t1_.push_front(frame_id);
+    entry.list_ = ListType::T1;
+  }
+
+  entry.page_id_ = page_id;
+  entry.is_evictable_ = false;
+  entry.pos_ = entry.list_ == ListType::T1 ? t1_.begin() : t2_.begin();
+}
+
+void ARCReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  auto &entry = frames_[frame_id];
+  if (entry.list_ == ListType::NONE || entry.is_evictable_ == set_evictable) {
+    return;
+  }
+
+  entry.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void ARCReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  if (frames_[frame_id].list_ == ListType::NONE) {
+    return;
+  }
+  if (!frames_[frame_id].is_evictable_) {
+    throw std::exception();
+  }
+
+  // The page is gone for good, so it is not remembered in a ghost list.
+  Untrack(frame_id);
+}
+
+auto ARCReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+auto ARCReplacer::PeekVictims(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> victims;
+  const bool prefer_t1 = !t1_.empty() && t1_.size() > target_t1_size_;
+  CollectVictims(prefer_t1 ? t1_ : t2_, max_frames, &victims);
+  CollectVictims(prefer_t1 ? t2_ : t1_, max_frames, &victims);
+  return victims;
+}
+
+void ARCReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t frame = num_frames; frame < replacer_size_; frame++) {
+    BUSTUB_ASSERT(frames_[frame].list_ == ListType::NONE, "a frame beyond the new size is still tracked");
+  }
+
+  frames_.resize(num_frames);
+  replacer_size_ = num_frames;
+  target_t1_size_ = std::min(target_t1_size_, num_frames);
+  while (t1_.size() + b1_.size() > num_frames && !b1_.empty()) {
+    PopGhost(&b1_, &b1_map_);
+  }
+  while (t1_.size() + t2_.size() + b1_.size() + b2_.size() > 2 * num_frames && !b2_.empty()) {
+    PopGhost(&b2_, &b2_map_);
+  }
+}
+
+auto ARCReplacer::FindVictim(const std::list<frame_id_t> &list) const -> frame_id_t {
+  for (auto it = list.rbegin(); it != list.rend(); it++) {
+    if (frames_[*it].is_evictable_) {
+      return *it;
+    }
+  }
+  return INVALID_FRAME_ID;
+}
+
+void ARCReplacer::CollectVictims(const std::list<frame_id_t> &list, size_t max_frames,
+                                 std::vector<frame_id_t> *victims) const {
+  for (auto it = list.rbegin(); it != list.rend() && victims->size() < max_frames; it++) {
+    if (frames_[*it].is_evictable_) {
+      victims->push_back(*it);
+    }
+  }
+}
+
+void ARCReplacer::Untrack(frame_id_t frame_id) {
+  auto &entry = frames_[frame_id];
+  (entry.list_ == ListType::T1 ? t1_ : t2_).erase(entry.pos_);
+  if (entry.is_evictable_) {
+    curr_size_--;
+  }
+  entry = FrameEntry();
+}
+
+void ARCReplacer::PopGhost(GhostList *list, GhostMap *map) {
+  map->erase(list->back());
+  list->pop_back();
+}
+
+}  // namespace bustub
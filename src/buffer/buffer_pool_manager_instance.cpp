@@ -12,152 +12,263 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "common/exception.h"
+#include "common/logger.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     size_t max_pool_size)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, replacer_policy,
+                                max_pool_size) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     size_t max_pool_size)
+    : pool_size_(pool_size),
+      num_frames_(pool_size),
+      max_pool_size_(max_pool_size == 0 ? pool_size : max_pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      page_size_(disk_manager->GetPageSize()),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      frame_data_(max_pool_size_, page_size_),
+      evictable_latches_(max_pool_size_),
+      access_stamps_(max_pool_size_),
+      unevictable_(max_pool_size_),
+      read_ahead_(max_pool_size_),
+      prefetcher_(
+          this, [this](page_id_t page_id, BufferAccessStrategy *strategy) { return ReadAheadPage(page_id, strategy); },
+          [this](const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+            ReadAheadPages(page_ids, strategy);
+          }),
+      retired_(max_pool_size_) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
+  BUSTUB_ASSERT(pool_size > 0 && pool_size <= max_pool_size_, "the pool size must be between 1 and the maximum");
+  // The frame descriptors are kept apart from the frame data, so that scans over pin counts and dirty flags do not
+  // drag page data through the cache. Room is made for the largest pool, but only the frames in use are constructed.
+  pages_ = std::allocator<Page>().allocate(max_pool_size_);
   page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  replacer_ = MakeFrameReplacer(replacer_policy, pool_size, replacer_k);
 
   // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<frame_id_t>(i));
+  for (size_t i = 0; i < pool_size; ++i) {
+    AddFrame(static_cast<frame_id_t>(i));
   }
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  prefetcher_.Stop();
+  StopPageCleaner();
+  stop_retiring_ = true;
+  if (retirer_.joinable()) {
+    retirer_.join();
+  }
+  std::destroy_n(pages_, num_constructed_frames_);
+  std::allocator<Page>().deallocate(pages_, max_pool_size_);
   delete page_table_;
-  delete replacer_;
 }
 
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-
-  bool is_free_page = false;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() == 0) {
-      is_free_page = true;
-      break;
+auto BufferPoolManagerInstance::Resize(size_t pool_size) -> bool {
+  if (pool_size == 0 || pool_size > max_pool_size_) {
+    return false;
+  }
+  std::scoped_lock<std::mutex> resize_lock(resize_latch_);
+  auto lock = LockLatch();
+
+  if (pool_size >= pool_size_) {
+    // The frames still waiting to be retired below the new size simply stay in use.
+    if (pool_size > num_frames_) {
+      replacer_->Resize(pool_size);
+      num_frames_ = pool_size;
+    }
+    for (auto i = pool_size_.load(); i < pool_size; i++) {
+      AddFrame(static_cast<frame_id_t>(i));
     }
+    pool_size_ = pool_size;
+    return true;
   }
 
-  if (!is_free_page) {
-    return nullptr;
+  // From now on no frame beyond the new size is handed out, and the free ones can go at once.
+  pool_size_ = pool_size;
+  for (auto it = free_list_.begin(); it != free_list_.end();) {
+    if (!IsRetiring(*it)) {
+      ++it;
+      continue;
+    }
+    while (!ClaimFrame(*it)) {
+      std::this_thread::yield();
+    }
+    RetireClaimedFrame(*it);
+    it = free_list_.erase(it);
   }
 
-  *page_id = AllocatePage();
-
-  frame_id_t frame_id;
-
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    // assert(replacer_->Evict(&frame_id));
-    replacer_->Evict(&frame_id);
-    page_id_t evicted_page_id = pages_[frame_id].GetPageId();
-
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(evicted_page_id, pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
+  // The frames holding pages are left to the retirer, so that a shrink never waits for a pin or a write.
+  if (!shrinking_) {
+    if (retirer_.joinable()) {
+      // The previous retirer has finished: it stops right after clearing the flag under the latch.
+      retirer_.join();
     }
-
-    pages_[frame_id].ResetMemory();
-
-    page_table_->Remove(evicted_page_id);
+    shrinking_ = true;
+    retirer_ = std::thread([this] { RetireFrames(); });
   }
+  return true;
+}
 
-  page_table_->Insert(*page_id, frame_id);
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
+  auto lock = LockLatch();
 
-  pages_[frame_id].page_id_ = *page_id;
-  pages_[frame_id].pin_count_ = 1;
+  frame_id_t frame_id;
+  if (!AwaitFrame(&lock, &frame_id)) {
+    return nullptr;
+  }
 
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
+  *page_id = AllocatePage();
+  InstallFrame(frame_id, *page_id);
 
   return &pages_[frame_id];
 }
 
-auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-
-  frame_id_t frame_id;
-  if (page_table_->Find(page_id, frame_id)) {
-    pages_[frame_id].pin_count_++;
-    replacer_->RecordAccess(frame_id);
-    replacer_->SetEvictable(frame_id, false);
-    return &pages_[frame_id];
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id, PageExtent *extent) -> Page * {
+  if (extent == nullptr || num_instances_ > 1) {
+    return NewPgImp(page_id);
   }
-
-  bool is_free_page = false;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() == 0) {
-      is_free_page = true;
-      break;
-    }
+  *page_id = extent->TakePage([this](size_t num_pages) { return disk_manager_->ReserveExtent(num_pages); });
+  auto *page = NewReservedPage(*page_id);
+  if (page == nullptr) {
+    extent->PutBack(*page_id);
   }
+  return page;
+}
+
+auto BufferPoolManagerInstance::NewReservedPage(page_id_t page_id) -> Page * {
+  ValidatePageId(page_id);
+  auto lock = LockLatch();
 
-  if (!is_free_page) {
+  frame_id_t frame_id;
+  if (!AwaitFrame(&lock, &frame_id)) {
     return nullptr;
   }
 
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    // assert(replacer_->Evict(&frame_id));
-    replacer_->Evict(&frame_id);
-    page_id_t evicted_page_id = pages_[frame_id].GetPageId();
+  disk_manager_->AllocateReservedPage(page_id);
+  InstallFrame(frame_id, page_id);
+  return &pages_[frame_id];
+}
 
-    if (pages_[frame_id].IsDirty()) {
-      disk_manager_->WritePage(evicted_page_id, pages_[frame_id].GetData());
-      pages_[frame_id].is_dirty_ = false;
-    }
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * { return FetchPgImp(page_id, nullptr); }
 
-    pages_[frame_id].ResetMemory();
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  return FetchFrame(page_id, strategy, FetchMode::ACCESS);
+}
 
-    page_table_->Remove(evicted_page_id);
-  }
+auto BufferPoolManagerInstance::PinPgImp(page_id_t page_id) -> Page * {
+  return FetchFrame(page_id, nullptr, FetchMode::OPTIMISTIC);
+}
 
-  page_table_->Insert(page_id, frame_id);
+auto BufferPoolManagerInstance::ReadAheadPage(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  return FetchFrame(page_id, strategy, FetchMode::READ_AHEAD);
+}
 
-  pages_[frame_id].page_id_ = page_id;
-  pages_[frame_id].pin_count_ = 1;
-  disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
+void BufferPoolManagerInstance::ReadAheadPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+  struct PendingRead {
+    page_id_t page_id_;
+    frame_id_t frame_id_;
+    size_t slot_;
+    std::future<void> done_;
+  };
+  std::vector<PendingRead> reads;
+
+  {
+    auto lock = LockLatch();
+    for (auto page_id : page_ids) {
+      frame_id_t frame_id;
+      if (page_table_->Find(page_id, frame_id) || reads_in_flight_.count(page_id) > 0 ||
+          !disk_manager_->IsAllocated(page_id)) {
+        continue;
+      }
+      size_t slot = 0;
+      const bool from_ring = strategy != nullptr && AcquireRingFrame(strategy, &slot, &frame_id);
+      if (!from_ring && !AcquireFrame(&frame_id)) {
+        break;
+      }
+      // The frame stays claimed until its read completes, so nobody else can look at it.
+      reads.push_back({page_id, frame_id, slot, disk_manager_->ReadPageAsync(page_id, pages_[frame_id].GetData())});
+      reads_in_flight_.insert(page_id);
+    }
+    disk_manager_->SubmitIO();
+  }
 
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
+  // The reads are waited for without the latch, so that hits on other pages and misses go on meanwhile.
+  for (auto &read : reads) {
+    read.done_.wait();
+    {
+      auto lock = LockLatch();
+      InstallFrame(read.frame_id_, read.page_id_, true);
+      if (strategy != nullptr) {
+        strategy->SetPage(read.slot_, read.page_id_);
+      }
+      UnpinFrame(read.frame_id_);
+      reads_in_flight_.erase(read.page_id_);
+    }
+    reads_done_cv_.notify_all();
+  }
+}
 
-  return &pages_[frame_id];
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                                              std::shared_ptr<BufferAccessStrategy> strategy) {
+  prefetcher_.Submit(first_page_id, num_pages, std::move(next_page), std::move(strategy));
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
-
   frame_id_t frame_id;
   if (!page_table_->Find(page_id, frame_id)) {
     return false;
   }
 
-  if (pages_[frame_id].GetPinCount() <= 0) {
+  // The caller holds a pin, so the frame cannot be replaced underneath us and no latch is needed.
+  auto &page = pages_[frame_id];
+  if (page.GetPageId() != page_id || page.GetPinCount() <= 0) {
     return false;
   }
 
+  // Mark the page dirty before dropping the pin, otherwise it could be evicted clean.
   if (is_dirty) {
-    pages_[frame_id].is_dirty_ = is_dirty;
+    page.is_dirty_ = true;
   }
 
-  pages_[frame_id].pin_count_--;
+  int pin_count = page.pin_count_;
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
 
-  if (pages_[frame_id].pin_count_ == 0) {
-    replacer_->SetEvictable(frame_id, true);
+  if (pin_count == 1) {
+    num_pinned_frames_--;
+    if (unevictable_[frame_id]) {
+      SyncEvictable(frame_id);
+    }
   }
 
   return true;
@@ -168,49 +279,668 @@ auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
     return false;
   }
 
+  // The frame is pinned rather than held under the latch: the flush read-latches the page, and a thread holding the
+  // page's write latch may be waiting for the latch to fetch another page.
   frame_id_t frame_id;
-
-  if (!page_table_->Find(page_id, frame_id)) {
+  if (!page_table_->Find(page_id, frame_id) || !TryPinFrame(frame_id, page_id, false)) {
     return false;
   }
 
-  disk_manager_->WritePage(page_id, pages_[frame_id].data_);
+  FlushFrame(frame_id);
+  UnpinFrame(frame_id);
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  std::scoped_lock<std::mutex> lock(latch_);
-  for (size_t frame_id = 0; frame_id < pool_size_; frame_id++) {
-    FlushPgImp(pages_[frame_id].GetPageId());
+  // The dirty pages are pinned rather than written under the latch, so that misses can go on during a long flush.
+  auto dirty_pages = PinDirtyPages();
+  WriteCoalesced(disk_manager_, &dirty_pages);
+  UnpinDirtyPages(dirty_pages);
+  disk_manager_->Sync();
+}
+
+auto BufferPoolManagerInstance::PinDirtyPages() -> std::vector<DirtyPage> {
+  std::vector<DirtyPage> pages;
+  for (size_t i = 0; i < num_frames_; i++) {
+    const auto frame_id = static_cast<frame_id_t>(i);
+    auto &page = pages_[frame_id];
+    const auto page_id = page.GetPageId();
+    // Pinning for a flush is not an access, so the replacer keeps its order.
+    if (page_id == INVALID_PAGE_ID || !page.IsDirty() || !TryPinFrame(frame_id, page_id, false)) {
+      continue;
+    }
+
+    // As in CleanFrames, the flag is cleared under the read latch before the copy, so no update is lost.
+    page.RLatch();
+    if (!page.IsDirty()) {
+      page.RUnlatch();
+      UnpinFrame(frame_id);
+      continue;
+    }
+    page.is_dirty_ = false;
+    std::shared_ptr<char[]> copy(new char[page_size_]);
+    memcpy(copy.get(), page.GetData(), page_size_);
+    page.RUnlatch();
+    pages.push_back({page_id, frame_id, std::move(copy)});
+  }
+  return pages;
+}
+
+void BufferPoolManagerInstance::UnpinDirtyPages(const std::vector<DirtyPage> &pages) {
+  for (const auto &page : pages) {
+    UnpinFrame(page.frame_id_);
+  }
+}
+
+void BufferPoolManagerInstance::WriteCoalesced(DiskManager *disk_manager, std::vector<DirtyPage> *pages) {
+  std::sort(pages->begin(), pages->end(),
+            [](const DirtyPage &a, const DirtyPage &b) { return a.page_id_ < b.page_id_; });
+
+  // Issue every write before waiting for any, so that an asynchronous disk manager can run them as one batch.
+  std::vector<std::future<void>> writes;
+  for (size_t i = 0; i < pages->size();) {
+    const auto first_page_id = (*pages)[i].page_id_;
+    std::vector<const char *> run;
+    do {
+      run.push_back((*pages)[i].data_.get());
+      i++;
+    } while (i < pages->size() && (*pages)[i].page_id_ == first_page_id + static_cast<page_id_t>(run.size()));
+
+    if (run.size() == 1) {
+      writes.push_back(disk_manager->WritePageAsync(first_page_id, run[0]));
+    } else {
+      writes.push_back(disk_manager->WritePagesAsync(first_page_id, std::move(run)));
+    }
+  }
+  disk_manager->SubmitIO();
+  for (auto &write : writes) {
+    write.wait();
   }
 }
 
+auto BufferPoolManagerInstance::GetHotPages() -> std::vector<page_id_t> {
+  auto lock = LockLatch();
+  std::vector<page_id_t> page_ids;
+  std::unordered_set<page_id_t> listed;
+  for (size_t i = 0; i < num_frames_; i++) {
+    const auto page_id = pages_[i].GetPageId();
+    if (page_id != INVALID_PAGE_ID && pages_[i].GetPinCount() > 0 && listed.insert(page_id).second) {
+      page_ids.push_back(page_id);
+    }
+  }
+  // Pinned pages show up among the victims too, as the replacer only learns of pins when it tries to evict them.
+  ApplyAccesses();
+  const auto victims = replacer_->PeekVictims(num_frames_);
+  for (auto it = victims.rbegin(); it != victims.rend(); ++it) {
+    const auto page_id = pages_[*it].GetPageId();
+    if (page_id != INVALID_PAGE_ID && listed.insert(page_id).second) {
+      page_ids.push_back(page_id);
+    }
+  }
+  return page_ids;
+}
+
+auto BufferPoolManagerInstance::PreloadPages(const std::vector<page_id_t> &page_ids) -> size_t {
+  auto lock = LockLatch();
+
+  // Only free frames are filled: preloading must not evict pages that are already in use.
+  std::vector<page_id_t> selected;
+  std::unordered_set<page_id_t> seen;
+  for (auto page_id : page_ids) {
+    if (selected.size() == free_list_.size()) {
+      break;
+    }
+    frame_id_t frame_id;
+    if (page_id < 0 || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_ ||
+        !seen.insert(page_id).second || page_table_->Find(page_id, frame_id) || reads_in_flight_.count(page_id) > 0 ||
+        !disk_manager_->IsAllocated(page_id)) {
+      continue;
+    }
+    selected.push_back(page_id);
+  }
+
+  // Reading in page id order sweeps the file once, and every read is issued before waiting for any.
+  std::vector<page_id_t> sorted = selected;
+  std::sort(sorted.begin(), sorted.end());
+  std::unordered_map<page_id_t, frame_id_t> frames;
+  std::vector<std::future<void>> reads;
+  for (auto page_id : sorted) {
+    frame_id_t frame_id;
+    if (!AcquireFrame(&frame_id)) {
+      break;
+    }
+    frames[page_id] = frame_id;
+    reads.push_back(disk_manager_->ReadPageAsync(page_id, pages_[frame_id].GetData()));
+  }
+  disk_manager_->SubmitIO();
+  for (auto &read : reads) {
+    read.wait();
+  }
+
+  // The coldest page is installed first, so that the replacer would evict it first.
+  for (auto it = selected.rbegin(); it != selected.rend(); ++it) {
+    const auto frame = frames.find(*it);
+    if (frame != frames.end()) {
+      InstallFrame(frame->second, *it, true);
+      UnpinFrame(frame->second);
+    }
+  }
+  return frames.size();
+}
+
+void BufferPoolManagerInstance::SaveHotPgsImp() {
+  const auto file_name = HotPageFileName(disk_manager_);
+  if (!file_name.empty()) {
+    WriteHotPageFile(file_name, GetHotPages());
+  }
+}
+
+auto BufferPoolManagerInstance::PreloadHotPgsImp() -> size_t {
+  const auto file_name = HotPageFileName(disk_manager_);
+  return file_name.empty() ? 0 : PreloadPages(ReadHotPageFile(file_name));
+}
+
+auto BufferPoolManagerInstance::HotPageFileName(DiskManager *disk_manager) -> std::string {
+  const auto &db_file = disk_manager->GetFileName();
+  const auto n = db_file.rfind('.');
+  return n == std::string::npos ? "" : db_file.substr(0, n) + ".hot";
+}
+
+void BufferPoolManagerInstance::WriteHotPageFile(const std::string &file_name, const std::vector<page_id_t> &page_ids) {
+  // Written aside and renamed over the old file, so that a crash leaves one list or the other.
+  const auto tmp_name = file_name + ".tmp";
+  std::ofstream file(tmp_name, std::ios::binary | std::ios::trunc);
+  const uint32_t header[2] = {HOT_PAGE_FILE_MAGIC, static_cast<uint32_t>(page_ids.size())};
+  file.write(reinterpret_cast<const char *>(header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(page_ids.data()),
+             static_cast<std::streamsize>(page_ids.size() * sizeof(page_id_t)));
+  file.close();
+  if (!file || rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing hot page file");
+    remove(tmp_name.c_str());
+  }
+}
+
+auto BufferPoolManagerInstance::ReadHotPageFile(const std::string &file_name) -> std::vector<page_id_t> {
+  std::ifstream file(file_name, std::ios::binary);
+  uint32_t header[2];
+  if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != HOT_PAGE_FILE_MAGIC) {
+    return {};
+  }
+  file.seekg(0, std::ios::end);
+  const auto list_size = static_cast<size_t>(file.tellg()) - sizeof(header);
+  if (list_size != header[1] * sizeof(page_id_t)) {
+    LOG_DEBUG("hot page file is corrupt");
+    return {};
+  }
+  std::vector<page_id_t> page_ids(header[1]);
+  file.seekg(sizeof(header));
+  file.read(reinterpret_cast<char *>(page_ids.data()), static_cast<std::streamsize>(list_size));
+  return file ? page_ids : std::vector<page_id_t>{};
+}
+
+auto BufferPoolManagerInstance::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  stats.hits_ = hits_;
+  stats.misses_ = misses_;
+  stats.evictions_ = evictions_;
+  stats.dirty_evictions_ = foreground_writes_;
+  stats.pinned_high_water_ = pinned_high_water_;
+  stats.latch_waits_ = latch_waits_;
+  stats.latch_wait_ns_ = latch_wait_ns_;
+  return stats;
+}
+
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  auto lock = LockLatch();
+  // A page being read ahead is not in the page table yet. Deallocating it now would install a deleted page.
+  reads_done_cv_.wait(lock, [&] { return reads_in_flight_.count(page_id) == 0; });
 
   frame_id_t frame_id;
   if (!page_table_->Find(page_id, frame_id)) {
+    DeallocatePage(page_id);
     return true;
   }
 
-  if (pages_[frame_id].GetPinCount() > 0) {
+  if (!ClaimFrame(frame_id)) {
     return false;
   }
 
-  replacer_->Remove(frame_id);
+  RemoveClaimedFrame(frame_id);
 
   pages_[frame_id].ResetMemory();
   pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  pages_[frame_id].pin_count_ = 0;
   pages_[frame_id].is_dirty_ = false;
 
   page_table_->Remove(page_id);
-  free_list_.push_back(frame_id);
+  if (IsRetiring(frame_id)) {
+    RetireClaimedFrame(frame_id);
+  } else {
+    pages_[frame_id].pin_count_.fetch_sub(PIN_COUNT_CLAIMED);
+    free_list_.push_back(frame_id);
+  }
   DeallocatePage(page_id);
 
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManagerInstance::RunPageCleaner(size_t num_clean_frames) {
+  std::scoped_lock<std::mutex> lock(cleaner_latch_);
+  if (cleaner_running_) {
+    return;
+  }
+
+  cleaner_running_ = true;
+  page_cleaner_ = std::thread([this, num_clean_frames] {
+    std::unique_lock<std::mutex> cleaner_lock(cleaner_latch_);
+    while (cleaner_running_) {
+      cleaner_lock.unlock();
+      CleanFrames(num_clean_frames);
+      cleaner_lock.lock();
+      cleaner_cv_.wait_for(cleaner_lock, page_cleaner_interval);
+    }
+  });
+}
+
+void BufferPoolManagerInstance::StopPageCleaner() {
+  {
+    std::scoped_lock<std::mutex> lock(cleaner_latch_);
+    if (!cleaner_running_) {
+      return;
+    }
+    cleaner_running_ = false;
+  }
+  cleaner_cv_.notify_one();
+  page_cleaner_.join();
+}
+
+auto BufferPoolManagerInstance::FetchFrame(page_id_t page_id, BufferAccessStrategy *strategy, FetchMode mode)
+    -> Page * {
+  const bool access = mode == FetchMode::ACCESS;
+  // Fast path: the page is resident, so pin it without taking the latch.
+  frame_id_t frame_id;
+  if (page_table_->Find(page_id, frame_id) && TryPinFrame(frame_id, page_id, access)) {
+    if (access) {
+      hits_++;
+    }
+    return &pages_[frame_id];
+  }
+
+  auto lock = LockLatch();
+  size_t slot = 0;
+  while (true) {
+    // A batch read ahead may be reading the page in without the latch. Wait for it rather than read the page twice.
+    reads_done_cv_.wait(lock, [&] { return reads_in_flight_.count(page_id) == 0; });
+
+    // Someone may have brought the page in while we were waiting for the latch.
+    if (page_table_->Find(page_id, frame_id) && TryPinFrame(frame_id, page_id, access)) {
+      if (access) {
+        hits_++;
+      }
+      return &pages_[frame_id];
+    }
+    // Optimistic reads and read aheads follow links that may have changed since they were read. Pages are only
+    // deallocated under the latch, so a page found allocated here stays so until it is resident, and can't be reused.
+    if (mode != FetchMode::ACCESS && !disk_manager_->IsAllocated(page_id)) {
+      return nullptr;
+    }
+
+    const bool from_ring = strategy != nullptr && AcquireRingFrame(strategy, &slot, &frame_id);
+    if (from_ring || AcquireFrame(&frame_id)) {
+      break;
+    }
+    // The frames reading pages ahead come back once their reads complete. The page may be brought in meanwhile, so
+    // look for it again afterwards.
+    if (reads_in_flight_.empty()) {
+      return nullptr;
+    }
+    reads_done_cv_.wait(lock);
+  }
+
+  if (mode != FetchMode::READ_AHEAD) {
+    misses_++;
+  }
+  disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
+  InstallFrame(frame_id, page_id, mode == FetchMode::READ_AHEAD);
+  if (strategy != nullptr) {
+    strategy->SetPage(slot, page_id);
+  }
+
+  return &pages_[frame_id];
+}
+
+auto BufferPoolManagerInstance::TryPinFrame(frame_id_t frame_id, page_id_t page_id, bool record_access) -> bool {
+  auto &page = pages_[frame_id];
+  const int old_pin_count = page.pin_count_.fetch_add(1);
+  if (old_pin_count == 0) {
+    // Counted before validating, so that the unpin undoing a failed pin balances it.
+    CountPinnedFrame();
+  }
+  if (old_pin_count < 0 || page.GetPageId() != page_id) {
+    // The frame is being replaced, or was already reused for another page after our page table lookup.
+    UnpinFrame(frame_id);
+    return false;
+  }
+
+  // The first fetch of a page that was read ahead claims the access recorded when the page was read in.
+  if (record_access && !(read_ahead_[frame_id] && read_ahead_[frame_id].exchange(false))) {
+    access_stamps_[frame_id] = std::chrono::steady_clock::now().time_since_epoch().count();
+    // Only the first hit since the last ApplyAccesses writes the flag, so hot hits do not bounce its cache line.
+    if (!accesses_pending_.load(std::memory_order_relaxed)) {
+      accesses_pending_ = true;
+    }
+  }
+  // The replacer is not told that the frame is pinned: should it pick the frame as a victim, AcquireFrame finds the
+  // pin and takes it out of the running until the frame is unpinned.
+  return true;
+}
+
+auto BufferPoolManagerInstance::LockLatch() -> std::unique_lock<std::mutex> {
+  std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    const auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    latch_wait_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                          .count();
+    latch_waits_++;
+  }
+  return lock;
+}
+
+void BufferPoolManagerInstance::CountPinnedFrame() {
+  const auto num_pinned_frames = ++num_pinned_frames_;
+  auto high_water = pinned_high_water_.load();
+  while (high_water < num_pinned_frames && !pinned_high_water_.compare_exchange_weak(high_water, num_pinned_frames)) {
+  }
+}
+
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id) {
+  // The pin count is dropped before the flag is read, and SyncEvictable sets the flag before reading the pin count, so
+  // either this unpin sees the flag or AcquireFrame sees the frame unpinned: the frame is never left out of the
+  // running.
+  if (pages_[frame_id].pin_count_.fetch_sub(1) == 1) {
+    num_pinned_frames_--;
+    if (unevictable_[frame_id]) {
+      SyncEvictable(frame_id);
+    }
+  }
+}
+
+void BufferPoolManagerInstance::SyncEvictable(frame_id_t frame_id) {
+  // Read the pin count and update the replacer as one step, so that whoever syncs last leaves the flag matching the
+  // final pin count. A claimed frame belongs to the thread that claimed it, which updates the replacer itself.
+  std::scoped_lock<std::mutex> lock(evictable_latches_[frame_id]);
+  unevictable_[frame_id] = true;
+  const int pin_count = pages_[frame_id].GetPinCount();
+  if (pin_count >= 0) {
+    replacer_->SetEvictable(frame_id, pin_count == 0);
+    unevictable_[frame_id] = pin_count != 0;
+  }
+}
+
+void BufferPoolManagerInstance::ApplyAccesses() {
+  if (!accesses_pending_.exchange(false)) {
+    return;
+  }
+  // Frames change pages only under the latch, and a frame's stamp is cleared when it does, so each stamp still belongs
+  // to the page in the frame. A hit racing with the scan either is picked up now or sets the flag for the next one.
+  std::vector<std::pair<uint64_t, frame_id_t>> accesses;
+  for (size_t i = 0; i < num_frames_; i++) {
+    const auto stamp = access_stamps_[i].exchange(0);
+    if (stamp != 0) {
+      accesses.emplace_back(stamp, static_cast<frame_id_t>(i));
+    }
+  }
+  std::sort(accesses.begin(), accesses.end());
+  for (const auto &[stamp, frame_id] : accesses) {
+    replacer_->RecordAccess(frame_id, pages_[frame_id].GetPageId());
+  }
+}
+
+void BufferPoolManagerInstance::RemoveClaimedFrame(frame_id_t frame_id) {
+  // An unpin that raced with the claim may not have told the replacer yet; the frame is ours now, so it is evictable.
+  std::scoped_lock<std::mutex> lock(evictable_latches_[frame_id]);
+  replacer_->SetEvictable(frame_id, true);
+  replacer_->Remove(frame_id);
+  unevictable_[frame_id] = false;
+  access_stamps_[frame_id] = 0;
+}
+
+auto BufferPoolManagerInstance::ClaimFrame(frame_id_t frame_id) -> bool {
+  int expected = 0;
+  return pages_[frame_id].pin_count_.compare_exchange_strong(expected, PIN_COUNT_CLAIMED);
+}
+
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id) -> bool {
+  // Both counts are maintained incrementally, so a pool with every frame pinned is detected without looking at frames.
+  if (free_list_.empty() && replacer_->Size() == 0) {
+    return false;
+  }
+
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    // A free frame can only be pinned by a stale page table lookup, which backs off right away.
+    while (!ClaimFrame(*frame_id)) {
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  ApplyAccesses();
+  while (replacer_->Evict(frame_id)) {
+    if (!ClaimFrame(*frame_id)) {
+      // The frame is pinned. Put it back where the replacer had it, rather than record an access that ghost lists and
+      // histories would take for a second one, and keep it out of the running until its last unpin.
+      replacer_->Restore(*frame_id);
+      SyncEvictable(*frame_id);
+      continue;
+    }
+
+    ClearFrame(*frame_id);
+    evictions_++;
+    if (IsRetiring(*frame_id)) {
+      // The pool is shrinking: the frame goes rather than being reused, saving the retirer from waiting for it.
+      RetireClaimedFrame(*frame_id);
+      continue;
+    }
+    return true;
+  }
+
+  return false;
+}
+
+auto BufferPoolManagerInstance::AwaitFrame(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id) -> bool {
+  while (!AcquireFrame(frame_id)) {
+    if (reads_in_flight_.empty()) {
+      return false;
+    }
+    reads_done_cv_.wait(*lock);
+  }
+  return true;
+}
+
+auto BufferPoolManagerInstance::AcquireRingFrame(BufferAccessStrategy *strategy, size_t *slot, frame_id_t *frame_id)
+    -> bool {
+  const auto victim_page_id = strategy->NextVictim(slot);
+  // With a parallel buffer pool, the ring also holds pages of other instances. Those frames are not ours to reuse.
+  if (victim_page_id == INVALID_PAGE_ID ||
+      static_cast<uint32_t>(victim_page_id) % num_instances_ != instance_index_) {
+    return false;
+  }
+  // The page table only changes under the latch, so the frame still holds the page if the claim succeeds.
+  if (!page_table_->Find(victim_page_id, *frame_id) || !ClaimFrame(*frame_id)) {
+    return false;
+  }
+
+  RemoveClaimedFrame(*frame_id);
+  ClearFrame(*frame_id);
+  evictions_++;
+  if (IsRetiring(*frame_id)) {
+    RetireClaimedFrame(*frame_id);
+    return false;
+  }
+  return true;
+}
+
+void BufferPoolManagerInstance::RetireClaimedFrame(frame_id_t frame_id) {
+  frame_data_.Release(frame_id);
+  retired_[frame_id] = true;
+}
+
+void BufferPoolManagerInstance::AddFrame(frame_id_t frame_id) {
+  const auto i = static_cast<size_t>(frame_id);
+  if (i == num_constructed_frames_) {
+    new (&pages_[i]) Page(frame_data_.GetFrame(frame_id), page_size_);
+    num_constructed_frames_++;
+  } else if (retired_[i]) {
+    retired_[i] = false;
+    pages_[i].pin_count_.fetch_sub(PIN_COUNT_CLAIMED);
+  } else {
+    return;
+  }
+  free_list_.push_back(frame_id);
+}
+
+void BufferPoolManagerInstance::RetireFrames() {
+  while (!stop_retiring_) {
+    for (auto i = pool_size_.load(); i < num_frames_ && !stop_retiring_; i++) {
+      // One frame per latch hold, so that misses get in between the evictions.
+      auto lock = LockLatch();
+      const auto frame_id = static_cast<frame_id_t>(i);
+      // A pinned frame is retried on the next pass.
+      if (!IsRetiring(frame_id) || retired_[i] || !ClaimFrame(frame_id)) {
+        continue;
+      }
+      if (pages_[frame_id].GetPageId() != INVALID_PAGE_ID) {
+        RemoveClaimedFrame(frame_id);
+        ClearFrame(frame_id);
+        evictions_++;
+      }
+      RetireClaimedFrame(frame_id);
+    }
+
+    {
+      auto lock = LockLatch();
+      bool done = true;
+      for (auto i = pool_size_.load(); i < num_frames_ && done; i++) {
+        done = retired_[i];
+      }
+      if (done) {
+        // No frame beyond the pool size is tracked any more, and none will be until the pool grows again.
+        replacer_->Resize(pool_size_);
+        num_frames_ = pool_size_.load();
+        shrinking_ = false;
+        return;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void BufferPoolManagerInstance::ClearFrame(frame_id_t frame_id) {
+  auto &page = pages_[frame_id];
+  page_table_->Remove(page.GetPageId());
+  if (page.IsDirty()) {
+    disk_manager_->WritePage(page.GetPageId(), page.GetData());
+    page.is_dirty_ = false;
+    foreground_writes_++;
+    // The cleaner is falling behind: have it run now rather than at the end of its interval.
+    cleaner_cv_.notify_one();
+  }
+  page.ResetMemory();
+  page.page_id_ = INVALID_PAGE_ID;
+  access_stamps_[frame_id] = 0;
+}
+
+void BufferPoolManagerInstance::InstallFrame(frame_id_t frame_id, page_id_t page_id, bool read_ahead) {
+  auto &page = pages_[frame_id];
+  read_ahead_[frame_id] = read_ahead;
+  page.page_id_ = page_id;
+  page_table_->Insert(page_id, frame_id);
+
+  // The frame goes in as evictable although it is pinned: the replacer learns of pins only when it picks a pinned
+  // frame.
+  replacer_->RecordAccess(frame_id, page_id);
+  replacer_->SetEvictable(frame_id, true);
+  unevictable_[frame_id] = false;
+
+  // Release the claim, leaving exactly one pin for the caller. Adding keeps any racing optimistic pins balanced.
+  page.pin_count_.fetch_add(1 - PIN_COUNT_CLAIMED);
+  CountPinnedFrame();
+}
+
+void BufferPoolManagerInstance::FlushFrame(frame_id_t frame_id) {
+  auto &page = pages_[frame_id];
+  // As in CleanFrames, the flag is cleared before the page is copied under its read latch, so that an unpin marking it
+  // dirty meanwhile gets it written again rather than lost, and the write never sees a half-made change.
+  std::vector<char> copy(page_size_);
+  page.RLatch();
+  page.is_dirty_ = false;
+  memcpy(copy.data(), page.GetData(), page_size_);
+  page.RUnlatch();
+  disk_manager_->WritePage(page.GetPageId(), copy.data());
+  disk_manager_->SyncPage(page.GetPageId());
+}
+
+void BufferPoolManagerInstance::CleanFrames(size_t num_clean_frames) {
+  struct PendingWrite {
+    frame_id_t frame_id_;
+    std::future<void> done_;
+  };
+  std::vector<PendingWrite> writes;
+  std::vector<frame_id_t> victims;
+  {
+    auto lock = LockLatch();
+    ApplyAccesses();
+    victims = replacer_->PeekVictims(num_clean_frames);
+  }
+  // Each page is written from a copy, so that no page stays latched while its write is in flight.
+  std::vector<char> staging(victims.size() * page_size_);
+
+  for (auto frame_id : victims) {
+    auto &page = pages_[frame_id];
+    const auto page_id = page.GetPageId();
+    // Pinning keeps the frame from being replaced while it is written. It is not an access, so the page stays cold.
+    if (page_id == INVALID_PAGE_ID || !page.IsDirty() || !TryPinFrame(frame_id, page_id, false)) {
+      continue;
+    }
+
+    // Writers modify a page under its write latch and mark it dirty when they unpin it, so clearing the flag before
+    // the write can at worst cause one extra write later, never lose an update.
+    page.RLatch();
+    if (!page.IsDirty()) {
+      page.RUnlatch();
+      UnpinFrame(frame_id);
+      continue;
+    }
+    page.is_dirty_ = false;
+    char *copy = &staging[writes.size() * page_size_];
+    memcpy(copy, page.GetData(), page_size_);
+    page.RUnlatch();
+
+    writes.push_back({frame_id, disk_manager_->WritePageAsync(page_id, copy)});
+    background_writes_++;
+  }
+
+  disk_manager_->SubmitIO();
+  for (auto &write : writes) {
+    // The pin is held until the write is done, so the page cannot be evicted and read back stale in the meantime.
+    write.done_.wait();
+    UnpinFrame(write.frame_id_);
+  }
+}
+
+auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
+  const page_id_t page_id = disk_manager_->AllocatePage(num_instances_, instance_index_);
+  ValidatePageId(page_id);
+  return page_id;
+}
+
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+}
 
 }  // namespace bustub
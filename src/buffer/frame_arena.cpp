@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+#include <cstdint>
+#include <cstring>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, size_t frame_size, bool use_huge_pages) : frame_size_(frame_size) {
+  BUSTUB_ASSERT(frame_size % FRAME_ALIGNMENT == 0, "frames must stay aligned for direct I/O");
+  const size_t size = num_frames * frame_size;
+  if (size == 0) {
+    return;
+  }
+
+  // A pool smaller than a huge page would waste most of one, so it gets ordinary pages. Transparent huge pages are
+  // Linux only.
+#ifdef __linux__
+  huge_pages_ = use_huge_pages && size >= HUGE_PAGE_SIZE;
+#endif
+  const size_t alignment = huge_pages_ ? HUGE_PAGE_SIZE : FRAME_ALIGNMENT;
+  size_ = (size + alignment - 1) / alignment * alignment;
+
+  // mmap only aligns to the base page size: map one extra huge page and trim the misaligned head and the tail.
+  const size_t mapping_size = huge_pages_ ? size_ + HUGE_PAGE_SIZE : size_;
+  void *mapping =
+      mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map buffer pool frames");
+  }
+  auto *start = static_cast<char *>(mapping);
+  data_ = start;
+  if (huge_pages_) {
+    const auto address = reinterpret_cast<uintptr_t>(start);
+    data_ = start + ((HUGE_PAGE_SIZE - address % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE);
+    if (data_ > start) {
+      munmap(start, data_ - start);
+    }
+    munmap(data_ + size_, start + mapping_size - (data_ + size_));
+#ifdef __linux__
+    huge_pages_ = madvise(data_, size_, MADV_HUGEPAGE) == 0;
+#endif
+  }
+}
+
+void FrameArena::Release(frame_id_t frame_id) {
+  // A frame is a whole number of base pages, so this never touches a neighbouring frame.
+#ifdef __linux__
+  if (madvise(GetFrame(frame_id), frame_size_, MADV_DONTNEED) == 0) {
+    return;
+  }
+#else
+  // Elsewhere MADV_DONTNEED may leave the contents in place, so fresh zero pages are mapped over the frame instead.
+  if (mmap(GetFrame(frame_id), frame_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) !=
+      MAP_FAILED) {
+    return;
+  }
+#endif
+  memset(GetFrame(frame_id), 0, frame_size_);
+}
+
+FrameArena::~FrameArena() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+}  // namespace bustub
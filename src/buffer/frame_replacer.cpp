@@ -0,0 +1,89 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_replacer.cpp
+//
+// Identification: src/buffer/frame_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_replacer.h"
+
+#include <unordered_map>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_q_replacer.h"
+#include "common/exception.h"
+
+namespace bustub {
+
+auto MakeFrameReplacer(ReplacerPolicy policy, size_t num_frames, size_t k) -> std::unique_ptr<FrameReplacer> {
+  switch (policy) {
+    case ReplacerPolicy::LRU_K:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+    case ReplacerPolicy::ARC:
+      return std::make_unique<ARCReplacer>(num_frames);
+    case ReplacerPolicy::TWO_Q:
+      return std::make_unique<TwoQReplacer>(num_frames);
+  }
+  throw Exception("unknown replacer policy");
+}
+
+auto ReplacerPolicyToString(ReplacerPolicy policy) -> std::string {
+  switch (policy) {
+    case ReplacerPolicy::LRU_K:
+      return "lru-k";
+    case ReplacerPolicy::ARC:
+      return "arc";
+    case ReplacerPolicy::TWO_Q:
+      return "2q";
+  }
+  return "unknown";
+}
+
+auto ParseReplacerPolicy(const std::string &name, ReplacerPolicy *policy) -> bool {
+  for (auto candidate : {ReplacerPolicy::LRU_K, ReplacerPolicy::ARC, ReplacerPolicy::TWO_Q}) {
+    if (name == ReplacerPolicyToString(candidate)) {
+      *policy = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+auto ReplayTrace(ReplacerPolicy policy, size_t num_frames, size_t k, const std::vector<page_id_t> &trace)
+    -> TraceReplayResult {
+  auto replacer = MakeFrameReplacer(policy, num_frames, k);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frames(num_frames, INVALID_PAGE_ID);
+  frame_id_t next_free_frame = 0;
+
+  TraceReplayResult result;
+  for (auto page_id : trace) {
+    result.accesses_++;
+    frame_id_t frame_id;
+    if (auto it = page_table.find(page_id); it != page_table.end()) {
+      result.hits_++;
+      frame_id = it->second;
+    } else {
+      if (static_cast<size_t>(next_free_frame) < num_frames) {
+        frame_id = next_free_frame++;
+      } else {
+        // Nothing is ever left pinned, so there is always a victim.
+        replacer->Evict(&frame_id);
+        page_table.erase(frames[frame_id]);
+      }
+      frames[frame_id] = page_id;
+      page_table[page_id] = frame_id;
+    }
+    replacer->RecordAccess(frame_id, page_id);
+    replacer->SetEvictable(frame_id, true);
+  }
+  return result;
+}
+
+}  // namespace bustub
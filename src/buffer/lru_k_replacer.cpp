@@ -12,9 +12,24 @@
 
 #include "buffer/lru_k_replacer.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : replacer_size_(num_frames),
+      k_(k),
+      nodes_(num_frames + 2),
+      timestamps_(num_frames * k),
+      history_list_(static_cast<frame_id_t>(num_frames)),
+      cache_list_(static_cast<frame_id_t>(num_frames + 1)) {
+  BUSTUB_ASSERT(k > 0, "k must be positive");
+  for (auto sentinel : {history_list_, cache_list_}) {
+    nodes_[sentinel].prev_ = sentinel;
+    nodes_[sentinel].next_ = sentinel;
+  }
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::scoped_lock<std::mutex> lock(latch_);
@@ -23,110 +38,91 @@ auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
     return false;
   }
 
-  for (auto it = history_list_.rbegin(); it != history_list_.rend(); it++) {
-    auto frame = *it;
-    if (is_evictable_[frame]) {
-      access_count_[frame] = 0;
-      history_list_.erase(history_map_[frame]);
-      history_map_.erase(frame);
-      *frame_id = frame;
-      curr_size_--;
-      is_evictable_[frame] = false;
-      return true;
-    }
-  }
-
-  for (auto it = cache_list_.rbegin(); it != cache_list_.rend(); it++) {
-    auto frame = *it;
-    if (is_evictable_[frame]) {
-      access_count_[frame] = 0;
-      cache_list_.erase(cache_map_[frame]);
-      cache_map_.erase(frame);
-      *frame_id = frame;
-      curr_size_--;
-      is_evictable_[frame] = false;
-      return true;
-    }
-  }
-
-  return false;
+  // Frames with +inf backward k-distance go first. The tail of each list holds its largest backward k-distance.
+  auto list = nodes_[history_list_].prev_ != history_list_ ? history_list_ : cache_list_;
+  auto frame = nodes_[list].prev_;
+  Unlink(frame);
+  last_victim_ = frame;
+  last_victim_node_ = nodes_[frame];
+  Reset(frame);
+  curr_size_--;
+  *frame_id = frame;
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+void LRUKReplacer::Restore(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
 
-  if (frame_id > static_cast<int>(replacer_size_)) {
-    throw std::exception();
+  // The timestamps are still in the frame's ring unless an access has been recorded since, which would also have
+  // given the frame a new node.
+  if (last_victim_ != frame_id || nodes_[frame_id].access_count_ != 0) {
+    return;
   }
+  nodes_[frame_id] = last_victim_node_;
+  Link(frame_id);
+  curr_size_++;
+  last_victim_ = INVALID_FRAME_ID;
+}
 
-  access_count_[frame_id]++;
-
-  if (access_count_[frame_id] == k_) {
-    auto it = history_map_[frame_id];
-    history_list_.erase(it);
-    history_map_.erase(frame_id);
-
-    cache_list_.push_front(frame_id);
-    cache_map_[frame_id] = cache_list_.begin();
-  } else if (access_count_[frame_id] > k_) {
-    if (cache_map_.count(frame_id) != 0U) {
-      auto it = cache_map_[frame_id];
-      cache_list_.erase(it);
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+
+  auto &node = nodes_[frame_id];
+  auto *ring = &timestamps_[frame_id * k_];
+  const auto timestamp = current_timestamp_++;
+  if (node.access_count_ < k_) {
+    ring[node.access_count_++] = timestamp;
+    // The key of a frame with fewer than k accesses is its first access, which does not change until it reaches k.
+    if (node.access_count_ < k_ || !node.is_evictable_) {
+      return;
     }
-    cache_list_.push_front(frame_id);
-    cache_map_[frame_id] = cache_list_.begin();
   } else {
-    if (history_map_.count(frame_id) == 0U) {
-      history_list_.push_front(frame_id);
-      history_map_[frame_id] = history_list_.begin();
+    ring[node.oldest_] = timestamp;
+    node.oldest_ = (node.oldest_ + 1) % k_;
+    if (!node.is_evictable_) {
+      return;
     }
   }
+
+  Unlink(frame_id);
+  Link(frame_id);
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   std::scoped_lock<std::mutex> lock(latch_);
-  if (frame_id > static_cast<int>(replacer_size_)) {
-    throw std::exception();
-  }
+  CheckFrameId(frame_id);
 
-  if (access_count_[frame_id] == 0) {
+  auto &node = nodes_[frame_id];
+  if (node.access_count_ == 0 || node.is_evictable_ == set_evictable) {
     return;
   }
 
-  if (!is_evictable_[frame_id] && set_evictable) {
+  node.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    Link(frame_id);
     curr_size_++;
-  }
-  if (is_evictable_[frame_id] && !set_evictable) {
+  } else {
+    Unlink(frame_id);
     curr_size_--;
   }
-  is_evictable_[frame_id] = set_evictable;
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
 
-  if (frame_id > static_cast<int>(replacer_size_)) {
-    throw std::exception();
-  }
-
-  auto cnt = access_count_[frame_id];
-  if (cnt == 0) {
+  if (nodes_[frame_id].access_count_ == 0) {
     return;
   }
-  if (!is_evictable_[frame_id]) {
+  if (!nodes_[frame_id].is_evictable_) {
     throw std::exception();
   }
-  if (cnt < k_) {
-    history_list_.erase(history_map_[frame_id]);
-    history_map_.erase(frame_id);
 
-  } else {
-    cache_list_.erase(cache_map_[frame_id]);
-    cache_map_.erase(frame_id);
-  }
+  Unlink(frame_id);
+  Reset(frame_id);
   curr_size_--;
-  access_count_[frame_id] = 0;
-  is_evictable_[frame_id] = false;
 }
 
 auto LRUKReplacer::Size() -> size_t {
@@ -134,4 +130,101 @@ auto LRUKReplacer::Size() -> size_t {
   return curr_size_;
 }
 
+auto LRUKReplacer::PeekVictims(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> victims;
+  victims.reserve(std::min(max_frames, curr_size_));
+  for (auto list : {history_list_, cache_list_}) {
+    for (auto frame = nodes_[list].prev_; frame != list && victims.size() < max_frames; frame = nodes_[frame].prev_) {
+      victims.push_back(frame);
+    }
+  }
+  return victims;
+}
+
+void LRUKReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t frame = num_frames; frame < replacer_size_; frame++) {
+    BUSTUB_ASSERT(nodes_[frame].access_count_ == 0, "a frame beyond the new size is still tracked");
+  }
+
+  const auto new_history_list = static_cast<frame_id_t>(num_frames);
+  const auto new_cache_list = static_cast<frame_id_t>(num_frames + 1);
+  std::vector<FrameNode> nodes(num_frames + 2);
+  std::copy_n(nodes_.begin(), std::min(num_frames, replacer_size_), nodes.begin());
+  nodes[new_history_list] = nodes_[history_list_];
+  nodes[new_cache_list] = nodes_[cache_list_];
+  // Links to the old sentinels now point past the frames, or at frames that moved in: redirect them.
+  for (auto &node : nodes) {
+    for (auto *link : {&node.prev_, &node.next_}) {
+      if (*link == history_list_) {
+        *link = new_history_list;
+      } else if (*link == cache_list_) {
+        *link = new_cache_list;
+      }
+    }
+  }
+
+  nodes_ = std::move(nodes);
+  timestamps_.resize(num_frames * k_);
+  history_list_ = new_history_list;
+  cache_list_ = new_cache_list;
+  replacer_size_ = num_frames;
+}
+
+void LRUKReplacer::CheckFrameId(frame_id_t frame_id) const {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+}
+
+auto LRUKReplacer::Key(frame_id_t frame_id) const -> size_t {
+  // Before the ring fills up, the oldest slot is slot 0, which holds the first access.
+  return timestamps_[frame_id * k_ + nodes_[frame_id].oldest_];
+}
+
+auto LRUKReplacer::ListOf(frame_id_t frame_id) const -> frame_id_t {
+  return nodes_[frame_id].access_count_ < k_ ? history_list_ : cache_list_;
+}
+
+void LRUKReplacer::Link(frame_id_t frame_id) {
+  // Walk inward from both ends at once, so the cost is the distance to the nearer end. A frame that has just been
+  // accessed or unpinned usually has the largest key and stops at the head right away; a cold frame that was pinned
+  // only for a moment, e.g. by the page cleaner, stops near the tail.
+  const auto list = ListOf(frame_id);
+  const auto key = Key(frame_id);
+  auto prev = list;
+  auto back = list;
+  while (true) {
+    const auto next = nodes_[prev].next_;
+    if (next == list || Key(next) <= key) {
+      break;
+    }
+    prev = next;
+    const auto before_back = nodes_[back].prev_;
+    if (before_back == list || Key(before_back) > key) {
+      prev = before_back;
+      break;
+    }
+    back = before_back;
+  }
+
+  auto next = nodes_[prev].next_;
+  nodes_[frame_id].prev_ = prev;
+  nodes_[frame_id].next_ = next;
+  nodes_[prev].next_ = frame_id;
+  nodes_[next].prev_ = frame_id;
+}
+
+void LRUKReplacer::Unlink(frame_id_t frame_id) {
+  auto &node = nodes_[frame_id];
+  nodes_[node.prev_].next_ = node.next_;
+  nodes_[node.next_].prev_ = node.prev_;
+  node.prev_ = INVALID_FRAME_ID;
+  node.next_ = INVALID_FRAME_ID;
+}
+
+void LRUKReplacer::Reset(frame_id_t frame_id) {
+  nodes_[frame_id] = FrameNode();
+}
+
 }  // namespace bustub
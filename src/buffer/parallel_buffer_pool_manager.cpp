@@ -0,0 +1,240 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     ReplacerPolicy replacer_policy, size_t max_pool_size)
+    : num_instances_(num_instances),
+      disk_manager_(disk_manager),
+      prefetcher_(
+          this,
+          [this](page_id_t page_id, BufferAccessStrategy *strategy) {
+            return GetBufferPoolManager(page_id)->ReadAheadPage(page_id, strategy);
+          },
+          [this](const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+            // Each instance reads its share of the batch at once.
+            std::vector<std::vector<page_id_t>> batches(num_instances_);
+            for (auto page_id : page_ids) {
+              batches[static_cast<size_t>(page_id) % num_instances_].push_back(page_id);
+            }
+            for (size_t i = 0; i < num_instances_; i++) {
+              if (!batches[i].empty()) {
+                instances_[i]->ReadAheadPages(batches[i], strategy);
+              }
+            }
+          }) {
+  BUSTUB_ASSERT(num_instances > 0, "A parallel BPM needs at least one instance");
+  // Allocate and create individual BufferPoolManagerInstances
+  instances_.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    instances_.push_back(new BufferPoolManagerInstance(pool_size, static_cast<uint32_t>(num_instances_),
+                                                       static_cast<uint32_t>(i), disk_manager, replacer_k,
+                                                       log_manager, replacer_policy, max_pool_size));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  prefetcher_.Stop();
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  // Get BufferPoolManager responsible for handling given page id. You can use this method in your other methods.
+  return instances_[static_cast<size_t>(page_id) % num_instances_];
+}
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+auto ParallelBufferPoolManager::Resize(size_t pool_size) -> bool {
+  const auto share = pool_size / num_instances_;
+  const auto remainder = pool_size % num_instances_;
+  if (share == 0 || share + (remainder > 0 ? 1 : 0) > instances_[0]->GetMaxPoolSize()) {
+    return false;
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    instances_[i]->Resize(share + (i < remainder ? 1 : 0));
+  }
+  return true;
+}
+
+void ParallelBufferPoolManager::RunPageCleaner(size_t num_clean_frames) {
+  for (auto *instance : instances_) {
+    instance->RunPageCleaner(num_clean_frames);
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto *instance : instances_) {
+    instance->StopPageCleaner();
+  }
+}
+
+auto ParallelBufferPoolManager::GetForegroundWrites() const -> uint64_t {
+  uint64_t writes = 0;
+  for (auto *instance : instances_) {
+    writes += instance->GetForegroundWrites();
+  }
+  return writes;
+}
+
+auto ParallelBufferPoolManager::GetBackgroundWrites() const -> uint64_t {
+  uint64_t writes = 0;
+  for (auto *instance : instances_) {
+    writes += instance->GetBackgroundWrites();
+  }
+  return writes;
+}
+
+auto ParallelBufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  stats.num_instances_ = instances_.size();
+  for (auto *instance : instances_) {
+    const auto instance_stats = instance->GetStats();
+    stats.hits_ += instance_stats.hits_;
+    stats.misses_ += instance_stats.misses_;
+    stats.evictions_ += instance_stats.evictions_;
+    stats.dirty_evictions_ += instance_stats.dirty_evictions_;
+    stats.pinned_high_water_ = std::max(stats.pinned_high_water_, instance_stats.pinned_high_water_);
+    stats.latch_waits_ += instance_stats.latch_waits_;
+    stats.latch_wait_ns_ += instance_stats.latch_wait_ns_;
+  }
+  return stats;
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, strategy);
+}
+
+auto ParallelBufferPoolManager::PinPgImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->PinPage(page_id);
+}
+
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                                              std::shared_ptr<BufferAccessStrategy> strategy) {
+  prefetcher_.Submit(first_page_id, num_pages, std::move(next_page), std::move(strategy));
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  // Create a new page: starting at the current round-robin index, try each instance once and stop at the first one
+  // that has a frame to give. The starting index advances on every call so that allocations spread across instances.
+  const size_t start = next_instance_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    auto *page = instances_[(start + i) % num_instances_]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id, PageExtent *extent) -> Page * {
+  if (extent == nullptr) {
+    return NewPgImp(page_id);
+  }
+  *page_id = extent->TakePage([this](size_t num_pages) { return disk_manager_->ReserveExtent(num_pages); });
+  auto *page = GetBufferPoolManager(*page_id)->NewReservedPage(*page_id);
+  if (page == nullptr) {
+    extent->PutBack(*page_id);
+  }
+  return page;
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  // Consecutive pages live in different instances, so the dirty pages of all the instances are merged before they are
+  // written, and the disk is synced once for the whole pool.
+  std::vector<std::vector<BufferPoolManagerInstance::DirtyPage>> pinned;
+  std::vector<BufferPoolManagerInstance::DirtyPage> dirty_pages;
+  for (auto *instance : instances_) {
+    pinned.push_back(instance->PinDirtyPages());
+    dirty_pages.insert(dirty_pages.end(), pinned.back().begin(), pinned.back().end());
+  }
+  BufferPoolManagerInstance::WriteCoalesced(disk_manager_, &dirty_pages);
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->UnpinDirtyPages(pinned[i]);
+  }
+  disk_manager_->Sync();
+}
+
+void ParallelBufferPoolManager::SaveHotPgsImp() {
+  const auto file_name = BufferPoolManagerInstance::HotPageFileName(disk_manager_);
+  if (file_name.empty()) {
+    return;
+  }
+  std::vector<std::vector<page_id_t>> instance_pages;
+  size_t max_pages = 0;
+  for (auto *instance : instances_) {
+    instance_pages.push_back(instance->GetHotPages());
+    max_pages = std::max(max_pages, instance_pages.back().size());
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t rank = 0; rank < max_pages; rank++) {
+    for (const auto &pages : instance_pages) {
+      if (rank < pages.size()) {
+        page_ids.push_back(pages[rank]);
+      }
+    }
+  }
+  BufferPoolManagerInstance::WriteHotPageFile(file_name, page_ids);
+}
+
+auto ParallelBufferPoolManager::PreloadHotPgsImp() -> size_t {
+  const auto file_name = BufferPoolManagerInstance::HotPageFileName(disk_manager_);
+  if (file_name.empty()) {
+    return 0;
+  }
+  // Every instance picks its own pages out of the list.
+  const auto page_ids = BufferPoolManagerInstance::ReadHotPageFile(file_name);
+  size_t num_pages = 0;
+  for (auto *instance : instances_) {
+    num_pages += instance->PreloadPages(page_ids);
+  }
+  return num_pages;
+}
+
+}  // namespace bustub
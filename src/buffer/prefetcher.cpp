@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetcher.cpp
+//
+// Identification: src/buffer/prefetcher.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/prefetcher.h"
+
+#include <numeric>
+#include <utility>
+
+namespace bustub {
+
+void Prefetcher::Submit(page_id_t first_page_id, size_t num_pages, BufferPoolManager::next_page_fn next_page,
+                        std::shared_ptr<BufferAccessStrategy> strategy) {
+  if (first_page_id == INVALID_PAGE_ID || num_pages == 0) {
+    return;
+  }
+
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (stopped_ || requests_.size() >= MAX_QUEUED_REQUESTS) {
+      return;
+    }
+    requests_.push_back({first_page_id, num_pages, std::move(next_page), std::move(strategy)});
+    if (!worker_.joinable()) {
+      worker_ = std::thread(&Prefetcher::Run, this);
+    }
+  }
+  cv_.notify_one();
+}
+
+void Prefetcher::Stop() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    stopped_ = true;
+    requests_.clear();
+  }
+  cv_.notify_one();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void Prefetcher::Run() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [this] { return stopped_ || !requests_.empty(); });
+    if (stopped_) {
+      return;
+    }
+    auto request = std::move(requests_.front());
+    requests_.pop_front();
+
+    lock.unlock();
+    Serve(request);
+    lock.lock();
+  }
+}
+
+void Prefetcher::Serve(const Request &request) {
+  if (request.next_page_ == nullptr && read_ahead_batch_ != nullptr) {
+    std::vector<page_id_t> page_ids(request.num_pages_);
+    std::iota(page_ids.begin(), page_ids.end(), request.first_page_id_);
+    read_ahead_batch_(page_ids, request.strategy_.get());
+    return;
+  }
+
+  auto page_id = request.first_page_id_;
+  for (size_t i = 0; i < request.num_pages_ && page_id != INVALID_PAGE_ID && !stopped_; i++) {
+    auto *page = read_ahead_(page_id, request.strategy_.get());
+    if (page == nullptr) {
+      // Every frame is pinned, and pages further ahead would not fit either, or the chain led to a deallocated page.
+      return;
+    }
+
+    auto next_page_id = page_id + 1;
+    if (request.next_page_ != nullptr) {
+      page->RLatch();
+      next_page_id = request.next_page_(page);
+      page->RUnlatch();
+    }
+    bpm_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.cpp
+//
+// Identification: src/buffer/two_q_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_q_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+TwoQReplacer::TwoQReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      a1in_size_(std::max<size_t>(num_frames / 4, 1)),
+      a1out_size_(std::max<size_t>(num_frames / 2, 1)),
+      frames_(num_frames) {}
+
+auto TwoQReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  if (curr_size_ == 0) {
+    return false;
+  }
+
+  // Reclaim from A1in while it is over its share, from Am otherwise. If every frame of that queue is pinned, fall
+  // back to the other one.
+  const bool prefer_a1in = a1in_.size() > a1in_size_;
+  auto victim = FindVictim(prefer_a1in ? a1in_ : am_);
+  if (victim == INVALID_FRAME_ID) {
+    victim = FindVictim(prefer_a1in ? am_ : a1in_);
+  }
+  BUSTUB_ASSERT(victim != INVALID_FRAME_ID, "curr_size_ counts an evictable frame that is in neither queue");
+
+  // Only pages leaving A1in are remembered; a page leaving Am had its chance.
+  last_victim_ = {victim, frames_[victim].page_id_, frames_[victim].queue_, INVALID_PAGE_ID};
+  if (frames_[victim].queue_ == QueueType::A1IN) {
+    const auto page_id = frames_[victim].page_id_;
+    a1out_.push_front(page_id);
+    a1out_map_[page_id] = a1out_.begin();
+    if (a1out_.size() > a1out_size_) {
+      last_victim_.dropped_page_id_ = a1out_.back();
+      a1out_map_.erase(a1out_.back());
+      a1out_.pop_back();
+    }
+  }
+
+  Untrack(victim);
+  *frame_id = victim;
+  return true;
+}
+
+void TwoQReplacer::Restore(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  auto &entry = frames_[frame_id];
+  if (last_victim_.frame_id_ != frame_id || entry.queue_ != QueueType::NONE) {
+    return;
+  }
+
+  // Undo the A1out update, bringing back the oldest page it pushed out, and put the frame back at the tail of its
+  // queue: it was the evictable frame closest to the tail there.
+  if (auto it = a1out_map_.find(last_victim_.page_id_); it != a1out_map_.end()) {
+    a1out_.erase(it->second);
+    a1out_map_.erase(it);
+    const auto dropped_page_id = last_victim_.dropped_page_id_;
+    if (dropped_page_id != INVALID_PAGE_ID && a1out_map_.count(dropped_page_id) == 0) {
+      a1out_.push_back(dropped_page_id);
+      a1out_map_[dropped_page_id] = std::prev(a1out_.end());
+    }
+  }
+  auto &queue = last_victim_.queue_ == QueueType::A1IN ? a1in_ : am_;
+  queue.push_back(frame_id);
+  entry.page_id_ = last_victim_.page_id_;
+  entry.queue_ = last_victim_.queue_;
+  entry.is_evictable_ = true;
+  entry.pos_ = std::prev(queue.end());
+  curr_size_++;
+  last_victim_ = Victim();
+}
+
+void TwoQReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  auto &entry = frames_[frame_id];
+  if (entry.queue_ != QueueType::NONE) {
+    if (entry.page_id_ == page_id) {
+      // A hit in Am refreshes the page. A hit in A1in does nothing: correlated references right after the first one
+      // say nothing about whether the page is hot.
+      if (entry.queue_ == QueueType::AM) {
+        am_.splice(am_.begin(), am_, entry.pos_);
+      }
+      return;
+    }
+    // The frame was reused for another page without going through Evict or Remove.
+    Untrack(frame_id);
+  }
+
+  if (auto it = a1out_map_.find(page_id); it != a1out_map_.end()) {
+    a1out_.erase(it->second);
+    a1out_map_.erase(it);
+    am_.push_front(frame_id);
+    entry.queue_ = QueueType::AM;
+    entry.pos_ = am_.begin();
+  } else {
+    a1in_.push_front(frame_id);
+    entry.queue_ = QueueType::A1IN;
+    entry.pos_ = a1in_.begin();
+  }
+  entry.page_id_ = page_id;
+  entry.is_evictable_ = false;
+}
+
+void TwoQReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  auto &entry = frames_[frame_id];
+  if (entry.queue_ == QueueType::NONE || entry.is_evictable_ == set_evictable) {
+    return;
+  }
+
+  entry.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void TwoQReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "frame id is out of range");
+
+  if (frames_[frame_id].queue_ == QueueType::NONE) {
+    return;
+  }
+  if (!frames_[frame_id].is_evictable_) {
+    throw std::exception();
+  }
+
+  Untrack(frame_id);
+}
+
+auto TwoQReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+auto TwoQReplacer::PeekVictims(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  std::vector<frame_id_t> victims;
+  const bool prefer_a1in = a1in_.size() > a1in_size_;
+  CollectVictims(prefer_a1in ? a1in_ : am_, max_frames, &victims);
+  CollectVictims(prefer_a1in ? am_ : a1in_, max_frames, &victims);
+  return victims;
+}
+
+void TwoQReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t frame = num_frames; frame < replacer_size_; frame++) {
+    BUSTUB_ASSERT(frames_[frame].queue_ == QueueType::NONE, "a frame beyond the new size is still tracked");
+  }
+
+  frames_.resize(num_frames);
+  replacer_size_ = num_frames;
+  a1in_size_ = std::max<size_t>(num_frames / 4, 1);
+  a1out_size_ = std::max<size_t>(num_frames / 2, 1);
+  while (a1out_.size() > a1out_size_) {
+    a1out_map_.erase(a1out_.back());
+    a1out_.pop_back();
+  }
+}
+
+auto TwoQReplacer::FindVictim(const std::list<frame_id_t> &queue) const -> frame_id_t {
+  for (auto it = queue.rbegin(); it != queue.rend(); it++) {
+    if (frames_[*it].is_evictable_) {
+      return *it;
+    }
+  }
+  return INVALID_FRAME_ID;
+}
+
+void TwoQReplacer::CollectVictims(const std::list<frame_id_t> &queue, size_t max_frames,
+                                  std::vector<frame_id_t> *victims) const {
+  for (auto it = queue.rbegin(); it != queue.rend() && victims->size() < max_frames; it++) {
+    if (frames_[*it].is_evictable_) {
+      victims->push_back(*it);
+    }
+  }
+}
+
+void TwoQReplacer::Untrack(frame_id_t frame_id) {
+  auto &entry = frames_[frame_id];
+  (entry.queue_ == QueueType::A1IN ? a1in_ : am_).erase(entry.pos_);
+  if (entry.is_evictable_) {
+    curr_size_--;
+  }
+  entry = FrameEntry();
+}
+
+}  // namespace bustub
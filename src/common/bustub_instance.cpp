@@ -2,6 +2,8 @@
 #include <shared_mutex>
 #include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "binder/binder.h"
 #include "binder/bound_expression.h"
@@ -17,6 +19,7 @@
 #include "common/bustub_instance.h"
 #include "common/enums/statement_type.h"
 #include "common/exception.h"
+#include "common/logger.h"
 #include "common/util/string_util.h"
 #include "concurrency/lock_manager.h"
 #include "concurrency/transaction.h"
@@ -32,7 +35,11 @@
 #include "recovery/checkpoint_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
 #include "storage/disk/disk_manager_memory.h"
+#ifdef __linux__
+#include "storage/disk/disk_manager_uring.h"
+#endif
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -45,7 +52,18 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  if (enable_page_compression) {
+    disk_manager_ = new DiskManagerCompressed(db_file_name, database_page_size);
+  } else {
+#ifdef __linux__
+    disk_manager_ = new DiskManagerUring(db_file_name, DiskManagerUring::DEFAULT_QUEUE_DEPTH, database_page_size);
+#else
+    disk_manager_ = new DiskManager(db_file_name, database_page_size);
+#endif
+  }
+  if (enable_direct_io && !disk_manager_->EnableDirectIO()) {
+    LOG_WARN("direct I/O is not supported for %s, pages go through the page cache", db_file_name.c_str());
+  }
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
@@ -53,7 +71,8 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    buffer_pool_manager_ =
+        new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_, replacer_policy);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -71,13 +90,18 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  // Warm up the buffer pool with the pages that were hot when the database was last shut down or checkpointed.
+  if (buffer_pool_manager_ != nullptr) {
+    buffer_pool_manager_->PreloadHotPages();
+  }
 }
 
 BustubInstance::BustubInstance() {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManagerUnlimitedMemory();
+  disk_manager_ = new DiskManagerUnlimitedMemory(database_page_size);
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
@@ -85,7 +109,8 @@ BustubInstance::BustubInstance() {
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    buffer_pool_manager_ =
+        new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_, replacer_policy);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -146,6 +171,46 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayBufferPoolStats(ResultWriter &writer) {
+  const auto stats = buffer_pool_manager_->GetStats();
+  const auto &read_latency = disk_manager_->GetReadLatency();
+  const auto &write_latency = disk_manager_->GetWriteLatency();
+  const auto hit_rate = stats.hits_ + stats.misses_ == 0 ? 0.0 : 100.0 * stats.hits_ / (stats.hits_ + stats.misses_);
+  const auto us = [](uint64_t ns) { return fmt::format("{:.1f}", ns / 1000.0); };
+  const std::vector<std::pair<std::string, std::string>> rows = {
+      {"pool_size", fmt::format("{}", buffer_pool_manager_->GetPoolSize())},
+      {"hits", fmt::format("{}", stats.hits_)},
+      {"misses", fmt::format("{}", stats.misses_)},
+      {"hit_rate_%", fmt::format("{:.1f}", hit_rate)},
+      {"evictions", fmt::format("{}", stats.evictions_)},
+      {"dirty_evictions", fmt::format("{}", stats.dirty_evictions_)},
+      {stats.num_instances_ > 1 ? "pinned_high_water_per_instance" : "pinned_high_water",
+       fmt::format("{}", stats.pinned_high_water_)},
+      {"latch_waits", fmt::format("{}", stats.latch_waits_)},
+      {"latch_wait_us", us(stats.latch_wait_ns_)},
+      {"disk_reads", fmt::format("{}", disk_manager_->GetNumReads())},
+      {"disk_read_mean_us", us(read_latency.MeanNs())},
+      {"disk_read_p50_us", us(read_latency.PercentileNs(50))},
+      {"disk_read_p99_us", us(read_latency.PercentileNs(99))},
+      {"disk_writes", fmt::format("{}", disk_manager_->GetNumWrites())},
+      {"disk_write_mean_us", us(write_latency.MeanNs())},
+      {"disk_write_p50_us", us(write_latency.PercentileNs(50))},
+      {"disk_write_p99_us", us(write_latency.PercentileNs(99))},
+  };
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("metric");
+  writer.WriteHeaderCell("value");
+  writer.EndHeader();
+  for (const auto &[metric, value] : rows) {
+    writer.BeginRow();
+    writer.WriteCell(metric);
+    writer.WriteCell(value);
+    writer.EndRow();
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -159,6 +224,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\bpstats: show buffer pool and disk I/O statistics
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -191,6 +257,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\bpstats") {
+      CmdDisplayBufferPoolStats(writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
@@ -395,6 +465,9 @@ BustubInstance::~BustubInstance() {
   delete catalog_;
   delete checkpoint_manager_;
   delete log_manager_;
+  if (buffer_pool_manager_ != nullptr) {
+    buffer_pool_manager_->SaveHotPages();
+  }
   delete buffer_pool_manager_;
   delete lock_manager_;
   delete txn_manager_;
@@ -20,4 +20,20 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::chrono::milliseconds page_cleaner_interval = std::chrono::milliseconds(10);
+
+ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K;
+
+int database_page_size = BUSTUB_PAGE_SIZE;
+
+bool enable_page_compression = false;
+
+bool enable_huge_page_frames = true;
+
+bool enable_direct_io = false;
+
+double index_fill_factor = 0.9;
+
+size_t index_build_memory = 64 << 20;
+
 }  // namespace bustub
@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/frame_replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ARCReplacer implements Adaptive Replacement Cache (Megiddo and Modha, FAST '03).
+ *
+ * Resident pages live in two LRU lists: T1 holds pages seen once recently, T2 pages seen at least twice. Each has a
+ * ghost list (B1, B2) remembering the ids of pages recently evicted from it. A miss on a page in B1 means T1 was too
+ * small and grows the target size of T1; a miss in B2 shrinks it. A scan only ever touches T1 and B1, so it cannot
+ * push the frequently used pages out of T2.
+ *
+ * Pinned frames stay in their list and are skipped by Evict. Since pinning a frame is an access, they sit near the
+ * MRU end, away from where Evict starts looking.
+ */
+class ARCReplacer : public FrameReplacer {
+ public:
+  /**
+   * @brief Create a new ARCReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to track
+   */
+  explicit ARCReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ARCReplacer);
+
+  ~ARCReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void Restore(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto PeekVictims(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  /** @brief Resize the cache. Shrinking caps the target size of T1 and forgets the oldest ghosts that no longer fit. */
+  void Resize(size_t num_frames) override;
+
+ private:
+  static constexpr frame_id_t INVALID_FRAME_ID = -1;
+
+  enum class ListType { NONE, T1, T2 };
+
+  struct FrameEntry {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    ListType list_{ListType::NONE};
+    bool is_evictable_{false};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** The frame Evict returned last, with the page it held and the list it came from */
+  struct Victim {
+    frame_id_t frame_id_{INVALID_FRAME_ID};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    ListType list_{ListType::NONE};
+  };
+
+  using GhostList = std::list<page_id_t>;
+  using GhostMap = std::unordered_map<page_id_t, GhostList::iterator>;
+
+  /** @brief Find the evictable frame closest to the LRU end of a list, or INVALID_FRAME_ID if there is none. */
+  auto FindVictim(const std::list<frame_id_t> &list) const -> frame_id_t;
+
+  /** @brief Append the evictable frames of a list to victims, LRU end first, until it holds max_frames frames. */
+  void CollectVictims(const std::list<frame_id_t> &list, size_t max_frames, std::vector<frame_id_t> *victims) const;
+
+  /** @brief Stop tracking a frame without remembering its page. */
+  void Untrack(frame_id_t frame_id);
+
+  /** @brief Drop the least recently evicted page of a ghost list. */
+  static void PopGhost(GhostList *list, GhostMap *map);
+
+  size_t curr_size_{0};
+  size_t replacer_size_;
+  /** Adaptive target size of T1 */
+  size_t target_t1_size_{0};
+  std::mutex latch_;
+
+  std::vector<FrameEntry> frames_;
+  /** Resident frames, most recently used at the front */
+  std::list<frame_id_t> t1_;
+  std::list<frame_id_t> t2_;
+  /** Pages recently evicted from T1 and T2, most recently evicted at the front */
+  GhostList b1_;
+  GhostList b2_;
+  GhostMap b1_map_;
+  GhostMap b2_map_;
+  Victim last_victim_;
+};
+
+}  // namespace bustub
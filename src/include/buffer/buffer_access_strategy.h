@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * BufferAccessStrategy lets a large sequential scan read through a small private ring of frames instead of the whole
+ * buffer pool, like the BAS_BULKREAD strategy of Postgres.
+ *
+ * The ring remembers the last pages the scan read into the pool. On a miss, the buffer pool first tries to reuse the
+ * frame of the page in the next ring slot. That only works if the page is still resident and unpinned; otherwise a
+ * frame is taken from the pool as usual and the slot is taken over by the new page. Either way, the scan can displace
+ * at most ring-size pages that it did not read itself.
+ *
+ * A strategy belongs to a single scan. The scan and the buffer pool reading pages ahead for it may use it concurrently.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * @brief Create a ring of ring_size slots.
+   * @param ring_size the number of frames the scan may cycle through
+   */
+  explicit BufferAccessStrategy(size_t ring_size) : ring_(ring_size, INVALID_PAGE_ID) {
+    BUSTUB_ASSERT(ring_size > 0, "ring must have at least one slot");
+  }
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /**
+   * @brief Create a bulk-read strategy for a scan over num_pages pages, if the scan is large enough to need one.
+   * @param pool_size the number of frames in the buffer pool
+   * @param num_pages the number of pages the scan will read
+   * @return the strategy, or nullptr if the scan reads no more than a quarter of the pool
+   */
+  static auto MakeBulkRead(size_t pool_size, size_t num_pages) -> std::shared_ptr<BufferAccessStrategy> {
+    if (num_pages <= pool_size / 4) {
+      return nullptr;
+    }
+    return std::make_shared<BufferAccessStrategy>(BulkReadRingSize(pool_size));
+  }
+
+  /** @return the ring size of a bulk-read scan: an eighth of the pool, capped at BULKREAD_RING_SIZE frames */
+  static auto BulkReadRingSize(size_t pool_size) -> size_t {
+    return std::clamp<size_t>(pool_size / 8, 2, BULKREAD_RING_SIZE);
+  }
+
+  /** @return the number of slots in the ring */
+  auto GetRingSize() const -> size_t { return ring_.size(); }
+
+  /**
+   * @brief Move on to the next slot of the ring.
+   * @param[out] slot the slot to pass to SetPage once the new page is read in
+   * @return the page last read into that slot, or INVALID_PAGE_ID if the slot is still empty
+   */
+  auto NextVictim(size_t *slot) -> page_id_t {
+    std::scoped_lock<std::mutex> lock(latch_);
+    current_ = (current_ + 1) % ring_.size();
+    *slot = current_;
+    return ring_[current_];
+  }
+
+  /**
+   * @brief Record that page_id has been read into a slot.
+   * @param slot the slot returned by NextVictim
+   * @param page_id the page now occupying the slot
+   */
+  void SetPage(size_t slot, page_id_t page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    ring_[slot] = page_id;
+  }
+
+ private:
+  /** The pages the scan read most recently, one per slot */
+  std::vector<page_id_t> ring_;
+  /** The slot used by the last miss */
+  size_t current_{0};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -12,17 +12,42 @@
 
 #pragma once
 
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <utility>
 
+#include "buffer/buffer_access_strategy.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_extent.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
+/** Counters of a buffer pool since it was created, see BufferPoolManager::GetStats */
+struct BufferPoolStats {
+  /** Fetches that found their page resident */
+  uint64_t hits_{0};
+  /** Fetches that had to read their page from disk */
+  uint64_t misses_{0};
+  /** Frames taken from a resident page to hold another one */
+  uint64_t evictions_{0};
+  /** Evictions that had to write their dirty page back first */
+  uint64_t dirty_evictions_{0};
+  /** The most frames that were pinned at once, in any one instance if there are several */
+  uint64_t pinned_high_water_{0};
+  /** How many buffer pool instances the counters cover */
+  uint64_t num_instances_{1};
+  /** How many times a thread had to wait for the buffer pool latch */
+  uint64_t latch_waits_{0};
+  /** Total time threads spent waiting for the buffer pool latch */
+  uint64_t latch_wait_ns_{0};
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -30,6 +55,8 @@ class BufferPoolManager {
  public:
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
+  /** Reads the id of the page that follows a page, e.g. its sibling link, or INVALID_PAGE_ID at the end. */
+  using next_page_fn = std::function<page_id_t(Page *page)>;
 
   BufferPoolManager() = default;
   /**
@@ -45,6 +72,25 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch the requested page. On a miss, the frame is picked according to the access strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr to use the whole buffer pool
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgImp(page_id, strategy);
+  }
+
+  /**
+   * Pin the requested page for an optimistic read, which checks what it read against the page version. The pin is not
+   * an access, so neither the replacer nor the hit statistics see it. The page id may come from a page that changed
+   * while it was read, so a page that is no longer allocated is not read in.
+   * @param page_id id of page to be pinned
+   * @return nullptr if page_id cannot be fetched or is not allocated, otherwise pointer to the pinned page
+   */
+  auto PinPage(page_id_t page_id) -> Page * { return PinPgImp(page_id); }
+
   /** Grading function. Do not modify! */
   auto UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -69,6 +115,14 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Creates a new page in the buffer pool, taking its id from the extent of the table or index it belongs to.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller, or nullptr to allocate the page anywhere
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPageInExtent(page_id_t *page_id, PageExtent *extent) -> Page * { return NewPgImp(page_id, extent); }
+
   /** Grading function. Do not modify! */
   auto DeletePage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -84,9 +138,55 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Start reading a page into the buffer pool in the background, so that a later FetchPage finds it resident.
+   * @param page_id id of the page to read
+   */
+  void PrefetchPage(page_id_t page_id) { PrefetchPgImp(page_id, 1, nullptr, nullptr); }
+
+  /**
+   * Start reading a run of pages into the buffer pool in the background. Without next_page the pages have consecutive
+   * ids, which must all exist; with it, the id of each following page is read from the previous one once that one is
+   * in memory. Prefetching is only a hint, and requests may be dropped when the buffer pool is busy.
+   * @param first_page_id id of the first page to read
+   * @param num_pages the number of pages to read
+   * @param next_page how to find the next page, or nullptr for consecutive page ids
+   * @param strategy the access strategy of the scan the pages are read for, or nullptr
+   */
+  void PrefetchRange(page_id_t first_page_id, size_t num_pages, next_page_fn next_page = nullptr,
+                     std::shared_ptr<BufferAccessStrategy> strategy = nullptr) {
+    PrefetchPgImp(first_page_id, num_pages, std::move(next_page), std::move(strategy));
+  }
+
+  /**
+   * Record which pages are resident, hottest first, in a file next to the database file (foo.db has foo.hot), so that
+   * PreloadHotPages can bring them back after a restart. Buffer pools without a database file ignore the request.
+   */
+  void SaveHotPages() { SaveHotPgsImp(); }
+
+  /**
+   * Read the pages recorded by the last SaveHotPages into the free frames of the buffer pool, the hottest ones if not
+   * all of them fit. Call it at startup, before the buffer pool is in use.
+   * @return the number of pages read
+   */
+  auto PreloadHotPages() -> size_t { return PreloadHotPgsImp(); }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /**
+   * Change the number of frames of the buffer pool while it is in use. A shrink may finish in the background.
+   * @param pool_size the new number of frames
+   * @return false if the buffer pool can't be resized to pool_size
+   */
+  virtual auto Resize(size_t pool_size) -> bool { return false; }
+
+  /** @return size of a page in bytes, which is the page size of the database file */
+  virtual auto GetPageSize() -> int = 0;
+
+  /** @return the counters of the buffer pool; all zero for buffer pools that do not keep them */
+  virtual auto GetStats() -> BufferPoolStats { return {}; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -108,6 +208,42 @@ class BufferPoolManager {
    */
   virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
 
+  /**
+   * Fetch the requested page from the buffer pool, picking the frame for a miss according to the access strategy.
+   * Buffer pools that do not support access strategies ignore it.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr
+   * @return the requested page
+   */
+  virtual auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * { return FetchPgImp(page_id); }
+
+  /**
+   * Pin the requested page for an optimistic read, without it counting as an access. Buffer pools that do not tell the
+   * two apart fetch the page.
+   * @param page_id id of page to be pinned
+   * @return nullptr if page_id cannot be fetched or is not allocated, otherwise pointer to the pinned page
+   */
+  virtual auto PinPgImp(page_id_t page_id) -> Page * { return FetchPgImp(page_id); }
+
+  /**
+   * Start reading pages into the buffer pool in the background. Buffer pools that do not prefetch ignore the request.
+   * @param first_page_id id of the first page to read
+   * @param num_pages the number of pages to read
+   * @param next_page how to find the next page, or nullptr for consecutive page ids
+   * @param strategy the access strategy of the scan the pages are read for, or nullptr
+   */
+  virtual void PrefetchPgImp(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                             std::shared_ptr<BufferAccessStrategy> strategy) {}
+
+  /** Record the resident pages, hottest first. Buffer pools that do not rank their pages ignore the request. */
+  virtual void SaveHotPgsImp() {}
+
+  /**
+   * Read the pages recorded by SaveHotPgsImp. Buffer pools that do not rank their pages ignore the request.
+   * @return the number of pages read
+   */
+  virtual auto PreloadHotPgsImp() -> size_t { return 0; }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -130,6 +266,15 @@ class BufferPoolManager {
    */
   virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
 
+  /**
+   * Creates a new page in the buffer pool, allocated from an extent. Buffer pools that do not support extents ignore
+   * the extent.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller, or nullptr
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgImp(page_id_t *page_id, PageExtent *extent) -> Page * { return NewPgImp(page_id); }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
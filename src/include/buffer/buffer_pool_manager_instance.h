@@ -12,12 +12,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <limits>
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_k_replacer.h"
+#include "buffer/frame_arena.h"
+#include "buffer/frame_replacer.h"
+#include "buffer/prefetcher.h"
 #include "common/config.h"
 #include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
@@ -37,21 +47,172 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_policy the page replacement policy
+   * @param max_pool_size the size Resize may grow the pool to, or 0 for pool_size
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K,
+                            size_t max_pool_size = 0);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_policy the page replacement policy
+   * @param max_pool_size the size Resize may grow the pool to, or 0 for pool_size
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K,
+                            size_t max_pool_size = 0);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
    */
   ~BufferPoolManagerInstance() override;
 
-  /** @brief Return the size (number of frames) of the buffer pool. */
+  /** @brief Return the size (number of frames) of the buffer pool, the size it is shrinking to during a shrink. */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
+  /**
+   * @brief Grow or shrink the buffer pool while it is in use. Growing adds free frames right away. Shrinking takes the
+   * free frames beyond the new size out of use right away, and leaves the others to a background thread, which evicts
+   * their pages one at a time as they become unpinned, so that queries keep running. Until then, misses that evict a
+   * page from one of those frames retire it too.
+   * @param pool_size the new number of frames, at least 1 and at most the maximum pool size
+   * @return false if the size is out of range
+   */
+  auto Resize(size_t pool_size) -> bool override;
+
+  /** @return true while frames beyond the pool size are waiting to be retired */
+  auto IsShrinking() const -> bool { return shrinking_; }
+
+  /** @return the size the pool can grow to */
+  auto GetMaxPoolSize() const -> size_t { return max_pool_size_; }
+
+  /** @brief Return the page size of the buffer pool. */
+  auto GetPageSize() -> int override { return page_size_; }
+
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * @brief Start the page cleaner, a background thread that writes dirty pages back before they are evicted, so that a
+   * miss rarely has to write a dirty victim while holding the latch. Every page_cleaner_interval, or sooner after a
+   * miss had to write, it cleans the dirty pages among the num_clean_frames frames the replacer would evict next.
+   * Does nothing if the cleaner is already running.
+   * @param num_clean_frames how many frames at the cold end of the replacer to keep clean
+   */
+  void RunPageCleaner(size_t num_clean_frames);
+
+  /** @brief Stop and join the page cleaner, if it is running. */
+  void StopPageCleaner();
+
+  /**
+   * @brief Bring a page into the buffer pool for a fetch that is expected soon, and pin it. Unlike FetchPage, this does
+   * not count as an access to the page: the replacer sees the page's first access when it is read in, and the first
+   * FetchPage afterwards only claims that access. Prefetchers use this to read pages ahead.
+   * @param page_id id of page to be read
+   * @param strategy the access strategy of the scan the page is read for, or nullptr
+   * @return nullptr if page_id cannot be read in or is not allocated, otherwise pointer to the pinned page
+   */
+  auto ReadAheadPage(page_id_t page_id, BufferAccessStrategy *strategy) -> Page *;
+
+  /**
+   * @brief Create a new page with an id reserved on disk by DiskManager::ReserveExtent, which this instance owns.
+   * @param page_id id of the reserved page
+   * @return nullptr if there is no frame for the page, otherwise pointer to the new page, pinned
+   */
+  auto NewReservedPage(page_id_t page_id) -> Page *;
+
+  /**
+   * @brief Bring a batch of pages into the buffer pool like ReadAheadPage, but issue all their reads before waiting for
+   * any, so that an asynchronous disk manager can run them at once. The latch is only held to claim the frames and to
+   * install each page once its read completes. The pages are left unpinned. Stops early when there is no frame left.
+   * @param page_ids ids of the pages to be read, without duplicates
+   * @param strategy the access strategy of the scan the pages are read for, or nullptr
+   */
+  void ReadAheadPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy);
+
+  /** A dirty page pinned to be flushed, and a copy of it to write, see PinDirtyPages */
+  struct DirtyPage {
+    page_id_t page_id_;
+    frame_id_t frame_id_;
+    std::shared_ptr<char[]> data_;
+  };
+
+  /**
+   * @brief Pin every dirty page in the buffer pool, mark it clean and copy it under its read latch, so that it can be
+   * written without holding any latch and without a writer tearing it. A page dirtied again after it was copied stays
+   * dirty, and is written again by a later flush.
+   * @return the pinned pages, which the caller must release with UnpinDirtyPages once they are written
+   */
+  auto PinDirtyPages() -> std::vector<DirtyPage>;
+
+  /** @brief Release the pins taken by PinDirtyPages. */
+  void UnpinDirtyPages(const std::vector<DirtyPage> &pages);
+
+  /**
+   * @brief Write a set of pages in page id order, merging pages with consecutive ids into one vectored write each, and
+   * wait for all the writes. Does not sync.
+   * @param disk_manager the disk manager to write with
+   * @param[in,out] pages the pages to write, sorted by page id on return
+   */
+  static void WriteCoalesced(DiskManager *disk_manager, std::vector<DirtyPage> *pages);
+
+  /**
+   * @brief List the pages resident in the buffer pool, hottest first: the pinned pages, then the unpinned ones in the
+   * reverse of the order the replacer would evict them.
+   * @return the ids of the resident pages
+   */
+  auto GetHotPages() -> std::vector<page_id_t>;
+
+  /**
+   * @brief Read pages into the free frames of the buffer pool, leaving them unpinned like ReadAheadPages. If not all of
+   * them fit, the first ones are read. The reads are issued in page id order as one batch, and the pages are handed to
+   * the replacer coldest first, so that it ranks them in the order given. Pages that are resident, owned by another
+   * instance or no longer allocated are skipped.
+   * @param page_ids ids of the pages to be read, hottest first
+   * @return the number of pages read
+   */
+  auto PreloadPages(const std::vector<page_id_t> &page_ids) -> size_t;
+
+  /**
+   * @param disk_manager the disk manager of the buffer pool
+   * @return the name of the file that records the hot pages of the database, empty if there is no database file
+   */
+  static auto HotPageFileName(DiskManager *disk_manager) -> std::string;
+
+  /**
+   * @brief Write a list of page ids to a hot page file, replacing it atomically.
+   * @param file_name the name of the file
+   * @param page_ids the page ids, hottest first
+   */
+  static void WriteHotPageFile(const std::string &file_name, const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Read the list of page ids in a hot page file.
+   * @param file_name the name of the file
+   * @return the page ids, hottest first; none if the file does not exist or is corrupt
+   */
+  static auto ReadHotPageFile(const std::string &file_name) -> std::vector<page_id_t>;
+
+  /** @return the number of dirty victims written back by misses and new pages */
+  auto GetForegroundWrites() const -> uint64_t { return foreground_writes_; }
+
+  /** @return the number of dirty pages written back ahead of eviction by the page cleaner */
+  auto GetBackgroundWrites() const -> uint64_t { return background_writes_; }
+
+  /** @return the counters of the buffer pool; the dirty evictions are the foreground writes */
+  auto GetStats() -> BufferPoolStats override;
+
+  /** @return the number of frames pinned right now */
+  auto GetNumPinnedFrames() const -> size_t { return num_pinned_frames_; }
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -72,6 +233,16 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
+  /**
+   * @brief Create a new page with the next id of an extent, reserving a new run of pages on disk when the extent is
+   * used up. An instance that is part of a parallel buffer pool leaves extents to the parallel buffer pool, and
+   * allocates the page like NewPgImp(page_id).
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller, or nullptr
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id, PageExtent *extent) -> Page * override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -90,6 +261,34 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * @brief Fetch the requested page from the buffer pool. On a miss, try to recycle the frame of the page in the
+   * strategy's next ring slot before picking a frame from the free list or the replacer.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Pin the requested page for an optimistic read. A hit records no access and counts no hit. A miss reads the
+   * page in only if it is still allocated; pages are deallocated under the latch, so a stale id is never read into a
+   * frame that a later NewPage of the same id would duplicate.
+   * @param page_id id of page to be pinned
+   * @return nullptr if page_id cannot be fetched or is not allocated, otherwise pointer to the pinned page
+   */
+  auto PinPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Queue pages to be read ahead by the background prefetcher of this instance.
+   * @param first_page_id id of the first page to read
+   * @param num_pages the number of pages to read
+   * @param next_page how to find the next page, or nullptr for consecutive page ids
+   * @param strategy the access strategy of the scan the pages are read for, or nullptr
+   */
+  void PrefetchPgImp(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                     std::shared_ptr<BufferAccessStrategy> strategy) override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -121,19 +320,29 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Flush all the pages in the buffer pool to disk.
+   * @brief Flush all the dirty pages in the buffer pool to disk, coalescing pages with consecutive ids into vectored
+   * writes, then sync the disk once.
    */
   void FlushAllPgsImp() override;
 
+  /** @brief Write the ids of the resident pages, as listed by GetHotPages, to the hot page file of the database. */
+  void SaveHotPgsImp() override;
+
+  /**
+   * @brief Preload the pages listed in the hot page file of the database.
+   * @return the number of pages read
+   */
+  auto PreloadHotPgsImp() -> size_t override;
+
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * @brief Delete a page from the buffer pool and free it on disk. If page_id is not in the buffer pool, only free it
+   * on disk and return true. If the page is pinned and cannot be deleted, return false immediately.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
-   * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
-   * imitate freeing the page on the disk.
+   * back to the free list. Also, reset the page's memory and metadata. Finally, call DeallocatePage() so that the
+   * page can be allocated again.
    *
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
@@ -141,40 +350,299 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
   /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
-  /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
+  std::atomic<size_t> pool_size_;
+  /** Number of frames that may hold a page: pool_size_, plus the frames beyond it that are still being retired */
+  std::atomic<size_t> num_frames_;
+  /** Number of frames whose descriptors have been constructed. Only grows, so stale pins never touch a dead Page. */
+  size_t num_constructed_frames_{0};
+  /** The most frames the pool can grow to; pages_, the frame arena and the per-frame arrays are sized for it */
+  const size_t max_pool_size_;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
+  /** Identifies a hot page file */
+  static constexpr uint32_t HOT_PAGE_FILE_MAGIC = 0x544f4831;
   /** Bucket size for the extendible hash table */
   const size_t bucket_size_ = 4;
+  /** Size of a page in bytes, the page size of the database file. */
+  const int page_size_;
 
-  /** Array of buffer pool pages. */
+  /** Array of buffer pool pages, the descriptors of the frames. */
   Page *pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
+  /** Data of the buffer pool pages, page_size_ bytes per frame, aligned for direct I/O. */
+  FrameArena frame_data_;
   /** Page table for keeping track of buffer pool pages. */
   ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
   /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  std::unique_ptr<FrameReplacer> replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch serializes everything that changes which page lives in which frame: misses, new pages, deletions and
+   * flushes, together with the free list and page table updates they make, and every access handed to the replacer.
+   * Hits and unpins take neither it nor the replacer's latch; they pin and unpin frames with atomic operations on
+   * Page::pin_count_, stamp their accesses in access_stamps_ and only read the page table.
+   */
   std::mutex latch_;
+  /**
+   * One latch per frame, serializing the updates of the frame's evictable flag in the replacer. Unpins that race with
+   * AcquireFrame on a frame would otherwise reach the replacer in a different order than they changed the pin count.
+   */
+  std::vector<std::mutex> evictable_latches_;
+  /**
+   * The pages ReadAheadPages is reading in without the latch, into frames it has claimed. Until their reads complete
+   * they are in neither the page table nor the replacer, so misses and deletions of them wait on reads_done_cv_, and so
+   * do misses and new pages that find no frame but those. Protected by latch_.
+   */
+  std::unordered_set<page_id_t> reads_in_flight_;
+  /** Signalled when a page read ahead by ReadAheadPages has been installed */
+  std::condition_variable reads_done_cv_;
+  /**
+   * When each frame was last hit, in steady clock ticks, or 0 if the replacer has heard of all its hits. A hit only
+   * stores the time, and the replacer is told of the hits oldest first when it next has to pick or list victims.
+   */
+  std::vector<std::atomic<uint64_t>> access_stamps_;
+  /** Set by hits that stamp a frame, so that misses only look at the stamps when there is something to hand over */
+  std::atomic<bool> accesses_pending_{false};
+  /**
+   * Whether the replacer has been told that each frame is not evictable. Pins and unpins leave the replacer alone, so
+   * it takes every frame holding a page for evictable, until AcquireFrame finds one of its victims pinned and tells it
+   * otherwise. The unpin that releases such a frame then makes it evictable again.
+   */
+  std::vector<std::atomic<bool>> unevictable_;
+
+  /**
+   * Whether each frame holds a page that was read ahead and has not been fetched since. Its access was recorded when
+   * it was read in, so the first fetch must not record another one: pages that are scanned once would otherwise look
+   * like they were used twice.
+   */
+  std::vector<std::atomic<bool>> read_ahead_;
+  /** Reads pages ahead in the background */
+  Prefetcher prefetcher_;
+
+  /** Dirty victims written back by misses and new pages */
+  std::atomic<uint64_t> foreground_writes_{0};
+  /** Dirty pages written back by the page cleaner */
+  std::atomic<uint64_t> background_writes_{0};
+
+  /** Fetches that found their page resident; pages read ahead are not fetches */
+  std::atomic<uint64_t> hits_{0};
+  /** Fetches that read their page from disk */
+  std::atomic<uint64_t> misses_{0};
+  /** Frames taken from a resident page by the replacer or an access strategy ring */
+  std::atomic<uint64_t> evictions_{0};
+  /** Frames whose pin count is above zero */
+  std::atomic<size_t> num_pinned_frames_{0};
+  /** The most frames that were pinned at once */
+  std::atomic<size_t> pinned_high_water_{0};
+  /** Acquisitions of the latch that found it held, and the time they waited */
+  std::atomic<uint64_t> latch_waits_{0};
+  std::atomic<uint64_t> latch_wait_ns_{0};
+
+  /**
+   * Whether each frame has been retired by a shrink: it is claimed for good, holds no page and its memory has been
+   * given back. Protected by latch_.
+   */
+  std::vector<bool> retired_;
+  /** The thread retiring the frames beyond the pool size after a shrink, if one is or was running */
+  std::thread retirer_;
+  std::atomic<bool> shrinking_{false};
+  std::atomic<bool> stop_retiring_{false};
+  /** Serializes Resize calls */
+  std::mutex resize_latch_;
+
+  /** The page cleaner thread, if running */
+  std::thread page_cleaner_;
+  /** Protects cleaner_running_ and wakes up the page cleaner */
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_cv_;
+  bool cleaner_running_{false};
+
+  /**
+   * Pin count of a frame that the buffer pool manager has claimed for replacement. It is far enough below zero that
+   * optimistic pins racing with the replacement can never lift it back to a valid (non-negative) pin count.
+   */
+  static constexpr int PIN_COUNT_CLAIMED = std::numeric_limits<int>::min() / 2;
+
+  /** What a FetchFrame pin is for */
+  enum class FetchMode {
+    /** A fetch: the pin is an access to the page */
+    ACCESS,
+    /** A read ahead: the page's access is recorded when it is read in, and a page that is not allocated is skipped */
+    READ_AHEAD,
+    /** An optimistic read: the pin is not an access, and a page that is not allocated is not read in */
+    OPTIMISTIC,
+  };
+
+  /**
+   * @brief Pin the page, reading it into a frame on a miss. Implements FetchPgImp, ReadAheadPage and PinPgImp.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr
+   * @param mode what the pin is for
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the pinned page
+   */
+  auto FetchFrame(page_id_t page_id, BufferAccessStrategy *strategy, FetchMode mode) -> Page *;
+
+  /**
+   * @brief Pin the frame if it still holds the given page. This is the lock-free hit path: it bumps the pin count
+   * first, and only then checks that the frame was not claimed for replacement and still holds page_id. An access is
+   * stamped on the frame for ApplyAccesses to hand to the replacer.
+   * @param frame_id the frame the page table mapped page_id to
+   * @param page_id id of the page expected in the frame
+   * @param record_access whether the pin counts as an access for the replacer
+   * @return true if the frame is now pinned and holds page_id, false otherwise (the pin has been undone)
+   */
+  auto TryPinFrame(frame_id_t frame_id, page_id_t page_id, bool record_access = true) -> bool;
+
+  /**
+   * @brief Acquire the latch, timing the wait if it is held by another thread.
+   * @return the held latch
+   */
+  auto LockLatch() -> std::unique_lock<std::mutex>;
+
+  /** @brief Count a frame whose pin count went from zero to one, and raise the high-water mark. */
+  void CountPinnedFrame();
+
+  /**
+   * @brief Drop one pin on a frame. When the last pin goes away from a frame the replacer was told is not evictable,
+   * it is made evictable again.
+   * @param frame_id the frame to unpin
+   */
+  void UnpinFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Make the replacer's evictable flag for the frame agree with its pin count, and record in unevictable_ what
+   * it was told. Safe against concurrent pins and unpins of the same frame. Claimed frames are left alone.
+   * @param frame_id the frame
+   */
+  void SyncEvictable(frame_id_t frame_id);
+
+  /**
+   * @brief Hand the accesses stamped on the frames by hits to the replacer, oldest first. Caller should acquire the
+   * latch before calling this function.
+   */
+  void ApplyAccesses();
+
+  /**
+   * @brief Make the replacer forget a claimed frame that it may still consider evictable or pinned.
+   * @param frame_id the claimed frame
+   */
+  void RemoveClaimedFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Claim an unpinned frame for replacement by swapping its pin count from 0 to PIN_COUNT_CLAIMED.
+   * @param frame_id the frame to claim
+   * @return false if the frame is pinned
+   */
+  auto ClaimFrame(frame_id_t frame_id) -> bool;
+
+  /**
+   * @brief Find a frame for a new page, from the free list first and from the replacer otherwise. The frame is returned
+   * claimed and empty: its old page, if any, has been written back when dirty and removed from the page table.
+   * Caller should acquire the latch before calling this function.
+   * @param[out] frame_id the acquired frame
+   * @return false if every frame is pinned
+   */
+  auto AcquireFrame(frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief AcquireFrame, but while every frame is pinned and some are reading pages ahead, wait for those reads rather
+   * than fail. Caller should acquire the latch in lock before calling this function.
+   * @param lock the caller's hold on the latch, released while waiting
+   * @param[out] frame_id the acquired frame
+   * @return false if every frame is pinned and none is reading a page ahead
+   */
+  auto AwaitFrame(std::unique_lock<std::mutex> *lock, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Recycle the frame of the page in the strategy's next ring slot, if it is still resident and unpinned. The
+   * frame is returned claimed and empty, like AcquireFrame does. Caller should acquire the latch before calling this
+   * function.
+   * @param strategy the access strategy
+   * @param[out] slot the ring slot the new page goes into, whether or not its frame could be recycled
+   * @param[out] frame_id the recycled frame
+   * @return false if the ring slot is empty or its frame cannot be recycled
+   */
+  auto AcquireRingFrame(BufferAccessStrategy *strategy, size_t *slot, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Empty a claimed frame: remove its page from the page table, write it back if dirty and reset the memory.
+   * Caller should acquire the latch before calling this function.
+   * @param frame_id the claimed frame
+   */
+  void ClearFrame(frame_id_t frame_id);
 
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Publish a claimed frame holding page_id: add it to the page table, record the access, and release the
+   * claim leaving the frame pinned once. Caller should acquire the latch before calling this function.
+   * @param frame_id the claimed frame
+   * @param page_id id of the page now held in the frame
+   * @param read_ahead whether the page is read ahead rather than accessed
+   */
+  void InstallFrame(frame_id_t frame_id, page_id_t page_id, bool read_ahead = false);
+
+  /** @return true if the frame is beyond the pool size and waiting to be retired */
+  auto IsRetiring(frame_id_t frame_id) const -> bool { return static_cast<size_t>(frame_id) >= pool_size_; }
+
+  /**
+   * @brief Retire a claimed, empty frame: it stays claimed and its memory is given back. Caller should acquire the
+   * latch before calling this function.
+   * @param frame_id the frame
+   */
+  void RetireClaimedFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Bring a frame into use as a free frame, constructing its descriptor or releasing the claim of a retired
+   * frame. Caller should acquire the latch before calling this function.
+   * @param frame_id the frame
+   */
+  void AddFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Retire the frames beyond the pool size one at a time, evicting their pages and waiting for pinned ones,
+   * then shrink the replacer. Runs on the retirer thread.
+   */
+  void RetireFrames();
+
+  /**
+   * @brief Write the page in the frame to disk, wait until it is durable, and clear its dirty flag. Caller should pin
+   * the frame, and not hold the latch, since the page is read-latched while it is copied.
+   * @param frame_id the frame to flush
+   */
+  void FlushFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Write back the dirty pages among the next num_clean_frames victims of the replacer. Runs without the latch:
+   * each page is pinned, without counting as an access, and read-latched while it is copied. The copies are written as
+   * one batch.
+   * @param num_clean_frames how many frames at the cold end of the replacer to look at
+   */
+  void CleanFrames(size_t num_clean_frames);
+
+  /**
+   * @brief Allocate a page on disk, reusing a deallocated page of this instance if there is one. Caller should acquire
+   * the latch before calling this function.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
+   * validate input data and ensure that a parallel BPM is routing requests to the correct BPI.
+   * @param page_id
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
   /**
    * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   // TODO(student): You may add additional private members and helper functions
 };
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the data of every frame of a buffer pool in one anonymous memory mapping, apart from the Page
+ * objects that describe the frames. Every frame starts on a 4K boundary, as O_DIRECT reads and writes require, since
+ * the frame size is a multiple of 4K.
+ *
+ * The mapping only reserves address space: memory is committed as frames are first touched, so an arena can be sized
+ * for the largest the buffer pool may grow to. Release gives the memory of retired frames back.
+ *
+ * An arena of at least one huge page is aligned to the huge page size and advised to be backed by transparent huge
+ * pages, so that a scan over many frames takes few TLB misses. The kernel may ignore the advice, or THP may be
+ * disabled; the arena then uses ordinary pages.
+ */
+class FrameArena {
+ public:
+  /** Alignment of every frame */
+  static constexpr size_t FRAME_ALIGNMENT = 4096;
+  /** Size of a transparent huge page on x86-64 */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * @brief Map the memory of the frames. The memory is zeroed.
+   * @param num_frames the number of frames
+   * @param frame_size the size of a frame in bytes, a multiple of FRAME_ALIGNMENT
+   * @param use_huge_pages whether to ask for transparent huge pages
+   */
+  FrameArena(size_t num_frames, size_t frame_size, bool use_huge_pages = enable_huge_page_frames);
+
+  /** Unmap the memory of the frames. */
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of a frame */
+  auto GetFrame(frame_id_t frame_id) -> char * { return data_ + static_cast<size_t>(frame_id) * frame_size_; }
+
+  /**
+   * @brief Give the memory of a frame back to the OS. The frame stays mapped and reads as zeros afterwards.
+   * @param frame_id the frame, which must not be in use
+   */
+  void Release(frame_id_t frame_id);
+
+  /** @return whether the arena was advised to be backed by huge pages */
+  auto UsesHugePages() const -> bool { return huge_pages_; }
+
+ private:
+  const size_t frame_size_;
+  /** Start and size of the mapping, a multiple of the page size it is aligned to */
+  char *data_{nullptr};
+  size_t size_{0};
+  bool huge_pages_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_replacer.h
+//
+// Identification: src/include/buffer/frame_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FrameReplacer is the interface between a buffer pool manager instance and its page replacement policy.
+ *
+ * The buffer pool reports every access to a frame together with the page it holds, and marks frames evictable or
+ * non-evictable as their pin count drops to or leaves zero. A frame the replacer has never seen, or has evicted or
+ * removed since, is not tracked until its next access.
+ */
+class FrameReplacer {
+ public:
+  FrameReplacer() = default;
+  virtual ~FrameReplacer() = default;
+
+  /**
+   * @brief Pick a victim among the evictable frames according to the policy and stop tracking it.
+   * @param[out] frame_id id of the evicted frame
+   * @return true if a frame was evicted, false if no frame is evictable
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * @brief Undo the last Evict, for a victim the buffer pool could not take after all because it was pinned meanwhile.
+   * The frame is tracked again as evictable, in the same place relative to the other evictable frames, and whatever
+   * Evict remembered about its page is forgotten. This is not an access: no ghost hit, no history. Does nothing if the
+   * frame is no longer the last victim or has been tracked again since.
+   * @param frame_id id of the frame the last call to Evict returned
+   */
+  virtual void Restore(frame_id_t frame_id) = 0;
+
+  /**
+   * @brief Record an access to a frame. An untracked frame starts being tracked as non-evictable.
+   * @param frame_id id of the accessed frame
+   * @param page_id id of the page held in the frame. Policies that remember evicted pages use it.
+   */
+  virtual void RecordAccess(frame_id_t frame_id, page_id_t page_id) = 0;
+
+  /**
+   * @brief Mark a tracked frame evictable or non-evictable. Untracked frames are ignored.
+   * @param frame_id id of the frame
+   * @param set_evictable whether the frame may be evicted
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /**
+   * @brief Stop tracking an evictable frame, e.g. because its page was deleted. Untracked frames are ignored.
+   * @param frame_id id of the frame
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /** @return the number of evictable frames */
+  virtual auto Size() -> size_t = 0;
+
+  /**
+   * @brief List the evictable frames closest to eviction, starting with the one Evict would pick now, without evicting
+   * or touching them. Policies whose choice depends on the lists' sizes give the order as of the call.
+   * @param max_frames the maximum number of frames to list
+   * @return up to max_frames evictable frames, coldest first
+   */
+  virtual auto PeekVictims(size_t max_frames) -> std::vector<frame_id_t> = 0;
+
+  /**
+   * @brief Change the number of frames the replacer is required to track, keeping what it knows about the frames that
+   * remain. Policies that size their lists after the number of frames resize them too.
+   * @param num_frames the new number of frames. When shrinking, the frames beyond it must not be tracked.
+   */
+  virtual void Resize(size_t num_frames) = 0;
+};
+
+/**
+ * @brief Create a replacer implementing the given policy.
+ * @param policy the replacement policy
+ * @param num_frames the number of frames the replacer will be required to track
+ * @param k the lookback constant, only used by LRU-K
+ */
+auto MakeFrameReplacer(ReplacerPolicy policy, size_t num_frames, size_t k) -> std::unique_ptr<FrameReplacer>;
+
+/** @brief Return the name of a replacement policy: "lru-k", "arc" or "2q". */
+auto ReplacerPolicyToString(ReplacerPolicy policy) -> std::string;
+
+/**
+ * @brief Parse the name of a replacement policy, as returned by ReplacerPolicyToString.
+ * @param name the policy name
+ * @param[out] policy the parsed policy
+ * @return false if the name is unknown
+ */
+auto ParseReplacerPolicy(const std::string &name, ReplacerPolicy *policy) -> bool;
+
+/** Outcome of replaying a page access trace. */
+struct TraceReplayResult {
+  size_t accesses_{0};
+  size_t hits_{0};
+
+  auto HitRatio() const -> double { return accesses_ == 0 ? 0 : static_cast<double>(hits_) / accesses_; }
+};
+
+/**
+ * @brief Replay a page access trace against a simulated buffer pool of num_frames frames using the given policy.
+ * Every access pins the page and unpins it right away, as a buffer pool client would. No disk IO is done.
+ * @param policy the replacement policy
+ * @param num_frames the number of frames in the simulated buffer pool
+ * @param k the lookback constant, only used by LRU-K
+ * @param trace the page ids in the order they are accessed
+ * @return the number of accesses and buffer pool hits
+ */
+auto ReplayTrace(ReplacerPolicy policy, size_t num_frames, size_t k, const std::vector<page_id_t> &trace)
+    -> TraceReplayResult;
+
+}  // namespace bustub
@@ -12,12 +12,10 @@
 
 #pragma once
 
-#include <limits>
-#include <list>
 #include <mutex>  // NOLINT
-#include <unordered_map>
 #include <vector>
 
+#include "buffer/frame_replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 
@@ -33,8 +31,13 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * All state lives in flat per-frame arrays allocated up front. Evictable frames are kept in two intrusive lists, one
+ * for frames with +inf backward k-distance and one for the rest, each sorted so that the victim is always at the tail.
+ * A frame only moves in a list when its key changes, and is inserted from the head, where a frame that has just been
+ * accessed or unpinned normally belongs, so all operations are O(1) in practice and never allocate.
  */
-class LRUKReplacer {
+class LRUKReplacer : public FrameReplacer {
  public:
   /**
    *
@@ -52,7 +55,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -70,7 +73,10 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  /** @brief Put the last victim back with the history it had, which Evict forgets but leaves in place. */
+  void Restore(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -85,6 +91,9 @@ class LRUKReplacer {
    */
   void RecordAccess(frame_id_t frame_id);
 
+  /** @brief Record an access to the frame. LRU-K only looks at frames, so the page id is ignored. */
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override { RecordAccess(frame_id); }
+
   /**
    * TODO(P1): Add implementation
    *
@@ -102,7 +111,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -121,7 +130,7 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -130,26 +139,69 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  /**
+   * @brief List up to max_frames evictable frames in the order Evict would pick them: the tail of the history list
+   * first, then the tail of the cache list.
+   */
+  auto PeekVictims(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  /** @brief Resize the per-frame arrays, which moves the list sentinels behind the last frame. */
+  void Resize(size_t num_frames) override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  [[maybe_unused]] size_t current_timestamp_{0};
+  static constexpr frame_id_t INVALID_FRAME_ID = -1;
+
+  /** Per-frame bookkeeping. prev_ / next_ link the frame into the evictable list it currently belongs to. */
+  struct FrameNode {
+    /** Number of recorded accesses, saturating at k */
+    size_t access_count_{0};
+    /** Slot of the oldest timestamp in this frame's ring of the last k access timestamps */
+    size_t oldest_{0};
+    bool is_evictable_{false};
+    frame_id_t prev_{INVALID_FRAME_ID};
+    frame_id_t next_{INVALID_FRAME_ID};
+  };
+
+  /** @brief Abort if the frame id is out of range. */
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  /**
+   * @brief The eviction key of a frame: the timestamp of its k-th most recent access if it has k accesses, or of its
+   * first access otherwise. Within a list, a smaller key means a larger backward k-distance.
+   */
+  auto Key(frame_id_t frame_id) const -> size_t;
+
+  /** @brief Sentinel of the list the frame belongs to when evictable: the history list (< k accesses) or cache list. */
+  auto ListOf(frame_id_t frame_id) const -> frame_id_t;
+
+  /** @brief Insert an evictable frame into its list, keeping the list sorted by key with the largest key at the head. */
+  void Link(frame_id_t frame_id);
+
+  /** @brief Take a frame out of the list it is linked into. */
+  void Unlink(frame_id_t frame_id);
+
+  /** @brief Forget all access history of a frame. The frame must not be linked. */
+  void Reset(frame_id_t frame_id);
+
+  size_t current_timestamp_{0};
   size_t curr_size_{0};
   size_t replacer_size_;
   size_t k_;
   std::mutex latch_;
 
-  std::unordered_map<frame_id_t, size_t> access_count_;
-
-  std::list<frame_id_t> history_list_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> history_map_;
-
-  std::list<frame_id_t> cache_list_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> cache_map_;
-
-  std::unordered_map<frame_id_t, bool> is_evictable_;
+  /** One node per frame, followed by the sentinels of the history list and the cache list. */
+  std::vector<FrameNode> nodes_;
+  /** The last k access timestamps of every frame, k consecutive slots per frame used as a ring. */
+  std::vector<size_t> timestamps_;
+  /** Sentinel of the list of evictable frames with fewer than k accesses. */
+  frame_id_t history_list_;
+  /** Sentinel of the list of evictable frames with k accesses. */
+  frame_id_t cache_list_;
+  /** The frame Evict returned last, and its node before it was reset */
+  frame_id_t last_victim_{INVALID_FRAME_ID};
+  FrameNode last_victim_node_;
 };
 
 }  // namespace bustub
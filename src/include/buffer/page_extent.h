@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_extent.h
+//
+// Identification: src/include/buffer/page_extent.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <mutex>  // NOLINT
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageExtent hands out the pages of a table or an index from runs of consecutive page ids, so that the pages of one
+ * object stay together in the database file even when several objects grow at the same time. A scan over them then
+ * reads the file sequentially, and read-ahead and flushes turn into large I/Os.
+ *
+ * The buffer pool reserves a run of extent-size pages on disk when the current one is used up. Pages of a run that are
+ * never handed out stay reserved until the database is reopened, when they are free again.
+ *
+ * An extent belongs to a single table or index, whose threads may create pages concurrently.
+ */
+class PageExtent {
+ public:
+  /** Reserves a run of num_pages consecutive pages and returns the id of the first one. */
+  using reserve_fn = std::function<page_id_t(size_t num_pages)>;
+
+  /**
+   * @brief Create an extent that is empty until the first page is taken.
+   * @param extent_size the number of consecutive pages to reserve at a time
+   */
+  explicit PageExtent(size_t extent_size = EXTENT_SIZE) : extent_size_(extent_size) {
+    BUSTUB_ASSERT(extent_size > 0, "extent must have at least one page");
+  }
+
+  DISALLOW_COPY_AND_MOVE(PageExtent);
+
+  /** @return the number of pages reserved at a time */
+  auto GetExtentSize() const -> size_t { return extent_size_; }
+
+  /**
+   * @brief Take the next page of the current run, reserving a new run first if it is used up.
+   * @param reserve how to reserve a new run
+   * @return the id of the page
+   */
+  auto TakePage(const reserve_fn &reserve) -> page_id_t {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (next_page_id_ == end_page_id_) {
+      next_page_id_ = reserve(extent_size_);
+      end_page_id_ = next_page_id_ + static_cast<page_id_t>(extent_size_);
+    }
+    return next_page_id_++;
+  }
+
+  /**
+   * @brief Give back a page that was taken but could not be used. Only the last page taken can be given back; any
+   * other stays reserved.
+   * @param page_id the page returned by TakePage
+   */
+  void PutBack(page_id_t page_id) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (page_id + 1 == next_page_id_) {
+      next_page_id_--;
+    }
+  }
+
+ private:
+  const size_t extent_size_;
+  /** The next page to hand out, and the end of the current run */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  page_id_t end_page_id_{INVALID_PAGE_ID};
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/prefetcher.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool across several BufferPoolManagerInstances. Each instance owns its
+ * own frames, page table, replacer and latch, so threads working on pages of different shards never contend.
+ *
+ * A page always lives in the instance `page_id % num_instances`. Every instance only allocates page ids that map back
+ * to itself, and new pages are handed out round-robin across the instances.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the page replacement policy of each instance
+   * @param max_pool_size the size Resize may grow each instance to, or 0 for pool_size
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K, size_t max_pool_size = 0);
+
+  /**
+   * @brief Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @brief Return the total size (number of frames) of all the buffer pool instances. */
+  auto GetPoolSize() -> size_t override;
+
+  /**
+   * @brief Resize every instance, splitting the frames evenly between them; the first instances take the remainder.
+   * @param pool_size the new total number of frames
+   * @return false if some instance would get no frame or more than its maximum
+   */
+  auto Resize(size_t pool_size) -> bool override;
+
+  /** @brief Return the page size shared by all the buffer pool instances. */
+  auto GetPageSize() -> int override { return disk_manager_->GetPageSize(); }
+
+  /** @brief Return the number of buffer pool instances. */
+  auto GetNumInstances() const -> size_t { return num_instances_; }
+
+  /**
+   * @brief Start the page cleaner of every instance.
+   * @param num_clean_frames how many frames to keep clean in each instance
+   */
+  void RunPageCleaner(size_t num_clean_frames);
+
+  /** @brief Stop the page cleaner of every instance. */
+  void StopPageCleaner();
+
+  /** @return the number of dirty victims written back by misses and new pages, summed over the instances */
+  auto GetForegroundWrites() const -> uint64_t;
+
+  /** @return the number of dirty pages written back by the page cleaners, summed over the instances */
+  auto GetBackgroundWrites() const -> uint64_t;
+
+  /**
+   * @return the counters of the instances, summed, except for the pinned high-water mark: that is the highest of any
+   * instance, as the instances do not count their pins together.
+   */
+  auto GetStats() -> BufferPoolStats override;
+
+ protected:
+  /**
+   * @brief Get the BufferPoolManagerInstance responsible for handling the given page id.
+   * @param page_id id of the page
+   * @return the buffer pool manager instance responsible for the page
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it.
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it, using the caller's access strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the access strategy of the caller, or nullptr
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Pin the requested page for an optimistic read in the instance that owns it.
+   * @param page_id id of page to be pinned
+   * @return nullptr if page_id cannot be fetched or is not allocated, otherwise pointer to the pinned page
+   */
+  auto PinPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Queue pages to be read ahead in the background. A single prefetcher serves all instances, since a chain of
+   * pages usually spans several of them.
+   * @param first_page_id id of the first page to read
+   * @param num_pages the number of pages to read
+   * @param next_page how to find the next page, or nullptr for consecutive page ids
+   * @param strategy the access strategy of the scan the pages are read for, or nullptr
+   */
+  void PrefetchPgImp(page_id_t first_page_id, size_t num_pages, next_page_fn next_page,
+                     std::shared_ptr<BufferAccessStrategy> strategy) override;
+
+  /**
+   * @brief Unpin the target page from the instance that owns it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk through the instance that owns it.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page. Instances are tried round-robin, starting one past the instance that was tried first
+   * on the previous call, until one of them has a frame available.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Create a new page with the next id of an extent, in the instance that owns that id. Consecutive pages of an
+   * extent therefore go to different instances.
+   * @param[out] page_id id of created page
+   * @param extent the extent of the caller, or nullptr to create the page like NewPgImp(page_id)
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id, PageExtent *extent) -> Page * override;
+
+  /**
+   * @brief Delete a page from the instance that owns it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the pages of every instance to disk.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * @brief Write the hot pages of all the instances to one hot page file, taking the hottest page of each instance in
+   * turn, then the second hottest, and so on.
+   */
+  void SaveHotPgsImp() override;
+
+  /**
+   * @brief Preload the pages listed in the hot page file, each into the instance that owns it.
+   * @return the number of pages read
+   */
+  auto PreloadHotPgsImp() -> size_t override;
+
+ private:
+  /** Number of buffer pool instances. */
+  const size_t num_instances_;
+  /** The disk manager shared by the instances */
+  DiskManager *disk_manager_;
+  /** The buffer pool instances; instance i owns every page id with page_id % num_instances_ == i. */
+  std::vector<BufferPoolManagerInstance *> instances_;
+  /** The instance NewPgImp starts probing from. */
+  std::atomic<size_t> next_instance_{0};
+  /** Reads pages ahead in the background, through the instance that owns each page. */
+  Prefetcher prefetcher_;
+};
+
+}  // namespace bustub
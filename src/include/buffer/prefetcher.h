@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// prefetcher.h
+//
+// Identification: src/include/buffer/prefetcher.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * Prefetcher serves the prefetch requests of a buffer pool with a background thread, so that the thread that will
+ * fetch the pages does not wait for the disk.
+ *
+ * Requests are queued and served in order. The worker thread is only started by the first request, so a buffer pool
+ * that never prefetches pays nothing. Requests beyond MAX_QUEUED_REQUESTS are dropped: a prefetch that arrives after
+ * the scan has caught up is useless anyway.
+ */
+class Prefetcher {
+ public:
+  /**
+   * Brings a page into the buffer pool and pins it, without counting as an access to the page. Returns nullptr if
+   * there is no frame to read the page into.
+   */
+  using read_ahead_fn = std::function<Page *(page_id_t page_id, BufferAccessStrategy *strategy)>;
+
+  /**
+   * Brings a batch of distinct pages into the buffer pool with their reads in flight at once, leaving them unpinned.
+   * Like read_ahead_fn, this does not count as an access; it stops early once there is no frame left.
+   */
+  using read_ahead_batch_fn =
+      std::function<void(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy)>;
+
+  /**
+   * @brief Create a prefetcher for a buffer pool.
+   * @param bpm the buffer pool, used to unpin the pages read ahead
+   * @param read_ahead how to bring a page into the buffer pool
+   * @param read_ahead_batch how to bring a run of consecutive pages into the buffer pool at once, or nullptr to read
+   * them one by one
+   */
+  Prefetcher(BufferPoolManager *bpm, read_ahead_fn read_ahead, read_ahead_batch_fn read_ahead_batch = nullptr)
+      : bpm_(bpm), read_ahead_(std::move(read_ahead)), read_ahead_batch_(std::move(read_ahead_batch)) {}
+
+  DISALLOW_COPY_AND_MOVE(Prefetcher);
+
+  ~Prefetcher() { Stop(); }
+
+  /**
+   * @brief Queue a request to read a run of pages, as described in BufferPoolManager::PrefetchRange.
+   * @param first_page_id id of the first page to read
+   * @param num_pages the number of pages to read
+   * @param next_page how to find the next page, or nullptr for consecutive page ids
+   * @param strategy the access strategy of the scan the pages are read for, or nullptr
+   */
+  void Submit(page_id_t first_page_id, size_t num_pages, BufferPoolManager::next_page_fn next_page,
+              std::shared_ptr<BufferAccessStrategy> strategy);
+
+  /** @brief Drop the queued requests and join the worker thread. No request is accepted afterwards. */
+  void Stop();
+
+ private:
+  static constexpr size_t MAX_QUEUED_REQUESTS = 64;
+
+  struct Request {
+    page_id_t first_page_id_;
+    size_t num_pages_;
+    BufferPoolManager::next_page_fn next_page_;
+    std::shared_ptr<BufferAccessStrategy> strategy_;
+  };
+
+  /** @brief The worker thread: serve requests until stopped. */
+  void Run();
+
+  /**
+   * @brief Read the pages of one request, stopping early at the end of a chain or when the pool is full. A run of
+   * consecutive pages is read as one batch if the buffer pool supports it.
+   */
+  void Serve(const Request &request);
+
+  BufferPoolManager *bpm_;
+  read_ahead_fn read_ahead_;
+  read_ahead_batch_fn read_ahead_batch_;
+
+  /** Protects everything below except stopped_, which the worker also polls between pages */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<Request> requests_;
+  std::thread worker_;
+  std::atomic<bool> stopped_{false};
+};
+
+}  // namespace bustub
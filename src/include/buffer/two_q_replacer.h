@@ -0,0 +1,113 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_q_replacer.h
+//
+// Identification: src/include/buffer/two_q_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/frame_replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQReplacer implements the full version of 2Q (Johnson and Shasha, VLDB '94).
+ *
+ * A page seen for the first time enters A1in, a FIFO queue limited to a quarter of the frames. Pages pushed out of
+ * A1in are remembered by id in A1out, which holds up to half as many ids as there are frames. Only a page that is
+ * accessed again while in A1out is promoted to Am, the LRU list of hot pages. A sequential scan therefore cycles
+ * through A1in without ever displacing Am.
+ *
+ * Pinned frames stay in their queue and are skipped by Evict.
+ */
+class TwoQReplacer : public FrameReplacer {
+ public:
+  /**
+   * @brief Create a new TwoQReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to track
+   */
+  explicit TwoQReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQReplacer);
+
+  ~TwoQReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void Restore(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto PeekVictims(size_t max_frames) -> std::vector<frame_id_t> override;
+
+  /** @brief Resize the cache, and A1in and A1out in proportion. Shrinking forgets the oldest pages of A1out. */
+  void Resize(size_t num_frames) override;
+
+ private:
+  static constexpr frame_id_t INVALID_FRAME_ID = -1;
+
+  enum class QueueType { NONE, A1IN, AM };
+
+  struct FrameEntry {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    QueueType queue_{QueueType::NONE};
+    bool is_evictable_{false};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** The frame Evict returned last, with the page it held, the queue it came from and the page it pushed out of A1out */
+  struct Victim {
+    frame_id_t frame_id_{INVALID_FRAME_ID};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    QueueType queue_{QueueType::NONE};
+    page_id_t dropped_page_id_{INVALID_PAGE_ID};
+  };
+
+  /** @brief Find the evictable frame closest to the tail of a queue, or INVALID_FRAME_ID if there is none. */
+  auto FindVictim(const std::list<frame_id_t> &queue) const -> frame_id_t;
+
+  /** @brief Append the evictable frames of a queue to victims, tail first, until it holds max_frames frames. */
+  void CollectVictims(const std::list<frame_id_t> &queue, size_t max_frames, std::vector<frame_id_t> *victims) const;
+
+  /** @brief Stop tracking a frame without remembering its page. */
+  void Untrack(frame_id_t frame_id);
+
+  size_t curr_size_{0};
+  size_t replacer_size_;
+  /** Size A1in may grow to before Evict takes frames from it */
+  size_t a1in_size_;
+  /** Number of page ids A1out remembers */
+  size_t a1out_size_;
+  std::mutex latch_;
+
+  std::vector<FrameEntry> frames_;
+  /** Resident pages seen once, newest at the front */
+  std::list<frame_id_t> a1in_;
+  /** Resident hot pages, most recently used at the front */
+  std::list<frame_id_t> am_;
+  /** Pages recently pushed out of A1in, newest at the front */
+  std::list<page_id_t> a1out_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> a1out_map_;
+  Victim last_victim_;
+};
+
+}  // namespace bustub
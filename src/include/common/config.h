@@ -27,15 +27,48 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** A running page cleaner looks for dirty pages to write back every PAGE_CLEANER_INTERVAL milliseconds. */
+extern std::chrono::milliseconds page_cleaner_interval;
+
+/** Page replacement policies a buffer pool can use. */
+enum class ReplacerPolicy { LRU_K, ARC, TWO_Q };
+
+/** Replacement policy of the buffer pool created by BustubInstance. */
+extern ReplacerPolicy replacer_policy;
+
+/** Page size of the database files BustubInstance creates. An existing file keeps the page size it was created with. */
+extern int database_page_size;
+
+/** True if BustubInstance should compress the pages of its database file on disk. */
+extern bool enable_page_compression;
+
+/** True if buffer pools of at least one huge page should ask for transparent huge pages for their frames. */
+extern bool enable_huge_page_frames;
+
+/** True if BustubInstance should read and write the pages of its database file with O_DIRECT. */
+extern bool enable_direct_io;
+
+/** How full CREATE INDEX packs the pages of the tree it builds, from 0.5 (half full) to 1 (full). */
+extern double index_fill_factor;
+
+/** Bytes of index entries CREATE INDEX sorts in memory; more are sorted in runs spilled to temporary files. */
+extern size_t index_build_memory;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
-static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // default size of a data page
+static constexpr int BUSTUB_MIN_PAGE_SIZE = 4096;                                    // smallest page size of a db
+static constexpr int BUSTUB_MAX_PAGE_SIZE = 65536;                                   // largest page size of a db
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int BULKREAD_RING_SIZE = 64;  // max frames a bulk-read scan cycles through (256KB, as in Postgres)
+static constexpr int READ_AHEAD_PAGES = 16;    // max pages a sequential scan reads ahead
+static constexpr int EXTENT_SIZE = 64;         // consecutive pages a table or index reserves at a time
+static constexpr int KEY_BLOCK_SIZE = 64;      // bytes of keys a B+tree page stores together, a cache line
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// latency_histogram.h
+//
+// Identification: src/include/common/latency_histogram.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * LatencyHistogram counts latencies in buckets of powers of two nanoseconds: bucket b holds latencies below 2^b ns
+ * and at least 2^(b-1) ns. Recording is a couple of relaxed atomic increments, so threads can record concurrently
+ * without a latch. Percentiles are only as precise as the buckets, i.e. within a factor of two.
+ */
+class LatencyHistogram {
+ public:
+  /** The last bucket also holds every latency of 2^(NUM_BUCKETS - 2) ns (about 9 minutes) or more */
+  static constexpr size_t NUM_BUCKETS = 41;
+
+  using clock = std::chrono::steady_clock;
+
+  /** Record a latency in nanoseconds. */
+  void Record(uint64_t latency_ns) {
+    size_t bucket = latency_ns == 0 ? 0 : 64 - __builtin_clzll(latency_ns);
+    if (bucket >= NUM_BUCKETS) {
+      bucket = NUM_BUCKETS - 1;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+  }
+
+  /** Record the time elapsed since start. */
+  void RecordSince(clock::time_point start) {
+    Record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+  }
+
+  /** @return the number of latencies recorded */
+  auto Count() const -> uint64_t {
+    uint64_t count = 0;
+    for (const auto &bucket : buckets_) {
+      count += bucket.load(std::memory_order_relaxed);
+    }
+    return count;
+  }
+
+  /** @return the mean latency in nanoseconds, 0 if none was recorded */
+  auto MeanNs() const -> uint64_t {
+    const auto count = Count();
+    return count == 0 ? 0 : total_ns_.load(std::memory_order_relaxed) / count;
+  }
+
+  /**
+   * @param percentile the percentile, from 0 to 100
+   * @return an upper bound of the latency in nanoseconds below which the given percentage of the latencies fall, 0 if
+   * none was recorded
+   */
+  auto PercentileNs(double percentile) const -> uint64_t {
+    const auto count = Count();
+    if (count == 0) {
+      return 0;
+    }
+    const auto rank = static_cast<uint64_t>(percentile / 100 * static_cast<double>(count));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+      seen += buckets_[bucket].load(std::memory_order_relaxed);
+      if (seen > rank || seen == count) {
+        return uint64_t{1} << bucket;
+      }
+    }
+    return uint64_t{1} << (NUM_BUCKETS - 1);
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, NUM_BUCKETS> buckets_{};
+  std::atomic<uint64_t> total_ns_{0};
+};
+
+}  // namespace bustub
@@ -12,37 +12,120 @@
 
 #pragma once
 
+#include <sys/uio.h>
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
 #include <mutex>   // NOLINT
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/config.h"
+#include "common/latency_histogram.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with pread/pwrite at their offset in the database file, so page I/Os from different
+ * threads do not share a file position and run in parallel. Callers must not read and write the same page at once.
+ *
+ * Which pages are allocated is kept in a free-space map next to the database file (foo.db has foo.fsm), one bit per
+ * page. AllocatePage reuses deallocated pages before it extends the file. Reusing or deallocating a page writes its
+ * bit through right away, as does allocating a reserved page below the page count on disk; the page count is written
+ * on Sync and ShutDown. Pages found in the database file beyond the
+ * page count of the map, e.g. after a crash, are taken as allocated, so a page in use is never handed out twice.
+ *
+ * The page size is a property of the database, between BUSTUB_MIN_PAGE_SIZE and BUSTUB_MAX_PAGE_SIZE. It is chosen when
+ * the database file is created and recorded in the header page, which is page 0; opening an existing database with a
+ * header page uses the page size recorded there, whatever the caller asked for.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param page_size the page size of the database if the file is new, a power of two
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, int page_size = BUSTUB_PAGE_SIZE);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
+
+  /** @return the page size of the database in bytes */
+  auto GetPageSize() const -> int { return page_size_; }
+
+  /** @return the file name of the database file, empty if there is none */
+  auto GetFileName() const -> const std::string & { return file_name_; }
+
+  /**
+   * Open the database file a second time with O_DIRECT, so that page reads and writes bypass the OS page cache and a
+   * page is cached once, in the buffer pool. Only pages in buffers aligned to DIRECT_IO_ALIGNMENT, like the frames of
+   * a buffer pool, are read and written directly; other buffers keep going through the page cache, which the kernel
+   * keeps coherent with direct I/O. Call it before any I/O is in flight.
+   * @return false if there is no database file, or the system or its file system does not support O_DIRECT
+   */
+  virtual auto EnableDirectIO() -> bool;
+
+  /** @return true if pages in aligned buffers bypass the OS page cache */
+  auto IsDirectIO() const -> bool { return direct_fd_ >= 0; }
+
+  /** Alignment of the buffers, offsets and sizes of direct I/O */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+  /**
+   * Allocate a page, reusing a deallocated page if there is one and extending the database otherwise. A parallel
+   * buffer pool partitions page ids among its instances: an instance only allocates ids with id % stride == offset.
+   * @param stride the number of partitions of the page ids
+   * @param offset the partition to allocate from
+   * @return the id of the allocated page
+   */
+  auto AllocatePage(uint32_t stride = 1, uint32_t offset = 0) -> page_id_t;
+
+  /**
+   * Reserve a run of consecutive pages, e.g. for the extent of a table. Reserved pages are not handed out by
+   * AllocatePage; their owner allocates them one by one with AllocateReservedPage. The ones it never allocates are free
+   * again once the database is reopened.
+   * @param num_pages the number of pages in the run
+   * @return the id of the first page of the run
+   */
+  auto ReserveExtent(size_t num_pages) -> page_id_t;
+
+  /**
+   * Allocate a page reserved by ReserveExtent.
+   * @param page_id id of the page
+   */
+  void AllocateReservedPage(page_id_t page_id);
+
+  /**
+   * Deallocate a page, so that AllocatePage can hand it out again. Deallocating a free page has no effect.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return true if the page is allocated */
+  auto IsAllocated(page_id_t page_id) -> bool;
+
+  /** @return the number of pages in the database, free or not: one past the highest page ever allocated or reserved */
+  auto GetNumPages() -> page_id_t;
+
+  /**
+   * Shrink the database file by the free pages at its end. Pages are not moved, so free pages in the middle of the
+   * file stay where they are. Only use this offline: other users of the file must not hold on to the truncated pages.
+   * @return the number of pages removed
+   */
+  auto TruncateFreeTail() -> page_id_t;
 
   /**
    * Write a page to the database file.
@@ -58,6 +141,54 @@ class DiskManager {
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Start writing a page to the database file. Asynchronous disk managers queue the write, and only start it once
+   * SubmitIO() is called or the queue is full; the default implementation writes the page right away.
+   * @param page_id id of the page
+   * @param page_data raw page data, which must stay unchanged until the write completes
+   * @return a future that becomes ready when the write has completed
+   */
+  virtual auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void>;
+
+  /**
+   * Write a run of pages with consecutive ids to the database file with a single vectored write.
+   * @param first_page_id id of the first page of the run
+   * @param pages raw data of the pages, in page id order
+   */
+  virtual void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages);
+
+  /**
+   * Start writing a run of pages with consecutive ids, queued like WritePageAsync.
+   * @param first_page_id id of the first page of the run
+   * @param pages raw data of the pages, in page id order, which must stay unchanged until the write completes
+   * @return a future that becomes ready when the whole run has been written
+   */
+  virtual auto WritePagesAsync(page_id_t first_page_id, std::vector<const char *> pages) -> std::future<void>;
+
+  /**
+   * Start reading a page from the database file, queued like WritePageAsync.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, which must stay valid until the read completes
+   * @return a future that becomes ready when page_data holds the page
+   */
+  virtual auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void>;
+
+  /**
+   * Start all the asynchronous I/Os queued so far as one batch. Call this before waiting on any of their futures.
+   */
+  virtual void SubmitIO() {}
+
+  /**
+   * Make a page written earlier durable: return only once it has reached stable storage.
+   * @param page_id id of the page
+   */
+  virtual void SyncPage(page_id_t page_id);
+
+  /**
+   * Make all the pages written so far durable.
+   */
+  virtual void Sync();
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -83,6 +214,15 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of page reads */
+  auto GetNumReads() const -> int { return num_reads_; }
+
+  /** @return the latencies of page reads, one per read */
+  auto GetReadLatency() const -> const LatencyHistogram & { return read_latency_; }
+
+  /** @return the latencies of page writes, one per write call: a vectored write of a run counts once */
+  auto GetWriteLatency() const -> const LatencyHistogram & { return write_latency_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -93,19 +233,90 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
+  /** Identifies a free-space map file */
+  static constexpr uint32_t FREE_MAP_MAGIC = 0x46534d31;
+  /** The magic number and the page count precede the bitmap */
+  static constexpr size_t FREE_MAP_HEADER_SIZE = 2 * sizeof(uint32_t);
+
   auto GetFileSize(const std::string &file_name) -> int;
+
+  /**
+   * @param page_data the buffer a page is read into or written from
+   * @return the descriptor to read or write the page with: the direct one if it is open and the buffer is aligned
+   */
+  auto PageFd(const void *page_data) const -> int {
+    return direct_fd_ >= 0 && reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0 ? direct_fd_ : db_fd_;
+  }
+
+  /**
+   * @param iovecs the buffers a run of pages is written from
+   * @return the descriptor to write the run with: the direct one if it is open and every buffer is aligned
+   */
+  auto RunFd(const std::vector<iovec> &iovecs) const -> int;
+
+  /** Use the page size recorded in the header page of the database file, or page_size if there is none. */
+  void LoadPageSize(int page_size);
+
+  /** Use page_size, which must be a power of two between BUSTUB_MIN_PAGE_SIZE and BUSTUB_MAX_PAGE_SIZE. */
+  void SetPageSize(int page_size);
+
+  /** Open the free-space map and load it, taking the pages of the database file beyond it as allocated. */
+  void LoadFreeMap();
+
+  /** Write the page count and the whole bitmap to the free-space map file. Caller should hold alloc_latch_. */
+  void WriteFreeMap();
+
+  /** @return true if the bit of a page is set. Caller should hold alloc_latch_. */
+  auto TestAllocated(page_id_t page_id) const -> bool;
+
+  /** Set the bit of a page, growing the bitmap as needed. Caller should hold alloc_latch_. */
+  void SetAllocated(page_id_t page_id, bool allocated);
+
+  /** Write the byte of the bitmap that holds the bit of a page to the file. Caller should hold alloc_latch_. */
+  void WriteFreeMapByte(page_id_t page_id);
+
+  /** Add a page to free_pages_ and to its partitions. Caller should hold alloc_latch_. */
+  void AddFreePage(page_id_t page_id);
+
+  /** Remove a page from free_pages_ and from its partitions. Caller should hold alloc_latch_. */
+  void RemoveFreePage(page_id_t page_id);
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // file descriptor of the db file, -1 if not open
+  int db_fd_{-1};
+  // file descriptor of the db file opened with O_DIRECT, -1 unless direct I/O is enabled
+  int direct_fd_{-1};
+  // page size of the database in bytes
+  int page_size_{BUSTUB_PAGE_SIZE};
   std::string file_name_;
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_reads_{0};
+  LatencyHistogram read_latency_;
+  LatencyHistogram write_latency_;
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+
+  std::string fsm_name_;
+  // file descriptor of the free-space map, -1 if not open
+  int fsm_fd_{-1};
+  /** Protects the allocation state below */
+  std::mutex alloc_latch_;
+  /** One bit per page, set while the page is allocated */
+  std::vector<uint8_t> allocation_map_;
+  /** The free pages below num_pages_ that are not reserved, so that allocation does not scan the bitmap */
+  std::set<page_id_t> free_pages_;
+  /**
+   * free_pages_ split by page id modulo each stride above 1 that AllocatePage was called with, so that an allocation
+   * takes the lowest free page of its partition without going through the free pages of the others
+   */
+  std::unordered_map<uint32_t, std::vector<std::set<page_id_t>>> free_pages_by_stride_;
+  /** One more than the highest page id ever allocated or reserved */
+  page_id_t num_pages_{0};
+  /** The page count last written to the free-space map */
+  page_id_t num_pages_on_disk_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.h
+//
+// Identification: src/include/storage/disk/disk_manager_compressed.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerCompressed compresses pages with PageCompressor on their way to disk, so that table pages and B+tree
+ * leaves full of repeated values take less I/O. The header page is always stored as is, since the page size is read
+ * from it before any page can be decompressed.
+ *
+ * A page keeps its slot at page_id * page_size in the database file. A compressed page is written to the start of its
+ * slot and the file system blocks after it are punched out, so the file is sparse and only the compressed bytes are
+ * read and written. A page is only stored compressed if that saves at least one block; with the default 4K page size
+ * on a 4K-block file system nothing does, so compression pays off with the larger page sizes. Punching holes needs
+ * Linux's fallocate; elsewhere the rest of the slot keeps its blocks, and compression only saves I/O.
+ *
+ * The page translation map next to the database file (foo.db has foo.ptm) records the compressed size of each page,
+ * or 0 for a page stored as is. An entry is written through whenever it changes. A database written by the plain
+ * DiskManager has no map and opens with all of its pages stored as is; once a page has been compressed, the database
+ * must be opened with a DiskManagerCompressed.
+ */
+class DiskManagerCompressed : public DiskManager {
+ public:
+  /**
+   * Creates a new compressing disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param page_size the page size of the database if the file is new
+   */
+  explicit DiskManagerCompressed(const std::string &db_file, int page_size = BUSTUB_PAGE_SIZE);
+
+  /** Closes the page translation map. */
+  ~DiskManagerCompressed() override;
+
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /** Writes the run page by page: compressed pages leave holes between them, so there is no contiguous run to write. */
+  void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void Sync() override;
+
+  /** @return the number of bytes of the page that are read from and written to the database file */
+  auto GetStoredSize(page_id_t page_id) -> size_t;
+
+ private:
+  /** Identifies a page translation map file */
+  static constexpr uint32_t TRANSLATION_MAP_MAGIC = 0x50544d31;
+  /** The magic number precedes the entries */
+  static constexpr size_t TRANSLATION_MAP_HEADER_SIZE = sizeof(uint32_t);
+
+  /** Open the page translation map and load it. The map of a database file that is empty is stale. */
+  void LoadTranslationMap();
+
+  /** Set the compressed size of a page and write its entry through if it changed. */
+  void SetCompressedSize(page_id_t page_id, uint32_t compressed_size);
+
+  /** @return the compressed size of a page, 0 if it is stored as is */
+  auto GetCompressedSize(page_id_t page_id) -> uint32_t;
+
+  std::string ptm_name_;
+  // file descriptor of the page translation map, -1 if not open
+  int ptm_fd_{-1};
+  /** Size of a block of the file system, the unit in which a compressed page saves space */
+  size_t block_size_;
+  /** Protects compressed_sizes_ */
+  std::mutex map_latch_;
+  /** The compressed size of each page, 0 for a page stored as is */
+  std::vector<uint32_t> compressed_sizes_;
+};
+
+}  // namespace bustub
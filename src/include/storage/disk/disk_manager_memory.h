@@ -9,7 +9,6 @@
 // Copyright (c) 2015-2020, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
-#include <array>
 #include <cstring>
 #include <fstream>
 #include <future>  // NOLINT
@@ -34,7 +33,12 @@ namespace bustub {
  */
 class DiskManagerMemory : public DiskManager {
  public:
-  explicit DiskManagerMemory(size_t pages);
+  /**
+   * Creates a disk manager holding the given number of pages in memory.
+   * @param pages the number of pages
+   * @param page_size the page size, a power of two
+   */
+  explicit DiskManagerMemory(size_t pages, int page_size = BUSTUB_PAGE_SIZE);
 
   ~DiskManagerMemory() override { delete[] memory_; }
 
@@ -52,6 +56,17 @@ class DiskManagerMemory : public DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data) override;
 
+  /**
+   * Write a run of pages with consecutive ids, one page at a time.
+   * @param first_page_id id of the first page of the run
+   * @param pages raw data of the pages, in page id order
+   */
+  void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) override {
+    for (size_t i = 0; i < pages.size(); i++) {
+      WritePage(first_page_id + static_cast<page_id_t>(i), pages[i]);
+    }
+  }
+
  private:
   char *memory_;
 };
@@ -62,7 +77,11 @@ class DiskManagerMemory : public DiskManager {
  */
 class DiskManagerUnlimitedMemory : public DiskManager {
  public:
-  DiskManagerUnlimitedMemory() = default;
+  /**
+   * Creates a disk manager holding pages in memory, as many as are written.
+   * @param page_size the page size, a power of two
+   */
+  explicit DiskManagerUnlimitedMemory(int page_size = BUSTUB_PAGE_SIZE) { SetPageSize(page_size); }
 
   /**
    * Write a page to the database file.
@@ -75,13 +94,13 @@ class DiskManagerUnlimitedMemory : public DiskManager {
       data_.resize(page_id + 1);
     }
     if (data_[page_id] == nullptr) {
-      data_[page_id] = std::make_shared<ProtectedPage>();
+      data_[page_id] = std::make_shared<ProtectedPage>(page_size_);
     }
     std::shared_ptr<ProtectedPage> ptr = data_[page_id];
-    std::unique_lock<std::shared_mutex> l_page(ptr->second);
+    std::unique_lock<std::shared_mutex> l_page(ptr->latch_);
     l.unlock();
 
-    memcpy(ptr->first.data(), page_data, BUSTUB_PAGE_SIZE);
+    memcpy(ptr->data_.data(), page_data, page_size_);
   }
 
   /**
@@ -100,16 +119,31 @@ class DiskManagerUnlimitedMemory : public DiskManager {
       return;
     }
     std::shared_ptr<ProtectedPage> ptr = data_[page_id];
-    std::shared_lock<std::shared_mutex> l_page(ptr->second);
+    std::shared_lock<std::shared_mutex> l_page(ptr->latch_);
     l.unlock();
 
-    memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
+    memcpy(page_data, ptr->data_.data(), page_size_);
+  }
+
+  /**
+   * Write a run of pages with consecutive ids, one page at a time.
+   * @param first_page_id id of the first page of the run
+   * @param pages raw data of the pages, in page id order
+   */
+  void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) override {
+    for (size_t i = 0; i < pages.size(); i++) {
+      WritePage(first_page_id + static_cast<page_id_t>(i), pages[i]);
+    }
   }
 
  private:
   std::mutex mutex_;
-  using Page = std::array<char, BUSTUB_PAGE_SIZE>;
-  using ProtectedPage = std::pair<Page, std::shared_mutex>;
+  /** A page, zeroed until it is first written, and the latch its reads and writes take */
+  struct ProtectedPage {
+    explicit ProtectedPage(int page_size) : data_(page_size) {}
+    std::vector<char> data_;
+    std::shared_mutex latch_;
+  };
   std::vector<std::shared_ptr<ProtectedPage>> data_;
 };
 
@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_mmap.h
+//
+// Identification: src/include/storage/disk/disk_manager_mmap.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerMmap maps the database file into memory, so that a page read is a memcpy from the mapping instead of a
+ * system call. It suits read-mostly databases, where misses are frequent and writes are rare.
+ *
+ * A write past the end of the mapping extends the file and the mapping by a whole chunk of MMAP_GROW_SIZE bytes, so
+ * that a growing table only remaps once in a while. The pages of a chunk that have not been written read as zeros.
+ * ShutDown truncates the file back to the end of the last page written.
+ *
+ * Writes only reach the page cache, as with the other disk managers. SyncPage and Sync flush the mapping with msync.
+ */
+class DiskManagerMmap : public DiskManager {
+ public:
+  /** The file and the mapping grow by this many bytes at a time */
+  static constexpr size_t MMAP_GROW_SIZE = 64 << 20;
+
+  /**
+   * Creates a new memory-mapped disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param page_size the page size of the database if the file is new
+   */
+  explicit DiskManagerMmap(const std::string &db_file, int page_size = BUSTUB_PAGE_SIZE);
+
+  /** Unmaps the file. */
+  ~DiskManagerMmap() override;
+
+  void ShutDown() override;
+
+  /** Always fails: the mapping is the page cache, so there is no I/O to bypass it with. */
+  auto EnableDirectIO() -> bool override { return false; }
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /** Copies the run into the mapping page by page; there is no system call to save. */
+  void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void SyncPage(page_id_t page_id) override;
+
+  void Sync() override;
+
+  /** @return the number of bytes currently mapped, which is also the size of the file */
+  auto GetMappedSize() -> size_t;
+
+ private:
+  /**
+   * @brief Extend the file and the mapping so that they cover at least min_size bytes. Caller should hold the latch
+   * exclusively.
+   */
+  void Grow(size_t min_size);
+
+  /** Start of the mapping, nullptr while the file is empty */
+  char *mapping_{nullptr};
+  /** Size of the mapping and of the file */
+  size_t mapping_size_{0};
+  /** End of the last page in the file, which the file is truncated to when closed */
+  std::atomic<size_t> file_size_{0};
+  /** Page I/Os copy to and from the mapping under a shared latch; growing it, which may move it, is exclusive */
+  std::shared_mutex mapping_latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,137 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.h
+//
+// Identification: src/include/storage/disk/disk_manager_uring.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+#include <condition_variable>  // NOLINT
+#include <future>              // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/**
+ * DiskManagerUring is a DiskManager whose asynchronous page I/Os go through io_uring, so that many of them can be in
+ * flight at once and a whole batch is started with a single system call.
+ *
+ * ReadPageAsync, WritePageAsync and WritePagesAsync put requests on the submission queue; SubmitIO, or a full queue,
+ * hands them to the kernel. A completion thread waits for the results and fulfills the futures. ReadPage and WritePage
+ * stay synchronous.
+ *
+ * If the kernel does not support io_uring, the ring cannot be set up and every I/O falls back to the synchronous
+ * DiskManager. An I/O that fails or comes back short in the ring is retried synchronously, too.
+ *
+ * io_uring is Linux only, so DiskManagerUring is only built on Linux.
+ */
+class DiskManagerUring : public DiskManager {
+ public:
+  /** Default number of submission queue entries */
+  static constexpr unsigned DEFAULT_QUEUE_DEPTH = 64;
+
+  /**
+   * Creates a new io_uring disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param queue_depth the number of I/Os that can be queued before they have to be submitted
+   * @param page_size the page size of the database if the file is new
+   */
+  explicit DiskManagerUring(const std::string &db_file, unsigned queue_depth = DEFAULT_QUEUE_DEPTH,
+                            int page_size = BUSTUB_PAGE_SIZE);
+
+  /** Waits for the I/Os in flight and tears down the ring. */
+  ~DiskManagerUring() override;
+
+  auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> override;
+
+  /** Queues the run as a single vectored write. */
+  auto WritePagesAsync(page_id_t first_page_id, std::vector<const char *> pages) -> std::future<void> override;
+
+  auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> override;
+
+  void SubmitIO() override;
+
+  /** @return true if asynchronous I/Os go through io_uring, false if they fell back to synchronous I/O */
+  auto IsAsync() const -> bool { return ring_fd_ >= 0; }
+
+ private:
+  /** An asynchronous page I/O, owned by the ring from submission until completion */
+  struct Request {
+    bool is_write_;
+    page_id_t page_id_;
+    char *page_data_;
+    std::promise<void> done_;
+    /** The buffers of a vectored write, which starts at page_id_; empty for a single page */
+    std::vector<iovec> iovecs_;
+    /** When the request was queued, the start of its latency */
+    LatencyHistogram::clock::time_point queued_at_{LatencyHistogram::clock::now()};
+  };
+
+  /** @brief Set up the ring and map its queues. Leaves ring_fd_ at -1 on failure. */
+  void SetUpRing(unsigned queue_depth);
+
+  /** @brief Unmap the queues and close the ring. */
+  void TearDownRing();
+
+  /** @brief Put a request on the submission queue, submitting the queue first if it is full. */
+  auto Queue(Request *request) -> std::future<void>;
+
+  /** @brief Hand the queued requests to the kernel. Caller should hold sq_latch_. */
+  void SubmitQueued();
+
+  /** @brief The completion thread: fulfill requests as the kernel completes them, until stopped. */
+  void ReapCompletions();
+
+  /** @brief Finish a request given the result of its I/O, retrying it synchronously if it did not fully succeed. */
+  void Complete(Request *request, int result);
+
+  /** File descriptor of the ring, -1 if io_uring is not used */
+  int ring_fd_{-1};
+
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned sq_mask_{0};
+  unsigned sq_entries_{0};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+  unsigned cq_mask_{0};
+  unsigned cq_entries_{0};
+
+  /** Protects the submission queue and the counters below */
+  std::mutex sq_latch_;
+  /** Signaled when requests complete */
+  std::condition_variable completed_cv_;
+  /** Requests on the submission queue that have not been submitted yet */
+  unsigned num_queued_{0};
+  /** Requests queued or submitted that have not completed yet. Kept below the completion queue size. */
+  unsigned num_in_flight_{0};
+
+  /** The completion thread */
+  std::thread reaper_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.h
+//
+// Identification: src/include/storage/disk/page_compressor.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * PageCompressor is a small LZ77 codec for pages, in the spirit of the LZ4 block format. Pages hold lots of zeros and
+ * repeated values, e.g. the free space in the middle of a table page or runs of similar integers, which it turns into
+ * back references to earlier bytes of the page.
+ *
+ * A compressed page is a sequence of runs. Each run starts with a token byte: the high nibble is the number of literal
+ * bytes that follow, and the low nibble the length of the match after them, minus MIN_MATCH. A nibble of 15 means the
+ * length goes on in the next bytes, each adding up to 255. The literals come next, then the 2-byte little-endian
+ * distance back to the match, then the rest of the match length. The last run has literals only.
+ *
+ * Matches never reach back more than 65535 bytes, which covers the largest page.
+ */
+class PageCompressor {
+ public:
+  /** The shortest match worth a back reference */
+  static constexpr size_t MIN_MATCH = 4;
+
+  /**
+   * Compress a page.
+   * @param src the page
+   * @param size size of the page in bytes
+   * @param[out] dst output buffer
+   * @param capacity size of the output buffer
+   * @return the size of the compressed page, or 0 if it does not fit in capacity bytes
+   */
+  static auto Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * Decompress a page.
+   * @param src the compressed page
+   * @param src_size size of the compressed page in bytes
+   * @param[out] dst output buffer
+   * @param size size of the page in bytes
+   * @return true if src decompressed to exactly size bytes, false if it is corrupt
+   */
+  static auto Decompress(const char *src, size_t src_size, char *dst, size_t size) -> bool;
+
+ private:
+  /** Number of bits of the hash of MIN_MATCH bytes that finds earlier occurrences of them */
+  static constexpr int HASH_BITS = 12;
+  /** The longest distance a back reference can span */
+  static constexpr size_t MAX_DISTANCE = 65535;
+};
+
+}  // namespace bustub
@@ -10,10 +10,15 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "buffer/page_extent.h"
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -34,15 +39,48 @@ enum class BTreeOperator { SEARCH, INSERT, DELETE };
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency: threads descend without latching the internal pages. Every page has a version that writers bump when
+ * they latch and release it, so a reader reads a page, then validates its version, and starts over from the root if a
+ * writer got in between. Before a child is trusted its parent is validated once more, which couples the two the way
+ * latch crabbing does, but without writing to the pages on the way down. Readers only latch the leaf, and point
+ * lookups not even that. Inserts and deletes write-latch the leaf; only if it could split or underflow do they start
+ * over, write-latching the path with latch crabbing and keeping the latches of every page the change may reach. The
+ * root page id is guarded by root_latch_, which sits above the root in the latch order. A thread that keeps running
+ * into writers falls back to crabbing, so it can't starve.
+ *
+ * The only latch taken against that order is a left sibling leaf during a merge or redistribution. Scans never latch
+ * the next leaf: they copy it out under its version, and if the leaf they are on changed meanwhile they seek back
+ * from the root.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  /** The pages write-latched by a change, top down. A nullptr entry stands for root_latch_. */
+  using LatchedPath = std::vector<Page *>;
+
+  /**
+   * The end of a latch-free descent: the leaf and its parent, pinned but not latched. The leaf is the one the descent
+   * was after for as long as the parent keeps its version, or, without a parent, as long as the leaf is the root.
+   */
+  struct OptimisticPath {
+    Page *leaf_{nullptr};
+    uint64_t leaf_version_{0};
+    Page *parent_{nullptr};
+    uint64_t parent_version_{0};
+  };
+
+  /** How many latch-free descents a thread starts before it falls back to latching its way down */
+  static constexpr int OPTIMISTIC_ATTEMPTS = 4;
 
  public:
+  /**
+   * @param leaf_max_size the most pairs a leaf holds, or 0 for as many as fit in a page of the database
+   * @param internal_max_size the most children an internal page has, or 0 for as many as fit in a page
+   */
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = 0, int internal_max_size = 0);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
@@ -50,13 +88,6 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
-  auto InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
-
-  template <typename N>
-  auto Split(N *node) -> N *;
-
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node, Transaction *transaction);
-
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
@@ -66,15 +97,14 @@ class BPlusTree {
   // return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
-  template <typename N>
-  auto Coalesce(N *neighbor_node, N *node,
-                                BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent, int index,
-                                Transaction *transaction) -> bool;
   // index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
   auto End() -> INDEXITERATOR_TYPE;
 
+  /** @return an iterator at the first key greater than key */
+  auto UpperBound(const KeyType &key) -> INDEXITERATOR_TYPE;
+
   // print the B+ tree
   void Print(BufferPoolManager *bpm);
 
@@ -87,29 +117,124 @@ class BPlusTree {
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
-  auto FindLeafPage(const KeyType &key, bool leftMost = false, bool rightMost = false) -> LeafPage *;
-  auto FetchPage(page_id_t page_id) -> BPlusTreePage *;
+  /**
+   * @brief Build the empty tree bottom-up out of pairs sorted by key, packing each page to fill_factor of its max size.
+   * A pair with the key of the pair before it is skipped, as Insert would reject it.
+   * @param next reads the next pair into its argument, returning false when there are none left
+   * @param fill_factor how full to pack the pages, from 0.5 to 1
+   * @return false if the tree is not empty
+   */
+  auto BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor) -> bool;
+
+  /**
+   * @brief Find the leaf that holds key, or the leftmost or rightmost leaf, and read-latch it.
+   * @return the leaf page, pinned and read-latched, or nullptr if the tree is empty
+   */
+  auto FindLeafPage(const KeyType &key, bool leftMost = false, bool rightMost = false) -> Page *;
+
+ private:
+  /**
+   * @brief Descend without latches from the root to the leaf of key, or the leftmost or rightmost leaf.
+   * @param[out] path the leaf and its parent; the leaf is nullptr if the tree is empty
+   * @return false if a writer got in the way and the descent has to start over; the path then holds nothing
+   */
+  auto DescendOptimistic(const KeyType &key, bool leftMost, bool rightMost, OptimisticPath *path) -> bool;
+
+  /** @return true if the leaf of the path is still the one its descent was after */
+  auto ValidateDescent(const OptimisticPath &path) const -> bool;
+
+  /** @brief Unpin the pages of the path. */
+  void ReleaseDescent(OptimisticPath *path);
+
+  /**
+   * @brief Find the leaf of key, or the leftmost or rightmost leaf, by latch-free descents, and latch just the leaf.
+   * @param exclusive whether to write-latch the leaf rather than read-latch it
+   * @return the leaf page, pinned and latched, or nullptr if the tree is empty or every descent ran into a writer
+   */
+  auto LatchLeafOptimistic(const KeyType &key, bool leftMost, bool rightMost, bool exclusive) -> Page *;
+
+  /**
+   * @brief Find the leaf of key for an insert or delete by latch-free descents, write-latching only the leaf.
+   * @return the leaf page, pinned and write-latched, or nullptr if the tree is empty, the change could reach the leaf's
+   * parent or every descent ran into a writer
+   */
+  auto FindLeafPageOptimistic(const KeyType &key, BTreeOperator op) -> Page *;
+
+  /**
+   * @brief Descend to the leaf of key under write latches, starting with root_latch_. The latches above a page that
+   * is safe for op are released, so the path keeps exactly the pages the change may reach, the leaf last.
+   * @return the leaf page, or nullptr if the tree is empty (the path then holds root_latch_)
+   */
+  auto FindLeafPagePessimistic(const KeyType &key, BTreeOperator op, LatchedPath *path) -> Page *;
+
+  /** @return true if op on the node can't split or underflow it, so its ancestors are not reached */
+  auto IsSafe(BPlusTreePage *node, BTreeOperator op) const -> bool;
+
+  /** @brief Release and unpin every page of the path, and root_latch_ if the path holds it. */
+  void ReleasePath(LatchedPath *path, bool is_dirty);
+
+  void CreateRoot(const KeyType &key, const ValueType &value);
+
+  auto InsertIntoLeaf(const KeyType &key, const ValueType &value, LatchedPath *path) -> bool;
+
+  /**
+   * @brief Link new_node, split off old_node at path level, into old_node's parent, splitting the parent in turn if
+   * it overflows.
+   */
+  void InsertIntoParent(LatchedPath *path, size_t level, BPlusTreePage *old_node, const KeyType &key,
+                        BPlusTreePage *new_node);
 
   template <typename N>
-  auto FindSibling(N *node,N *&sibling_node_out) -> bool;
-  void AdjustRoot(BPlusTreePage *old_root_node);
+  auto Split(N *node) -> N *;
 
+  /**
+   * @brief Fix up the underflowed node at path level by borrowing from or merging with a sibling, recursing up the
+   * path as merges shrink the parents.
+   * @param[out] deleted the pages emptied by merges, to delete once every latch is released
+   */
   template <typename N>
-  void Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index, bool from_prev);
+  void CoalesceOrRedistribute(LatchedPath *path, size_t level, std::vector<page_id_t> *deleted);
 
   template <typename N>
-  auto CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool;
+  void Coalesce(N *neighbor_node, N *node, InternalPage *parent, int index);
 
-//  void MoveFirstToEnd(LeafPage *sibling_node,LeafPage *node);
-//  void MoveLastToStart(LeafPage *sibling_page,LeafPage *node,int node_index);
-//  void MoveLastToStart(InternalPage *sibling_page,InternalPage *node);
-//  void MoveFirstToEnd(InternalPage *sibling_page, InternalPage *node);
+  template <typename N>
+  void Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index, bool from_prev);
 
- private:
+  void AdjustRoot(BPlusTreePage *old_root_node, std::vector<page_id_t> *deleted);
+
+  /**
+   * @brief Delete pages that no longer belong to the tree, and retry the ones earlier calls could not delete. The
+   * buffer pool refuses to delete a page that is pinned, e.g. by a scan or a latch-free reader on its way past, so
+   * such pages are kept on deferred_deletes_ until a later change that latches its way down tries again.
+   * @param page_ids the pages to delete, which nothing in the tree links to any more
+   */
+  void DeletePages(const std::vector<page_id_t> &page_ids);
 
   void UpdateRootPageId(int insert_record = 0);
 
-  void CreateRoot(const KeyType &key, const ValueType &value);
+  /** A level of a tree being bulk loaded, leaves first: the page being filled and the one filled before, both pinned */
+  struct BulkLevel {
+    Page *page_{nullptr};
+    Page *prev_{nullptr};
+  };
+
+  /**
+   * @brief Start a new page at level of a bulk load. The page being filled there is full; it is linked into the level
+   * above and becomes the previous page.
+   * @param internal_fill how many children to pack into an internal page
+   */
+  auto BulkStartPage(std::vector<BulkLevel> *levels, size_t level, int internal_fill) -> Page *;
+
+  /** @brief Link the page being filled at level into the level above, with its first key as the separator. */
+  void BulkLinkPage(std::vector<BulkLevel> *levels, size_t level, int internal_fill);
+
+  /**
+   * @brief Bring the last page of a level up to its min size by moving pairs over from the page before it, or merge it
+   * into that page if the two fit in one.
+   * @return true if the last page was merged and is left empty
+   */
+  auto BulkFixLastPage(const BulkLevel &level) -> bool;
 
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out) const;
@@ -118,12 +243,20 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  /** Read without root_latch_ only by IsEmpty and the debug routines */
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
-  std::mutex latch_;
+  /** Guards root_page_id_; held in write mode by changes that may replace the root */
+  ReaderWriterLatch root_latch_;
+  /** New nodes of the tree come from its own runs of consecutive pages */
+  PageExtent extent_;
+  /** Guards deferred_deletes_ */
+  std::mutex deferred_latch_;
+  /** Pages unlinked from the tree that were still pinned when they were deleted, see DeletePages */
+  std::vector<page_id_t> deferred_deletes_;
 };
 
 }  // namespace bustub
@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -35,6 +36,13 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /**
+   * Fill the empty index with the entries of its table at once. The entries are sorted, in runs spilled to temporary
+   * files past index_build_memory bytes, and the tree is built bottom-up with its pages index_fill_factor full.
+   * @param next reads the key and RID of the next entry, returning false when there are none left
+   */
+  void BulkLoad(const std::function<bool(Tuple *key, RID *rid)> &next, Transaction *transaction);
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sorter.h
+//
+// Identification: src/include/storage/index/external_sorter.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ExternalSorter sorts more items than fit in its memory budget. Items are buffered until the budget is used up, then
+ * sorted and spilled to a temporary file as a run. Sort merges the runs in one pass, each read through an equal share
+ * of the budget, so the sorter never holds more than the budget in memory. Items are spilled as raw bytes, so they must
+ * be plain data, like the key and RID pairs of an index.
+ */
+template <typename T, typename Compare>
+class ExternalSorter {
+ public:
+  /**
+   * @param compare the less-than order to sort in
+   * @param memory_limit the bytes of items to hold in memory at most
+   */
+  ExternalSorter(Compare compare, size_t memory_limit)
+      : compare_(std::move(compare)), max_items_(std::max<size_t>(memory_limit / sizeof(T), 2)) {}
+
+  DISALLOW_COPY_AND_MOVE(ExternalSorter);
+
+  /** @brief Add an item to sort. Must be called before Sort. */
+  void Add(const T &item) {
+    buffer_.push_back(item);
+    size_++;
+    if (buffer_.size() == max_items_) {
+      SpillRun();
+    }
+  }
+
+  /** @brief Finish adding items. Next then returns them in order. */
+  void Sort() {
+    if (runs_.empty()) {
+      std::sort(buffer_.begin(), buffer_.end(), compare_);
+      return;
+    }
+    if (!buffer_.empty()) {
+      SpillRun();
+    }
+    std::vector<T>().swap(buffer_);
+
+    run_items_ = std::max<size_t>(max_items_ / runs_.size(), 1);
+    for (size_t i = 0; i < runs_.size(); i++) {
+      rewind(runs_[i].file_.get());
+      if (Refill(&runs_[i])) {
+        merge_.push(i);
+      }
+    }
+  }
+
+  /**
+   * @param[out] item the next item in order
+   * @return false if every item was returned already
+   */
+  auto Next(T *item) -> bool {
+    if (runs_.empty()) {
+      if (next_ == buffer_.size()) {
+        return false;
+      }
+      *item = buffer_[next_++];
+      return true;
+    }
+
+    if (merge_.empty()) {
+      return false;
+    }
+    const size_t index = merge_.top();
+    merge_.pop();
+    auto &run = runs_[index];
+    *item = run.buffer_[run.next_++];
+    if (run.next_ < run.buffer_.size() || Refill(&run)) {
+      merge_.push(index);
+    }
+    return true;
+  }
+
+  /** @return the number of items added */
+  auto Size() const -> size_t { return size_; }
+
+  /** @return the number of runs spilled to disk, 0 if the items were sorted in memory */
+  auto NumRuns() const -> size_t { return runs_.size(); }
+
+ private:
+  struct Run {
+    std::unique_ptr<FILE, int (*)(FILE *)> file_{nullptr, fclose};
+    /** The items of the run read back from its file, and the next one to return */
+    std::vector<T> buffer_;
+    size_t next_{0};
+  };
+
+  /** Orders the runs of the merge heap by their next item, smallest on top */
+  struct RunGreater {
+    auto operator()(size_t lhs, size_t rhs) const -> bool {
+      const auto &left = (*runs_)[lhs];
+      const auto &right = (*runs_)[rhs];
+      return (*compare_)(right.buffer_[right.next_], left.buffer_[left.next_]);
+    }
+    const std::vector<Run> *runs_;
+    const Compare *compare_;
+  };
+
+  void SpillRun() {
+    std::sort(buffer_.begin(), buffer_.end(), compare_);
+    Run run;
+    run.file_.reset(tmpfile());
+    if (run.file_ == nullptr ||
+        fwrite(buffer_.data(), sizeof(T), buffer_.size(), run.file_.get()) != buffer_.size()) {
+      throw Exception("can't spill a sort run to a temporary file");
+    }
+    buffer_.clear();
+    runs_.push_back(std::move(run));
+  }
+
+  /** @return false if the run has no items left */
+  auto Refill(Run *run) -> bool {
+    run->buffer_.resize(run_items_);
+    run->buffer_.resize(fread(run->buffer_.data(), sizeof(T), run_items_, run->file_.get()));
+    run->next_ = 0;
+    return !run->buffer_.empty();
+  }
+
+  Compare compare_;
+  const size_t max_items_;
+  /** How many items of each run are read back at a time while merging */
+  size_t run_items_{0};
+  /** Items added since the last spill; all of them if the sorter never spilled */
+  std::vector<T> buffer_;
+  size_t next_{0};
+  size_t size_{0};
+  std::vector<Run> runs_;
+  std::priority_queue<size_t, std::vector<size_t>, RunGreater> merge_{RunGreater{&runs_, &compare_}};
+};
+
+}  // namespace bustub
@@ -13,7 +13,9 @@
 #pragma once
 
 #include <cstring>
+#include <limits>
 
+#include "storage/index/key_block_search.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -50,6 +52,16 @@ class GenericKey {
       data_ptr = (data_ + col.GetOffset());
     } else {
       int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
+      // A reader that doesn't latch the page may see a key half written, and validates the page only after comparing:
+      // until then, an offset or a length that would take the value out of the key is read as NULL.
+      if (offset < 0 || static_cast<size_t>(offset) > KeySize - sizeof(uint32_t)) {
+        return Value(column_type);
+      }
+      uint32_t length;
+      memcpy(&length, data_ + offset, sizeof(uint32_t));
+      if (length != BUSTUB_VALUE_NULL && length > KeySize - offset - sizeof(uint32_t)) {
+        return Value(column_type);
+      }
       data_ptr = (data_ + offset);
     }
     return Value::DeserializeFrom(data_ptr, column_type);
@@ -72,11 +84,20 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Keys of one INTEGER or BIGINT column are compared as integers, without building values. NULLs, which are stored as the
+ * smallest integer, then sort first instead of comparing equal to every key.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
+    if (integer_width_ != 0) {
+      const int64_t lhs_value = IntegerOf(lhs);
+      const int64_t rhs_value = IntegerOf(rhs);
+      return lhs_value < rhs_value ? -1 : (lhs_value > rhs_value ? 1 : 0);
+    }
+
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
@@ -94,13 +115,94 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  /**
+   * Count the keys of a key block of a B+tree page that are less than key, or not greater than it if or_equal is set.
+   * Integer keys of 4 and 8 bytes are compared a block at a time, see key_block_search.h; others by binary search.
+   * @param block the first key of the block, which holds KEY_BLOCK_SIZE bytes of keys or one key if they are larger
+   * @param from the first key of the block to count
+   * @param to one past the last key of the block to count
+   */
+  inline auto CountLess(const GenericKey<KeySize> *block, int from, int to, const GenericKey<KeySize> &key,
+                        bool or_equal) const -> int {
+    if constexpr (KeySize == sizeof(int32_t) || KeySize == sizeof(int64_t)) {
+      if (integer_width_ != 0) {
+        // For integers, not greater than key is less than the next integer.
+        int64_t value = IntegerOf(key);
+        if (or_equal) {
+          const int64_t max = integer_width_ == sizeof(int32_t) ? std::numeric_limits<int32_t>::max()
+                                                                : std::numeric_limits<int64_t>::max();
+          if (value == max) {
+            return to - from;
+          }
+          value++;
+        }
+        const auto *keys = reinterpret_cast<const char *>(block);
+        if constexpr (KeySize == sizeof(int32_t)) {
+          return KeyBlockCountLess32(keys, from, to, static_cast<int32_t>(value));
+        } else if (integer_width_ == sizeof(int32_t)) {
+          // The integer is the lower half of the key, so the upper half is shifted out.
+          return KeyBlockCountLess64(keys, from, to, static_cast<int64_t>(static_cast<uint64_t>(value) << 32), 32);
+        } else {
+          return KeyBlockCountLess64(keys, from, to, value, 0);
+        }
+      }
+    }
+
+    const int first = from;
+    while (from < to) {
+      const int mid = from + (to - from) / 2;
+      const int cmp = (*this)(block[mid], key);
+      if (cmp < 0 || (or_equal && cmp == 0)) {
+        from = mid + 1;
+      } else {
+        to = mid;
+      }
+    }
+    return from - first;
+  }
+
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, integer_width_{other.integer_width_} {}
 
   // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  explicit GenericComparator(Schema *key_schema)
+      : key_schema_(key_schema), integer_width_(IntegerWidthOf(key_schema)) {}
 
  private:
+  /** @return the width of the integer that keys of the schema are compared by, or 0 if they are compared as values */
+  static auto IntegerWidthOf(const Schema *key_schema) -> int {
+    if (key_schema == nullptr || key_schema->GetColumnCount() != 1) {
+      return 0;
+    }
+    int width = 0;
+    switch (key_schema->GetColumn(0).GetType()) {
+      case TypeId::INTEGER:
+        width = sizeof(int32_t);
+        break;
+      case TypeId::BIGINT:
+        width = sizeof(int64_t);
+        break;
+      default:
+        break;
+    }
+    return width <= static_cast<int>(KeySize) ? width : 0;
+  }
+
+  inline auto IntegerOf(const GenericKey<KeySize> &key) const -> int64_t {
+    if constexpr (KeySize >= sizeof(int64_t)) {
+      if (integer_width_ == sizeof(int64_t)) {
+        int64_t value;
+        memcpy(&value, key.data_, sizeof(int64_t));
+        return value;
+      }
+    }
+    int32_t value;
+    memcpy(&value, key.data_, sizeof(int32_t));
+    return value;
+  }
+
   Schema *key_schema_;
+  int integer_width_;
 };
 
 }  // namespace bustub
@@ -14,21 +14,44 @@
  */
 #pragma once
 
+#include <optional>
+#include <vector>
+
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+    template <typename KeyType, typename ValueType, typename KeyComparator>
+    class BPlusTree;
+
+    /**
+     * An iterator over the pairs of a B+ tree in key order. It holds no latch: it copies out the pairs of the leaf it
+     * is on and keeps the leaf pinned, along with the version the copy was taken at. An end iterator only records a
+     * position and holds nothing.
+     */
     INDEX_TEMPLATE_ARGUMENTS
     class IndexIterator {
     public:
-        IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *bufferPoolManager);
+        /** An iterator positioned at index in the leaf on page, which is read-latched; the iterator releases the
+         * latch once it has copied the leaf, and takes over the pin. If the leaf was searched for seek_key, the
+         * iterator never goes back to keys not greater than it. */
+        IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, Page *page, int index,
+                      BufferPoolManager *bufferPoolManager, std::optional<KeyType> seek_key = std::nullopt);
+
+        /** An end iterator at index in the leaf with the given page id */
+        IndexIterator(page_id_t page_id, int index);
 
         IndexIterator();
 
         ~IndexIterator();// NOLINT
 
+        IndexIterator(const IndexIterator &) = delete;
+        auto operator=(const IndexIterator &) -> IndexIterator & = delete;
+        IndexIterator(IndexIterator &&other) noexcept;
+        auto operator=(IndexIterator &&other) noexcept -> IndexIterator &;
+
         auto IsEnd() -> bool;
 
         auto operator*() -> const MappingType &;
@@ -36,7 +59,7 @@ namespace bustub {
         auto operator++() -> IndexIterator &;
 
         auto operator==(const IndexIterator &itr) const -> bool {
-            return leaf_ == itr.leaf_ && index_ == itr.index_;
+            return page_id_ == itr.page_id_ && index_ == itr.index_;
         }
 
         auto operator!=(const IndexIterator &itr) const -> bool {
@@ -44,10 +67,43 @@ namespace bustub {
         }
 
     private:
+        /** Let go of the leaf, if any. */
+        void Release();
+
+        /** Move past the end of leaves that have no pairs left to visit. */
+        void SkipExhaustedLeaves();
+
+        /** @brief Copy the pairs and sibling link of a leaf, which may be torn unless its version validates after. */
+        void CopyLeaf(Page *page);
+
+        /**
+         * @brief Move on to the next leaf, copying it without a latch. The copy is only used if neither leaf was
+         * written meanwhile, so that this leaf still linked to it; otherwise the iterator seeks to the key after the
+         * last one of this leaf, or after the seek key if none of its pairs was visited, from the root.
+         */
+        void MoveToNextLeaf();
+
+        /**
+         * @brief Called when the scan moves on to a leaf. Every half window, asks the buffer pool to read the next
+         * window of leaves ahead, following the sibling links from this leaf.
+         * @param page_id id of the leaf the scan moved on to
+         */
+        void ReadAhead(page_id_t page_id);
+
         // add your own private member variables here
-        int index_;
-        B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_;
-        BufferPoolManager *buffer_pool_manager_;
+        BPlusTree<KeyType, ValueType, KeyComparator> *tree_{nullptr};
+        /** The leaf the pairs were copied from, pinned, and its version at the time */
+        Page *page_{nullptr};
+        uint64_t version_{0};
+        std::vector<MappingType> items_;
+        /** The key the leaf was searched for, while the scan has visited none of its pairs */
+        std::optional<KeyType> seek_key_;
+        page_id_t next_page_id_{INVALID_PAGE_ID};
+        page_id_t page_id_{INVALID_PAGE_ID};
+        int index_{0};
+        BufferPoolManager *buffer_pool_manager_{nullptr};
+        /** Leaves to move on to before the next read-ahead */
+        size_t pages_until_read_ahead_{0};
     };
 
 }// namespace bustub
@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_block_search.h
+//
+// Identification: src/include/storage/index/key_block_search.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "common/config.h"
+
+namespace bustub {
+
+/*
+ * A key block is KEY_BLOCK_SIZE bytes of sorted integer keys, as B+tree pages store them. The functions below count
+ * the keys of a block that are less than a key, looking only at the keys in [from, to): the others may hold anything,
+ * but the whole block must be readable. With AVX2 or SSE the whole block is compared at once, without branches.
+ *
+ * The instruction set is chosen at compile time. A default x86-64 build has SSE2, so only 4-byte keys are compared with
+ * SIMD; 8-byte keys need SSE4.2, and AVX2 widens both. Configure with -DBUSTUB_ISA=sse4.2 or -DBUSTUB_ISA=avx2 to build
+ * for them.
+ */
+
+/** @return a mask of the lanes in [from, to) */
+inline auto KeyBlockLanes(int from, int to) -> uint32_t { return ((1U << to) - 1) & ~((1U << from) - 1); }
+
+/**
+ * @param block the key block, of 8-byte keys
+ * @param shift how far each key is shifted left before it is compared, 32 for 4-byte integers in 8-byte keys
+ * @return how many of the keys in [from, to) are less than key
+ */
+inline auto KeyBlockCountLess64(const char *block, int from, int to, int64_t key, int shift) -> int {
+  constexpr int lanes = KEY_BLOCK_SIZE / sizeof(int64_t);
+  static_assert(lanes < 32, "a key block must fit in the lane mask");
+#if defined(__AVX2__)
+  uint32_t less = 0;
+  const __m256i target = _mm256_set1_epi64x(key);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+  for (int i = 0; i < lanes; i += 4) {
+    __m256i keys = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i * sizeof(int64_t)));
+    keys = _mm256_sll_epi64(keys, count);
+    const __m256i greater = _mm256_cmpgt_epi64(target, keys);
+    less |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(greater))) << i;
+  }
+  return __builtin_popcount(less & KeyBlockLanes(from, to));
+#elif defined(__SSE4_2__)
+  uint32_t less = 0;
+  const __m128i target = _mm_set1_epi64x(key);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+  for (int i = 0; i < lanes; i += 2) {
+    __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * sizeof(int64_t)));
+    keys = _mm_sll_epi64(keys, count);
+    const __m128i greater = _mm_cmpgt_epi64(target, keys);
+    less |= static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(greater))) << i;
+  }
+  return __builtin_popcount(less & KeyBlockLanes(from, to));
+#else
+  int less = 0;
+  for (int i = from; i < to; i++) {
+    uint64_t bits;
+    memcpy(&bits, block + i * sizeof(int64_t), sizeof(int64_t));
+    less += static_cast<int>(static_cast<int64_t>(bits << shift) < key);
+  }
+  return less;
+#endif
+}
+
+/**
+ * @param block the key block, of 4-byte keys
+ * @return how many of the keys in [from, to) are less than key
+ */
+inline auto KeyBlockCountLess32(const char *block, int from, int to, int32_t key) -> int {
+  constexpr int lanes = KEY_BLOCK_SIZE / sizeof(int32_t);
+  static_assert(lanes < 32, "a key block must fit in the lane mask");
+#if defined(__AVX2__)
+  uint32_t less = 0;
+  const __m256i target = _mm256_set1_epi32(key);
+  for (int i = 0; i < lanes; i += 8) {
+    const __m256i keys = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + i * sizeof(int32_t)));
+    const __m256i greater = _mm256_cmpgt_epi32(target, keys);
+    less |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(greater))) << i;
+  }
+  return __builtin_popcount(less & KeyBlockLanes(from, to));
+#elif defined(__SSE2__)
+  uint32_t less = 0;
+  const __m128i target = _mm_set1_epi32(key);
+  for (int i = 0; i < lanes; i += 4) {
+    const __m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + i * sizeof(int32_t)));
+    const __m128i greater = _mm_cmpgt_epi32(target, keys);
+    less |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(greater))) << i;
+  }
+  return __builtin_popcount(less & KeyBlockLanes(from, to));
+#else
+  int less = 0;
+  for (int i = from; i < to; i++) {
+    int32_t value;
+    memcpy(&value, block + i * sizeof(int32_t), sizeof(int32_t));
+    less += static_cast<int>(value < key);
+  }
+  return less;
+#endif
+}
+
+}  // namespace bustub
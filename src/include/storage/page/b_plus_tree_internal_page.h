@@ -19,7 +19,7 @@ namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
 #define INTERNAL_PAGE_HEADER_SIZE 24
-#define INTERNAL_PAGE_SIZE ((BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
+#define INTERNAL_PAGE_SIZE (BPlusTreeSlots<KeyType, ValueType>::Capacity(BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE))
 
     /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
@@ -29,15 +29,22 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Internal page format (keys are stored in increasing order, in blocks of m keys, see BPlusTreeSlots):
+ *  ---------------------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) ... KEY(m) | PAGE_ID(1) ... PAGE_ID(m) | KEY(m+1) ... KEY(2m) | PAGE_ID(m+1) ... |
+ *  ---------------------------------------------------------------------------------------------------
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
+  /**
+   * @return the largest max size of an internal page in a database with the given page size. A page holds one pair more
+   * than its max size right before it splits, so one slot is left for it.
+   */
+  static auto MaxSizeFor(int page_size) -> int {
+    return BPlusTreeSlots<KeyType, ValueType>::Capacity(page_size - INTERNAL_PAGE_HEADER_SIZE) - 1;
+  }
 
   auto KeyAt(int index) const -> KeyType;
   void SetKeyAt(int index, const KeyType &key);
@@ -49,12 +56,17 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,const ValueType &new_value);
   void MoveHalfTo(BPlusTreeInternalPage *recipient,BufferPoolManager *buffer_pool_manager);
   auto Lookup(const KeyType &key,const KeyComparator &comparator) const -> ValueType;
+  /**
+   * Lookup over the first size pairs, for readers that don't latch the page: they read the size once and bound it,
+   * since a writer may be changing the page under them.
+   */
+  auto Lookup(const KeyType &key,const KeyComparator &comparator, int size) const -> ValueType;
   void Remove(int index);
   void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,BufferPoolManager *buffer_pool_manager);
 
-  auto GetItem(int index) -> MappingType &;
+  auto GetItem(int index) const -> MappingType;
 
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
+  void CopyNFrom(const BPlusTreeInternalPage *source, int index, int size, BufferPoolManager *buffer_pool_manager);
 
   void SetItem(const KeyType &key,const ValueType &val,int index);
 
@@ -69,7 +81,19 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void CopyFirstFrom(const MappingType &pair,BufferPoolManager *buffer_pool_manager);
 
  private:
-  // Flexible array member for page data. 用于页面数据的灵活数组成员。
-  MappingType array_[1];
+  using Slots = BPlusTreeSlots<KeyType, ValueType>;
+  auto KeyRef(int index) -> KeyType & { return *reinterpret_cast<KeyType *>(slots_ + Slots::KeyOffset(index)); }
+  auto ValueRef(int index) -> ValueType & { return *reinterpret_cast<ValueType *>(slots_ + Slots::ValueOffset(index)); }
+  auto KeyRef(int index) const -> const KeyType & {
+    return *reinterpret_cast<const KeyType *>(slots_ + Slots::KeyOffset(index));
+  }
+  auto ValueRef(int index) const -> const ValueType & {
+    return *reinterpret_cast<const ValueType *>(slots_ + Slots::ValueOffset(index));
+  }
+  /** Move the pairs from index on by offset slots, towards the end if it is positive. The size is left as it is. */
+  void ShiftPairs(int index, int offset);
+
+  // Flexible array member for page data, laid out by Slots. 用于页面数据的灵活数组成员。
+  char slots_[1];
 };
 }  // namespace bustub
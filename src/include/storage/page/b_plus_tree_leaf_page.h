@@ -19,16 +19,16 @@ namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
 #define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_SIZE (BPlusTreeSlots<KeyType, ValueType>::Capacity(BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE))
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * Leaf page format (keys are stored in order, in blocks of m keys, see BPlusTreeSlots):
+ *  ---------------------------------------------------------------------------------------
+ * | HEADER | KEY(1) ... KEY(m) | RID(1) ... RID(m) | KEY(m+1) ... KEY(2m) | RID(m+1) ... |
+ *  ---------------------------------------------------------------------------------------
  *
  *  Header format (size in byte, 28 bytes in total):
  *  ---------------------------------------------------------------------
@@ -44,23 +44,32 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
+  /**
+   * @return the largest max size of a leaf page in a database with the given page size. A page holds one pair more
+   * than its max size right before it splits, so one slot is left for it.
+   */
+  static auto MaxSizeFor(int page_size) -> int {
+    return BPlusTreeSlots<KeyType, ValueType>::Capacity(page_size - LEAF_PAGE_HEADER_SIZE) - 1;
+  }
   // helper methods
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
   auto ValueAt(int index) const -> ValueType;
   auto KeyIndex(const KeyType &key,const KeyComparator &comparator) const -> int;
+  /** KeyIndex over the first size pairs, for readers that don't latch the page and bound the size they read */
+  auto KeyIndex(const KeyType &key,const KeyComparator &comparator, int size) const -> int;
   auto Find(const KeyType &key,const KeyComparator &comparator,ValueType *val_out) const -> bool;
   void Insert(const KeyType &key, const ValueType &val, const KeyComparator &comparator);
   void DirectInsert(const KeyType &key, const ValueType &val);
   void MoveHalfTo(BPlusTreeLeafPage *recipient, BufferPoolManager *buffer_pool_manager);
-  auto GetItem(int index) -> const MappingType&;
+  auto GetItem(int index) const -> MappingType;
   auto Lookup(const KeyType &key, ValueType &value,const KeyComparator &comparator) const -> bool;
   auto KeyIndexPrecise(const KeyType &key,const KeyComparator &comparator) const -> int;
   void Remove(const KeyType &key,const KeyComparator &comparator);
 
   void MoveAllTo(BPlusTreeLeafPage *recipient);
-  void CopyNFrom(MappingType *items, int size);
+  void CopyNFrom(const BPlusTreeLeafPage *source, int index, int size);
   void SetItem(const KeyType &key,const ValueType &val,int index);
 //  void MoveFirstToEnd(BPlusTreeLeafPage *sibling_page,BufferPoolManager *bufferPoolManager);
 //  void MoveLastToStart(BPlusTreeLeafPage *sibling_page,BufferPoolManager *bufferPoolManager,int node_index);
@@ -72,8 +81,20 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
 
  private:
+  using Slots = BPlusTreeSlots<KeyType, ValueType>;
+  auto KeyRef(int index) -> KeyType & { return *reinterpret_cast<KeyType *>(slots_ + Slots::KeyOffset(index)); }
+  auto ValueRef(int index) -> ValueType & { return *reinterpret_cast<ValueType *>(slots_ + Slots::ValueOffset(index)); }
+  auto KeyRef(int index) const -> const KeyType & {
+    return *reinterpret_cast<const KeyType *>(slots_ + Slots::KeyOffset(index));
+  }
+  auto ValueRef(int index) const -> const ValueType & {
+    return *reinterpret_cast<const ValueType *>(slots_ + Slots::ValueOffset(index));
+  }
+  /** Move the pairs from index on by offset slots, towards the end if it is positive. The size is left as it is. */
+  void ShiftPairs(int index, int offset);
+
   page_id_t next_page_id_;
-  // Flexible array member for page data.
-  MappingType array_[1];
+  // Flexible array member for page data, laid out by Slots.
+  char slots_[1];
 };
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <climits>
 #include <cstdlib>
@@ -72,4 +73,70 @@ class BPlusTreePage {
   page_id_t page_id_ __attribute__((__unused__));
 };
 
+/**
+ * The pairs of leaf and internal pages are stored in blocks: the keys of a block fill KEY_BLOCK_SIZE bytes, a cache
+ * line, and are followed by the values of the block. A search then reads only keys, compares a block of them at once
+ * (see GenericComparator::CountLess), and finds the block to compare by the last key of each block. A block holds one
+ * key if keys are larger than KEY_BLOCK_SIZE. Where a pair is stored depends on its index alone, not on the page's max
+ * size, so readers that don't latch a page never read outside of it.
+ */
+template <typename KeyType, typename ValueType>
+class BPlusTreeSlots {
+ public:
+  static constexpr int KEYS_PER_BLOCK =
+      sizeof(KeyType) < KEY_BLOCK_SIZE ? static_cast<int>(KEY_BLOCK_SIZE / sizeof(KeyType)) : 1;
+  static constexpr size_t BLOCK_SIZE = KEYS_PER_BLOCK * (sizeof(KeyType) + sizeof(ValueType));
+
+  /** @return the number of pairs that fit in size bytes; a block that is cut short still takes all of its keys */
+  static constexpr auto Capacity(size_t size) -> int {
+    const size_t rest = size % BLOCK_SIZE;
+    const size_t keys = KEYS_PER_BLOCK * sizeof(KeyType);
+    const size_t tail = rest > keys ? (rest - keys) / sizeof(ValueType) : 0;
+    return static_cast<int>(size / BLOCK_SIZE * KEYS_PER_BLOCK + tail);
+  }
+
+  static constexpr auto KeyOffset(int index) -> size_t {
+    return index / KEYS_PER_BLOCK * BLOCK_SIZE + index % KEYS_PER_BLOCK * sizeof(KeyType);
+  }
+
+  static constexpr auto ValueOffset(int index) -> size_t {
+    return index / KEYS_PER_BLOCK * BLOCK_SIZE + KEYS_PER_BLOCK * sizeof(KeyType) +
+           index % KEYS_PER_BLOCK * sizeof(ValueType);
+  }
+
+  /**
+   * Binary search the keys in [first, last).
+   * @param upper false to find the first key not less than key, true to find the first key greater than key
+   * @return the index of that key, or last if there is none
+   */
+  template <typename KeyComparator>
+  static auto Search(const char *slots, int first, int last, const KeyType &key, const KeyComparator &comparator,
+                     bool upper) -> int {
+    if (first >= last) {
+      return last;
+    }
+    // Every block before the last one is full, so its last key is within [first, last).
+    int low = first / KEYS_PER_BLOCK;
+    int high = (last - 1) / KEYS_PER_BLOCK;
+    while (low < high) {
+      const int mid = low + (high - low) / 2;
+      const int cmp = comparator(*KeyIn(slots, (mid + 1) * KEYS_PER_BLOCK - 1), key);
+      if (cmp > 0 || (cmp == 0 && !upper)) {
+        high = mid;
+      } else {
+        low = mid + 1;
+      }
+    }
+    const int base = low * KEYS_PER_BLOCK;
+    const int from = std::max(first, base) - base;
+    const int to = std::min(last, base + KEYS_PER_BLOCK) - base;
+    return base + from + comparator.CountLess(KeyIn(slots, base), from, to, key, upper);
+  }
+
+ private:
+  static auto KeyIn(const char *slots, int index) -> const KeyType * {
+    return reinterpret_cast<const KeyType *>(slots + KeyOffset(index));
+  }
+};
+
 }  // namespace bustub
@@ -19,16 +19,45 @@ namespace bustub {
 /**
  * Database use the first page (page_id = 0) as header page to store metadata, in
  * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * 32 bytes) and their corresponding root_id. It also records the page size of the
+ * database, which the disk manager reads before it can read any page.
  *
  * Format (size in byte):
- *  -----------------------------------------------------------------
+ *  --------------------------------------------------------------------------------------------
+ * | Magic (4) | PageSize (4) | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
+ *  --------------------------------------------------------------------------------------------
+ *
+ * A header page without the magic is in the legacy format of 4K databases, which is read as it is and converted
+ * on the first change:
+ *  ------------------------------------------------------------------
  * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
- *  -----------------------------------------------------------------
+ *  ------------------------------------------------------------------
  */
 class HeaderPage : public Page {
  public:
-  void Init() { SetRecordCount(0); }
+  /** Marks a page 0 that has been formatted as a header page */
+  static constexpr uint32_t MAGIC = 0x50485442;
+  static constexpr size_t OFFSET_MAGIC = 0;
+  static constexpr size_t OFFSET_PAGE_SIZE = 4;
+  static constexpr size_t OFFSET_RECORD_COUNT = 8;
+  static constexpr size_t OFFSET_RECORDS = 12;
+  static constexpr size_t RECORD_SIZE = 36;
+  static constexpr size_t LEGACY_OFFSET_RECORD_COUNT = 0;
+  static constexpr size_t LEGACY_OFFSET_RECORDS = 4;
+  /** The page size of a database whose header page is in the legacy format */
+  static constexpr int LEGACY_PAGE_SIZE = 4096;
+
+  void Init() {
+    SetPageSize();
+    SetRecordCount(0);
+  }
+
+  /**
+   * Read the page size recorded in the first OFFSET_RECORD_COUNT bytes of a header page.
+   * @return the page size, LEGACY_PAGE_SIZE for a legacy header page, or 0 if the bytes are all zero
+   */
+  static auto ReadPageSize(const char *data) -> int;
+
   /**
    * Record related
    */
@@ -46,6 +75,18 @@ class HeaderPage : public Page {
    */
   auto FindRecord(const std::string &name) -> int;
 
+  /** @return whether the page is in the current format, rather than the legacy one */
+  auto IsFormatted() -> bool;
+
+  /** @return the offset of the first record, in the format the page is in */
+  auto RecordsOffset() -> size_t;
+
+  /** Convert a legacy header page to the current format, moving its records after the page size. */
+  void Format();
+
   void SetRecordCount(int record_count);
+
+  /** Record the page size of the database, marking the page as formatted. */
+  void SetPageSize();
 };
 }  // namespace bustub
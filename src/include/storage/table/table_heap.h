@@ -12,7 +12,10 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/page_extent.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
@@ -99,7 +102,10 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true) -> bool;
 
-  /** @return the begin iterator of this table */
+  /**
+   * @return the begin iterator of this table. If the table takes up more than a quarter of the buffer pool, the
+   * iterator reads it through a bulk-read ring so that the scan does not flush the rest of the pool.
+   */
   auto Begin(Transaction *txn) -> TableIterator;
 
   /** @return the end iterator of this table */
@@ -108,11 +114,17 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the number of pages of this table */
+  inline auto GetNumPages() const -> size_t { return num_pages_; }
+
  private:
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  std::atomic<size_t> num_pages_{0};
+  /** New pages of the table come from its own runs of consecutive pages */
+  PageExtent extent_;
 };
 
 }  // namespace bustub
@@ -13,7 +13,10 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
+#include <utility>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +32,15 @@ class TableIterator {
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        pages_until_read_ahead_(other.pages_until_read_ahead_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -54,13 +62,26 @@ class TableIterator {
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    pages_until_read_ahead_ = other.pages_until_read_ahead_;
     return *this;
   }
 
  private:
+  /**
+   * @brief Called when the scan moves on to a page. Every half window, asks the buffer pool to read the next window
+   * of pages ahead, following the next_page_id chain from this page.
+   * @param page_id id of the page the scan moved on to
+   */
+  void ReadAhead(page_id_t page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** Access strategy for the pages the scan moves on to, nullptr for scans that may use the whole buffer pool */
+  std::shared_ptr<BufferAccessStrategy> strategy_;
+  /** Pages to move on to before the next read-ahead */
+  size_t pages_until_read_ahead_{0};
 };
 
 }  // namespace bustub
@@ -10,17 +10,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <limits.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
+#include <future>  // NOLINT
 #include <iostream>
-#include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
 
@@ -30,7 +37,7 @@ static char *buffer_used;
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, int page_size) : file_name_(db_file) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -49,77 +56,358 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
-    }
+  // open the db file, creating it if it does not exist
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
   }
+  LoadPageSize(page_size);
+  fsm_name_ = file_name_.substr(0, n) + ".fsm";
+  LoadFreeMap();
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  if (fsm_fd_ >= 0) {
+    WriteFreeMap();
+    close(fsm_fd_);
+  }
+  if (direct_fd_ >= 0) {
+    close(direct_fd_);
+  }
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  if (fsm_fd_ >= 0) {
+    std::scoped_lock<std::mutex> lock(alloc_latch_);
+    WriteFreeMap();
+    close(fsm_fd_);
+    fsm_fd_ = -1;
+  }
+  if (direct_fd_ >= 0) {
+    close(direct_fd_);
+    direct_fd_ = -1;
+  }
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
   }
   log_io_.close();
 }
 
+auto DiskManager::EnableDirectIO() -> bool {
+  if (direct_fd_ >= 0) {
+    return true;
+  }
+  if (db_fd_ < 0 || page_size_ % DIRECT_IO_ALIGNMENT != 0) {
+    return false;
+  }
+#ifdef O_DIRECT
+  direct_fd_ = open(file_name_.c_str(), O_RDWR | O_DIRECT);
+  if (direct_fd_ < 0) {
+    LOG_DEBUG("can't open db file for direct I/O");
+    return false;
+  }
+  return true;
+#else
+  // macOS, for one, has no O_DIRECT; pages keep going through the page cache.
+  return false;
+#endif
+}
+
 /**
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
-  // set write cursor to offset
+  const auto start = LatencyHistogram::clock::now();
+  // 64-bit offset: an int would overflow past 2GB
+  const auto offset = static_cast<off_t>(page_id) * page_size_;
+  int fd = PageFd(page_data);
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
-    return;
+  // pwrite hands the page to the OS right away, so there is no user-space buffer to flush
+  ssize_t written = 0;
+  while (written < page_size_) {
+    const auto rc = pwrite(fd, page_data + written, page_size_ - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+    // The rest of a short write is no longer aligned for direct I/O.
+    fd = db_fd_;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  write_latency_.RecordSince(start);
+}
+
+/**
+ * Write the pages of a run with pwritev, IOV_MAX pages at a time
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  const auto start = LatencyHistogram::clock::now();
+  std::vector<iovec> iovecs(pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    // pwritev never writes into the buffers
+    iovecs[i] = {const_cast<char *>(pages[i]), static_cast<size_t>(page_size_)};
+  }
+  int fd = RunFd(iovecs);
+  auto offset = static_cast<off_t>(first_page_id) * page_size_;
+  num_writes_ += static_cast<int>(pages.size());
+
+  size_t next = 0;
+  while (next < iovecs.size()) {
+    const auto count = static_cast<int>(std::min<size_t>(iovecs.size() - next, IOV_MAX));
+    const auto rc = pwritev(fd, &iovecs[next], count, offset);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    offset += rc;
+    // Skip the buffers that were written in full, and resume a short write in the middle of a buffer.
+    auto written = static_cast<size_t>(rc);
+    while (next < iovecs.size() && written >= iovecs[next].iov_len) {
+      written -= iovecs[next].iov_len;
+      next++;
+    }
+    if (written > 0) {
+      iovecs[next].iov_base = static_cast<char *>(iovecs[next].iov_base) + written;
+      iovecs[next].iov_len -= written;
+      fd = db_fd_;
+    }
+  }
+  write_latency_.RecordSince(start);
+}
+
+auto DiskManager::RunFd(const std::vector<iovec> &iovecs) const -> int {
+  for (const auto &iov : iovecs) {
+    if (PageFd(iov.iov_base) != direct_fd_) {
+      return db_fd_;
+    }
+  }
+  return direct_fd_ >= 0 ? direct_fd_ : db_fd_;
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
-    if (db_io_.bad()) {
+  const auto start = LatencyHistogram::clock::now();
+  const auto offset = static_cast<off_t>(page_id) * page_size_;
+  int fd = PageFd(page_data);
+  num_reads_ += 1;
+  ssize_t read_count = 0;
+  while (read_count < page_size_) {
+    const auto rc = pread(fd, page_data + read_count, page_size_ - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+    if (rc == 0) {
+      // the file ends before the end of the page
+      break;
+    }
+    read_count += rc;
+    // The rest of a short read is no longer aligned for direct I/O.
+    fd = db_fd_;
+  }
+  if (read_count == 0) {
+    LOG_DEBUG("I/O error reading past end of file");
+  } else if (read_count < page_size_) {
+    LOG_DEBUG("Read less than a page");
+  }
+  memset(page_data + read_count, 0, page_size_ - read_count);
+  read_latency_.RecordSince(start);
+}
+
+/**
+ * Write the page synchronously; there is no queue to wait in
+ */
+auto DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> {
+  WritePage(page_id, page_data);
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Write the run synchronously; there is no queue to wait in
+ */
+auto DiskManager::WritePagesAsync(page_id_t first_page_id, std::vector<const char *> pages) -> std::future<void> {
+  WritePages(first_page_id, pages);
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Read the page synchronously; there is no queue to wait in
+ */
+auto DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> {
+  ReadPage(page_id, page_data);
+  std::promise<void> done;
+  done.set_value();
+  return done.get_future();
+}
+
+/**
+ * Sync the page; the file is synced as a whole, which costs the same
+ */
+void DiskManager::SyncPage(page_id_t page_id) { Sync(); }
+
+/**
+ * Sync the data of the db file and the free-space map to disk
+ */
+void DiskManager::Sync() {
+  if (db_fd_ >= 0 && fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  if (fsm_fd_ >= 0) {
+    WriteFreeMap();
+    if (fdatasync(fsm_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing free-space map");
+    }
+  }
+}
+
+/**
+ * Allocate the lowest free page of the partition, or the first page of the partition past the end of the database
+ */
+auto DiskManager::AllocatePage(uint32_t stride, uint32_t offset) -> page_id_t {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  const std::set<page_id_t> *partition = &free_pages_;
+  if (stride > 1) {
+    auto &partitions = free_pages_by_stride_[stride];
+    if (partitions.empty()) {
+      // Split on first use, and kept up to date along with free_pages_ from then on.
+      partitions.resize(stride);
+      for (auto page_id : free_pages_) {
+        partitions[page_id % stride].insert(page_id);
+      }
     }
+    partition = &partitions[offset];
+  }
+  if (!partition->empty()) {
+    const auto page_id = *partition->begin();
+    RemoveFreePage(page_id);
+    SetAllocated(page_id, true);
+    // Written through: after a crash, a reused page must not come back as free.
+    WriteFreeMapByte(page_id);
+    return page_id;
+  }
+
+  // Pages of other partitions that are skipped over are free for them to take.
+  auto page_id = num_pages_;
+  while (static_cast<uint32_t>(page_id) % stride != offset) {
+    AddFreePage(page_id++);
   }
+  num_pages_ = page_id + 1;
+  SetAllocated(page_id, true);
+  return page_id;
+}
+
+/**
+ * Reserve the first run of free pages that is long enough, extending the database as needed
+ */
+auto DiskManager::ReserveExtent(size_t num_pages) -> page_id_t {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  const auto run_length = static_cast<page_id_t>(num_pages);
+  page_id_t run_start = INVALID_PAGE_ID;
+  page_id_t run_end = INVALID_PAGE_ID;
+  for (auto page_id : free_pages_) {
+    if (page_id != run_end) {
+      run_start = page_id;
+    }
+    run_end = page_id + 1;
+    if (run_end - run_start == run_length) {
+      break;
+    }
+  }
+
+  // A run of free pages at the end of the database can be extended; any other run has to be long enough.
+  page_id_t first_page_id = num_pages_;
+  if (run_start != INVALID_PAGE_ID && (run_end - run_start == run_length || run_end == num_pages_)) {
+    first_page_id = run_start;
+  }
+  for (auto page_id = first_page_id; page_id < first_page_id + run_length && page_id < num_pages_; page_id++) {
+    RemoveFreePage(page_id);
+  }
+  num_pages_ = std::max(num_pages_, first_page_id + run_length);
+  return first_page_id;
+}
+
+/**
+ * Allocate a reserved page. Only a page the free-space map on disk already covers needs its bit written through.
+ */
+void DiskManager::AllocateReservedPage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  SetAllocated(page_id, true);
+  if (page_id < num_pages_on_disk_) {
+    WriteFreeMapByte(page_id);
+  }
+}
+
+/**
+ * Deallocate a page and write its bit through
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  if (page_id < 0 || page_id >= num_pages_ || !TestAllocated(page_id)) {
+    return;
+  }
+  SetAllocated(page_id, false);
+  AddFreePage(page_id);
+  WriteFreeMapByte(page_id);
+}
+
+/**
+ * Returns true if the page is allocated
+ */
+auto DiskManager::IsAllocated(page_id_t page_id) -> bool {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  return page_id >= 0 && page_id < num_pages_ && TestAllocated(page_id);
+}
+
+/**
+ * Returns the number of pages in the database
+ */
+auto DiskManager::GetNumPages() -> page_id_t {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  return num_pages_;
+}
+
+/**
+ * Drop the free pages at the end of the database and truncate the file after the last allocated page
+ */
+auto DiskManager::TruncateFreeTail() -> page_id_t {
+  std::scoped_lock<std::mutex> lock(alloc_latch_);
+  const auto old_num_pages = num_pages_;
+  while (num_pages_ > 0 && free_pages_.count(num_pages_ - 1) > 0) {
+    RemoveFreePage(--num_pages_);
+  }
+  allocation_map_.resize((num_pages_ + 7) / 8);
+
+  if (db_fd_ >= 0 && ftruncate(db_fd_, static_cast<off_t>(num_pages_) * page_size_) != 0) {
+    LOG_DEBUG("I/O error while truncating");
+  }
+  if (fsm_fd_ >= 0) {
+    WriteFreeMap();
+  }
+  return old_num_pages - num_pages_;
 }
 
 /**
@@ -199,6 +487,128 @@ auto DiskManager::GetNumWrites() const -> int { return num_writes_; }
  */
 auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 
+/**
+ * Read the page size from the header page at the start of the db file. A header page in the legacy format, without
+ * the page size, belongs to a 4K database. A new file, or one whose page 0 has never been written, gets the page size
+ * the caller asked for.
+ */
+void DiskManager::LoadPageSize(int page_size) {
+  char header[HeaderPage::OFFSET_RECORD_COUNT];
+  if (pread(db_fd_, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header))) {
+    const int recorded_page_size = HeaderPage::ReadPageSize(header);
+    if (recorded_page_size != 0) {
+      page_size = recorded_page_size;
+    }
+  }
+  SetPageSize(page_size);
+}
+
+void DiskManager::SetPageSize(int page_size) {
+  // A power of two keeps pages aligned to the blocks of the file system.
+  if (page_size < BUSTUB_MIN_PAGE_SIZE || page_size > BUSTUB_MAX_PAGE_SIZE || (page_size & (page_size - 1)) != 0) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "page size must be a power of two between 4K and 64K");
+  }
+  page_size_ = page_size;
+}
+
+/**
+ * Load the free-space map. The map of a database file that is empty is stale: the database was deleted and recreated.
+ */
+void DiskManager::LoadFreeMap() {
+  fsm_fd_ = open(fsm_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fsm_fd_ < 0) {
+    throw Exception("can't open free-space map file");
+  }
+
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat db file");
+  }
+  const auto file_pages = static_cast<page_id_t>((stat_buf.st_size + page_size_ - 1) / page_size_);
+  if (file_pages == 0) {
+    WriteFreeMap();
+    return;
+  }
+
+  uint32_t header[2];
+  if (pread(fsm_fd_, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+      header[0] == FREE_MAP_MAGIC) {
+    num_pages_ = static_cast<page_id_t>(header[1]);
+    num_pages_on_disk_ = num_pages_;
+    allocation_map_.resize((num_pages_ + 7) / 8);
+    const auto rc = pread(fsm_fd_, allocation_map_.data(), allocation_map_.size(), FREE_MAP_HEADER_SIZE);
+    if (rc != static_cast<ssize_t>(allocation_map_.size())) {
+      // Without the bitmap, no page is known to be free.
+      LOG_DEBUG("free-space map is truncated");
+      std::fill(allocation_map_.begin(), allocation_map_.end(), 0xff);
+    }
+  }
+
+  // Pages that reached the file after the map was last written are in use.
+  for (auto page_id = num_pages_; page_id < file_pages; page_id++) {
+    SetAllocated(page_id, true);
+  }
+  num_pages_ = std::max(num_pages_, file_pages);
+  for (page_id_t page_id = 0; page_id < num_pages_; page_id++) {
+    if (!TestAllocated(page_id)) {
+      AddFreePage(page_id);
+    }
+  }
+}
+
+/**
+ * Write the whole free-space map, dropping whatever the file holds past it
+ */
+void DiskManager::WriteFreeMap() {
+  const uint32_t header[2] = {FREE_MAP_MAGIC, static_cast<uint32_t>(num_pages_)};
+  const auto size = static_cast<ssize_t>(allocation_map_.size());
+  if (pwrite(fsm_fd_, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+      pwrite(fsm_fd_, allocation_map_.data(), size, FREE_MAP_HEADER_SIZE) != size ||
+      ftruncate(fsm_fd_, static_cast<off_t>(FREE_MAP_HEADER_SIZE + size)) != 0) {
+    LOG_DEBUG("I/O error while writing free-space map");
+    return;
+  }
+  num_pages_on_disk_ = num_pages_;
+}
+
+auto DiskManager::TestAllocated(page_id_t page_id) const -> bool {
+  const auto index = static_cast<size_t>(page_id / 8);
+  return index < allocation_map_.size() && (allocation_map_[index] & (1 << (page_id % 8))) != 0;
+}
+
+void DiskManager::SetAllocated(page_id_t page_id, bool allocated) {
+  const auto index = static_cast<size_t>(page_id / 8);
+  if (index >= allocation_map_.size()) {
+    allocation_map_.resize(index + 1);
+  }
+  if (allocated) {
+    allocation_map_[index] |= 1 << (page_id % 8);
+  } else {
+    allocation_map_[index] &= ~(1 << (page_id % 8));
+  }
+}
+
+void DiskManager::WriteFreeMapByte(page_id_t page_id) {
+  const auto index = static_cast<size_t>(page_id / 8);
+  if (fsm_fd_ >= 0 && pwrite(fsm_fd_, &allocation_map_[index], 1, FREE_MAP_HEADER_SIZE + index) != 1) {
+    LOG_DEBUG("I/O error while writing free-space map");
+  }
+}
+
+void DiskManager::AddFreePage(page_id_t page_id) {
+  free_pages_.insert(page_id);
+  for (auto &[stride, partitions] : free_pages_by_stride_) {
+    partitions[page_id % stride].insert(page_id);
+  }
+}
+
+void DiskManager::RemoveFreePage(page_id_t page_id) {
+  free_pages_.erase(page_id);
+  for (auto &[stride, partitions] : free_pages_by_stride_) {
+    partitions[page_id % stride].erase(page_id);
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
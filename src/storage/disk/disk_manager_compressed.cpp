@@ -0,0 +1,207 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_compressed.cpp
+//
+// Identification: src/storage/disk/disk_manager_compressed.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_compressed.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "storage/disk/page_compressor.h"
+
+namespace bustub {
+
+DiskManagerCompressed::DiskManagerCompressed(const std::string &db_file, int page_size)
+    : DiskManager(db_file, page_size) {
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat db file");
+  }
+  block_size_ = std::min(static_cast<size_t>(std::max<blksize_t>(stat_buf.st_blksize, 512)),
+                         static_cast<size_t>(page_size_));
+  ptm_name_ = file_name_.substr(0, file_name_.rfind('.')) + ".ptm";
+  LoadTranslationMap();
+}
+
+DiskManagerCompressed::~DiskManagerCompressed() {
+  if (ptm_fd_ >= 0) {
+    close(ptm_fd_);
+  }
+}
+
+void DiskManagerCompressed::ShutDown() {
+  {
+    std::scoped_lock<std::mutex> lock(map_latch_);
+    if (ptm_fd_ >= 0) {
+      close(ptm_fd_);
+      ptm_fd_ = -1;
+    }
+  }
+  DiskManager::ShutDown();
+}
+
+void DiskManagerCompressed::WritePage(page_id_t page_id, const char *page_data) {
+  const auto start = LatencyHistogram::clock::now();
+  // The compressed page has to fit in the slot with at least one block to spare.
+  std::vector<char> compressed(page_size_ - block_size_);
+  size_t compressed_size = 0;
+  if (page_id != HEADER_PAGE_ID && !compressed.empty()) {
+    compressed_size = PageCompressor::Compress(page_data, page_size_, compressed.data(), compressed.size());
+  }
+  if (compressed_size == 0) {
+    DiskManager::WritePage(page_id, page_data);
+    SetCompressedSize(page_id, 0);
+    return;
+  }
+
+  const auto offset = static_cast<off_t>(page_id) * page_size_;
+  num_writes_ += 1;
+  size_t written = 0;
+  while (written < compressed_size) {
+    const auto rc = pwrite(db_fd_, compressed.data() + written, compressed_size - written, offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+
+#ifdef __linux__
+  // Give the blocks of the slot after the compressed page back to the file system.
+  const auto hole_start = static_cast<off_t>((compressed_size + block_size_ - 1) / block_size_ * block_size_);
+  const auto hole_size = page_size_ - hole_start;
+  if (fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset + hole_start, hole_size) != 0 &&
+      errno != EOPNOTSUPP) {
+    LOG_DEBUG("I/O error while punching a hole");
+  }
+#endif
+  SetCompressedSize(page_id, static_cast<uint32_t>(compressed_size));
+  write_latency_.RecordSince(start);
+}
+
+void DiskManagerCompressed::WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  for (size_t i = 0; i < pages.size(); i++) {
+    WritePage(first_page_id + static_cast<page_id_t>(i), pages[i]);
+  }
+}
+
+void DiskManagerCompressed::ReadPage(page_id_t page_id, char *page_data) {
+  const auto compressed_size = GetCompressedSize(page_id);
+  if (compressed_size == 0) {
+    DiskManager::ReadPage(page_id, page_data);
+    return;
+  }
+
+  const auto start = LatencyHistogram::clock::now();
+  const auto offset = static_cast<off_t>(page_id) * page_size_;
+  num_reads_ += 1;
+  std::vector<char> compressed(compressed_size);
+  size_t read_count = 0;
+  while (read_count < compressed_size) {
+    const auto rc = pread(db_fd_, compressed.data() + read_count, compressed_size - read_count, offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  // A page that was lost, e.g. truncated away, reads as zeros like a page past the end of the file.
+  if (read_count < compressed_size ||
+      !PageCompressor::Decompress(compressed.data(), compressed_size, page_data, page_size_)) {
+    LOG_DEBUG("I/O error reading a compressed page");
+    memset(page_data, 0, page_size_);
+  }
+  read_latency_.RecordSince(start);
+}
+
+/**
+ * Sync the db file and the free-space map, then the page translation map
+ */
+void DiskManagerCompressed::Sync() {
+  DiskManager::Sync();
+  std::scoped_lock<std::mutex> lock(map_latch_);
+  if (ptm_fd_ >= 0 && fdatasync(ptm_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing page translation map");
+  }
+}
+
+auto DiskManagerCompressed::GetStoredSize(page_id_t page_id) -> size_t {
+  const auto compressed_size = GetCompressedSize(page_id);
+  return compressed_size == 0 ? page_size_ : compressed_size;
+}
+
+void DiskManagerCompressed::LoadTranslationMap() {
+  ptm_fd_ = open(ptm_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (ptm_fd_ < 0) {
+    throw Exception("can't open page translation map file");
+  }
+
+  struct stat db_stat;
+  struct stat ptm_stat;
+  if (fstat(db_fd_, &db_stat) != 0 || fstat(ptm_fd_, &ptm_stat) != 0) {
+    throw Exception("can't stat db file");
+  }
+  uint32_t magic = 0;
+  if (db_stat.st_size > 0 && pread(ptm_fd_, &magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic)) &&
+      magic == TRANSLATION_MAP_MAGIC) {
+    compressed_sizes_.resize((ptm_stat.st_size - TRANSLATION_MAP_HEADER_SIZE) / sizeof(uint32_t));
+    const auto size = static_cast<ssize_t>(compressed_sizes_.size() * sizeof(uint32_t));
+    if (pread(ptm_fd_, compressed_sizes_.data(), size, TRANSLATION_MAP_HEADER_SIZE) != size) {
+      throw Exception("can't read page translation map");
+    }
+    return;
+  }
+
+  // A new database, or one that has never been compressed: every page is stored as is.
+  magic = TRANSLATION_MAP_MAGIC;
+  if (ftruncate(ptm_fd_, 0) != 0 || pwrite(ptm_fd_, &magic, sizeof(magic), 0) != static_cast<ssize_t>(sizeof(magic))) {
+    throw Exception("can't write page translation map");
+  }
+}
+
+void DiskManagerCompressed::SetCompressedSize(page_id_t page_id, uint32_t compressed_size) {
+  std::scoped_lock<std::mutex> lock(map_latch_);
+  const auto index = static_cast<size_t>(page_id);
+  if (index >= compressed_sizes_.size()) {
+    if (compressed_size == 0) {
+      return;
+    }
+    compressed_sizes_.resize(index + 1);
+  }
+  if (compressed_sizes_[index] == compressed_size) {
+    return;
+  }
+  compressed_sizes_[index] = compressed_size;
+  const auto entry_offset = static_cast<off_t>(TRANSLATION_MAP_HEADER_SIZE + index * sizeof(uint32_t));
+  if (ptm_fd_ >= 0 && pwrite(ptm_fd_, &compressed_size, sizeof(compressed_size), entry_offset) !=
+                          static_cast<ssize_t>(sizeof(compressed_size))) {
+    LOG_DEBUG("I/O error while writing page translation map");
+  }
+}
+
+auto DiskManagerCompressed::GetCompressedSize(page_id_t page_id) -> uint32_t {
+  std::scoped_lock<std::mutex> lock(map_latch_);
+  const auto index = static_cast<size_t>(page_id);
+  return index < compressed_sizes_.size() ? compressed_sizes_[index] : 0;
+}
+
+}  // namespace bustub
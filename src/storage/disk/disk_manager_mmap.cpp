@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_mmap.cpp
+//
+// Identification: src/storage/disk/disk_manager_mmap.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_mmap.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <mutex>  // NOLINT
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+DiskManagerMmap::DiskManagerMmap(const std::string &db_file, int page_size) : DiskManager(db_file, page_size) {
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat db file");
+  }
+  file_size_ = static_cast<size_t>(stat_buf.st_size);
+  if (file_size_ > 0) {
+    Grow(file_size_);
+  }
+}
+
+DiskManagerMmap::~DiskManagerMmap() { ShutDown(); }
+
+void DiskManagerMmap::ShutDown() {
+  {
+    std::unique_lock<std::shared_mutex> lock(mapping_latch_);
+    if (mapping_ != nullptr) {
+      munmap(mapping_, mapping_size_);
+      mapping_ = nullptr;
+      mapping_size_ = 0;
+      // Drop the part of the last chunk that was never written.
+      if (db_fd_ >= 0 && ftruncate(db_fd_, static_cast<off_t>(file_size_)) != 0) {
+        LOG_DEBUG("I/O error while truncating");
+      }
+    }
+  }
+  DiskManager::ShutDown();
+}
+
+void DiskManagerMmap::WritePage(page_id_t page_id, const char *page_data) {
+  const auto start = LatencyHistogram::clock::now();
+  const auto offset = static_cast<size_t>(page_id) * page_size_;
+  std::shared_lock<std::shared_mutex> lock(mapping_latch_);
+  if (offset + page_size_ > mapping_size_) {
+    lock.unlock();
+    {
+      std::unique_lock<std::shared_mutex> grow_lock(mapping_latch_);
+      Grow(offset + page_size_);
+    }
+    lock.lock();
+  }
+  num_writes_ += 1;
+  memcpy(mapping_ + offset, page_data, page_size_);
+
+  const auto end = offset + page_size_;
+  auto file_size = file_size_.load();
+  while (file_size < end && !file_size_.compare_exchange_weak(file_size, end)) {
+  }
+  write_latency_.RecordSince(start);
+}
+
+void DiskManagerMmap::WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) {
+  for (size_t i = 0; i < pages.size(); i++) {
+    WritePage(first_page_id + static_cast<page_id_t>(i), pages[i]);
+  }
+}
+
+void DiskManagerMmap::ReadPage(page_id_t page_id, char *page_data) {
+  const auto start = LatencyHistogram::clock::now();
+  const auto offset = static_cast<size_t>(page_id) * page_size_;
+  num_reads_ += 1;
+  std::shared_lock<std::shared_mutex> lock(mapping_latch_);
+  if (offset + page_size_ > mapping_size_) {
+    LOG_DEBUG("I/O error reading past end of file");
+    memset(page_data, 0, page_size_);
+    return;
+  }
+  memcpy(page_data, mapping_ + offset, page_size_);
+  read_latency_.RecordSince(start);
+}
+
+void DiskManagerMmap::SyncPage(page_id_t page_id) {
+  const auto offset = static_cast<size_t>(page_id) * page_size_;
+  std::shared_lock<std::shared_mutex> lock(mapping_latch_);
+  if (offset + page_size_ <= mapping_size_ && msync(mapping_ + offset, page_size_, MS_SYNC) != 0) {
+    LOG_DEBUG("I/O error while syncing a page");
+  }
+}
+
+void DiskManagerMmap::Sync() {
+  std::shared_lock<std::shared_mutex> lock(mapping_latch_);
+  if (mapping_ != nullptr && msync(mapping_, mapping_size_, MS_SYNC) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+}
+
+auto DiskManagerMmap::GetMappedSize() -> size_t {
+  std::shared_lock<std::shared_mutex> lock(mapping_latch_);
+  return mapping_size_;
+}
+
+void DiskManagerMmap::Grow(size_t min_size) {
+  // Someone else may have grown the mapping while we were waiting for the latch.
+  if (min_size <= mapping_size_) {
+    return;
+  }
+  const size_t new_size = (min_size + MMAP_GROW_SIZE - 1) / MMAP_GROW_SIZE * MMAP_GROW_SIZE;
+  if (ftruncate(db_fd_, static_cast<off_t>(new_size)) != 0) {
+    throw Exception("can't extend db file");
+  }
+
+#ifdef __linux__
+  void *mapping = mapping_ == nullptr
+                      ? mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, db_fd_, 0)
+                      : mremap(mapping_, mapping_size_, new_size, MREMAP_MAYMOVE);
+#else
+  // Without mremap, map the grown file anew. Both mappings are shared, so the new one sees every write to the old one.
+  void *mapping = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, db_fd_, 0);
+  if (mapping != MAP_FAILED && mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+#endif
+  if (mapping == MAP_FAILED) {
+    throw Exception("can't map db file");
+  }
+  mapping_ = static_cast<char *>(mapping);
+  mapping_size_ = new_size;
+}
+
+}  // namespace bustub
@@ -0,0 +1,291 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_uring.cpp
+//
+// Identification: src/storage/disk/disk_manager_uring.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_uring.h"
+
+#include <limits.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+// There is no liburing to link against, so the ring is driven through the raw system calls.
+static auto IoUringSetup(unsigned entries, io_uring_params *params) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static auto IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+DiskManagerUring::DiskManagerUring(const std::string &db_file, unsigned queue_depth, int page_size)
+    : DiskManager(db_file, page_size) {
+  SetUpRing(queue_depth);
+}
+
+DiskManagerUring::~DiskManagerUring() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(sq_latch_);
+    SubmitQueued();
+    completed_cv_.wait(lock, [this] { return num_in_flight_ == 0; });
+
+    // Wake the completion thread up with a no-op, which it takes as the signal to exit.
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    num_queued_++;
+    SubmitQueued();
+  }
+  reaper_.join();
+  TearDownRing();
+}
+
+auto DiskManagerUring::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> {
+  if (ring_fd_ < 0) {
+    return DiskManager::WritePageAsync(page_id, page_data);
+  }
+  // The ring never writes into the buffer of a write request.
+  return Queue(new Request{true, page_id, const_cast<char *>(page_data), {}, {}});
+}
+
+auto DiskManagerUring::WritePagesAsync(page_id_t first_page_id, std::vector<const char *> pages) -> std::future<void> {
+  if (ring_fd_ < 0 || pages.size() > IOV_MAX) {
+    return DiskManager::WritePagesAsync(first_page_id, std::move(pages));
+  }
+  auto *request = new Request{true, first_page_id, nullptr, {}, std::vector<iovec>(pages.size())};
+  for (size_t i = 0; i < pages.size(); i++) {
+    request->iovecs_[i] = {const_cast<char *>(pages[i]), static_cast<size_t>(page_size_)};
+  }
+  return Queue(request);
+}
+
+auto DiskManagerUring::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> {
+  if (ring_fd_ < 0) {
+    return DiskManager::ReadPageAsync(page_id, page_data);
+  }
+  return Queue(new Request{false, page_id, page_data, {}, {}});
+}
+
+void DiskManagerUring::SubmitIO() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  std::scoped_lock<std::mutex> lock(sq_latch_);
+  SubmitQueued();
+}
+
+void DiskManagerUring::SetUpRing(unsigned queue_depth) {
+  if (db_fd_ < 0 || queue_depth == 0) {
+    return;
+  }
+
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int ring_fd = IoUringSetup(queue_depth, &params);
+  if (ring_fd < 0) {
+    LOG_DEBUG("io_uring is not available, page I/O stays synchronous");
+    return;
+  }
+  ring_fd_ = ring_fd;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    TearDownRing();
+    return;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      TearDownRing();
+      return;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    TearDownRing();
+    return;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_entries_ = params.sq_entries;
+
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cq_entries_ = params.cq_entries;
+
+  reaper_ = std::thread(&DiskManagerUring::ReapCompletions, this);
+}
+
+void DiskManagerUring::TearDownRing() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  close(ring_fd_);
+  ring_fd_ = -1;
+}
+
+auto DiskManagerUring::Queue(Request *request) -> std::future<void> {
+  auto done = request->done_.get_future();
+  std::unique_lock<std::mutex> lock(sq_latch_);
+
+  // Every request in flight must have room in the completion queue, or completions could be dropped.
+  if (num_in_flight_ >= cq_entries_) {
+    SubmitQueued();
+    completed_cv_.wait(lock, [this] { return num_in_flight_ < cq_entries_; });
+  }
+  const unsigned tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+    SubmitQueued();
+  }
+
+  const unsigned index = tail & sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->fd = request->iovecs_.empty() ? PageFd(request->page_data_) : RunFd(request->iovecs_);
+  sqe->off = static_cast<uint64_t>(request->page_id_) * page_size_;
+  if (request->iovecs_.empty()) {
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->addr = reinterpret_cast<uint64_t>(request->page_data_);
+    sqe->len = page_size_;
+  } else {
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->addr = reinterpret_cast<uint64_t>(request->iovecs_.data());
+    sqe->len = static_cast<uint32_t>(request->iovecs_.size());
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  // Publish the entry before the kernel can see the new tail.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+  num_queued_++;
+  num_in_flight_++;
+  return done;
+}
+
+void DiskManagerUring::SubmitQueued() {
+  while (num_queued_ > 0) {
+    const int rc = IoUringEnter(ring_fd_, num_queued_, 0, 0);
+    if (rc < 0) {
+      BUSTUB_ENSURE(errno == EINTR || errno == EAGAIN || errno == EBUSY, "io_uring submission failed");
+      std::this_thread::yield();
+      continue;
+    }
+    num_queued_ -= std::min<unsigned>(rc, num_queued_);
+  }
+}
+
+void DiskManagerUring::ReapCompletions() {
+  while (true) {
+    if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      LOG_DEBUG("I/O error while waiting for completions");
+    }
+
+    // Only this thread moves the head of the completion queue.
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    bool stopped = false;
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+      if (cqe.user_data == 0) {
+        stopped = true;
+      } else {
+        Complete(reinterpret_cast<Request *>(cqe.user_data), cqe.res);
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (stopped) {
+      return;
+    }
+  }
+}
+
+void DiskManagerUring::Complete(Request *request, int result) {
+  const auto num_pages = std::max<size_t>(request->iovecs_.size(), 1);
+  if (result != static_cast<int>(num_pages * page_size_)) {
+    // A failed or short I/O, e.g. a read past the end of the file: the synchronous path retries and zero-fills.
+    if (!request->iovecs_.empty()) {
+      std::vector<const char *> pages;
+      for (const auto &iov : request->iovecs_) {
+        pages.push_back(static_cast<const char *>(iov.iov_base));
+      }
+      DiskManager::WritePages(request->page_id_, pages);
+    } else if (request->is_write_) {
+      DiskManager::WritePage(request->page_id_, request->page_data_);
+    } else {
+      DiskManager::ReadPage(request->page_id_, request->page_data_);
+    }
+  } else if (request->is_write_) {
+    num_writes_ += static_cast<int>(num_pages);
+    write_latency_.RecordSince(request->queued_at_);
+  } else {
+    num_reads_ += 1;
+    read_latency_.RecordSince(request->queued_at_);
+  }
+  request->done_.set_value();
+  delete request;
+
+  {
+    std::scoped_lock<std::mutex> lock(sq_latch_);
+    num_in_flight_--;
+  }
+  completed_cv_.notify_all();
+}
+
+}  // namespace bustub
@@ -0,0 +1,162 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_compressor.cpp
+//
+// Identification: src/storage/disk/page_compressor.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_compressor.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace bustub {
+
+static auto Load32(const char *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/** Write the part of a length beyond the 15 its nibble holds. @return false if it does not fit. */
+static auto PutLength(size_t length, char *dst, size_t capacity, size_t *op) -> bool {
+  for (length -= 15; length >= 255; length -= 255) {
+    if (*op >= capacity) {
+      return false;
+    }
+    dst[(*op)++] = static_cast<char>(255);
+  }
+  if (*op >= capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>(length);
+  return true;
+}
+
+/** Read the part of a length beyond the 15 its nibble holds. @return false if the input ends first. */
+static auto GetLength(const char *src, size_t src_size, size_t *ip, size_t *length) -> bool {
+  uint8_t byte;
+  do {
+    if (*ip >= src_size) {
+      return false;
+    }
+    byte = static_cast<uint8_t>(src[(*ip)++]);
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Write a run: the literals, then a match of match_length bytes at the given distance, unless match_length is 0.
+ * @return false if it does not fit
+ */
+static auto PutRun(const char *literals, size_t num_literals, size_t distance, size_t match_length, char *dst,
+                   size_t capacity, size_t *op) -> bool {
+  if (*op >= capacity) {
+    return false;
+  }
+  const size_t match_code = match_length == 0 ? 0 : match_length - PageCompressor::MIN_MATCH;
+  dst[(*op)++] = static_cast<char>((std::min<size_t>(num_literals, 15) << 4) | std::min<size_t>(match_code, 15));
+  if (num_literals >= 15 && !PutLength(num_literals, dst, capacity, op)) {
+    return false;
+  }
+  if (capacity - *op < num_literals) {
+    return false;
+  }
+  memcpy(dst + *op, literals, num_literals);
+  *op += num_literals;
+  if (match_length == 0) {
+    return true;
+  }
+  if (capacity - *op < 2) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>(distance & 0xff);
+  dst[(*op)++] = static_cast<char>(distance >> 8);
+  return match_code < 15 || PutLength(match_code, dst, capacity, op);
+}
+
+auto PageCompressor::Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t {
+  // Position + 1 of the last occurrence of each hash of MIN_MATCH bytes, 0 if there is none
+  std::array<uint32_t, 1 << HASH_BITS> last_seen{};
+  size_t ip = 0;
+  size_t anchor = 0;
+  size_t op = 0;
+
+  while (ip + MIN_MATCH <= size) {
+    const uint32_t sequence = Load32(src + ip);
+    const uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+    const size_t candidate = last_seen[hash];
+    last_seen[hash] = static_cast<uint32_t>(ip + 1);
+    if (candidate == 0 || ip + 1 - candidate > MAX_DISTANCE || Load32(src + candidate - 1) != sequence) {
+      ip++;
+      continue;
+    }
+
+    // The match may overlap the bytes it produces, which is how a run of zeros becomes a single reference.
+    const size_t match = candidate - 1;
+    size_t length = MIN_MATCH;
+    while (ip + length < size && src[match + length] == src[ip + length]) {
+      length++;
+    }
+    if (!PutRun(src + anchor, ip - anchor, ip - match, length, dst, capacity, &op)) {
+      return 0;
+    }
+    ip += length;
+    anchor = ip;
+  }
+
+  if (!PutRun(src + anchor, size - anchor, 0, 0, dst, capacity, &op)) {
+    return 0;
+  }
+  return op;
+}
+
+auto PageCompressor::Decompress(const char *src, size_t src_size, char *dst, size_t size) -> bool {
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < src_size) {
+    const auto token = static_cast<uint8_t>(src[ip++]);
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !GetLength(src, src_size, &ip, &num_literals)) {
+      return false;
+    }
+    if (src_size - ip < num_literals || size - op < num_literals) {
+      return false;
+    }
+    memcpy(dst + op, src + ip, num_literals);
+    ip += num_literals;
+    op += num_literals;
+    if (ip == src_size) {
+      // the last run
+      break;
+    }
+
+    if (src_size - ip < 2) {
+      return false;
+    }
+    const size_t distance = static_cast<uint8_t>(src[ip]) | static_cast<size_t>(static_cast<uint8_t>(src[ip + 1])) << 8;
+    ip += 2;
+    size_t match_length = token & 0x0f;
+    if (match_length == 15 && !GetLength(src, src_size, &ip, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (distance == 0 || distance > op || size - op < match_length) {
+      return false;
+    }
+    // Byte by byte, as the match may overlap what it copies.
+    for (size_t i = 0; i < match_length; i++, op++) {
+      dst[op] = dst[op - distance];
+    }
+  }
+  return op == size;
+}
+
+}  // namespace bustub
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <initializer_list>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -14,48 +18,243 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manag
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      leaf_max_size_(LeafPage::MaxSizeFor(buffer_pool_manager->GetPageSize())),
+      internal_max_size_(InternalPage::MaxSizeFor(buffer_pool_manager->GetPageSize())) {
+  // The page size is only known at runtime, so the sizes are capped by what fits in a page of the database.
+  if (leaf_max_size > 0) {
+    leaf_max_size_ = std::min(leaf_max_size, leaf_max_size_);
+  }
+  if (internal_max_size > 0) {
+    internal_max_size_ = std::min(internal_max_size, internal_max_size_);
+  }
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
-  return root_page_id_ == INVALID_PAGE_ID;
-}
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return root_page_id_ == INVALID_PAGE_ID; }
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost, bool rightMost) -> Page * {
+  Page *page = LatchLeafOptimistic(key, leftMost, rightMost, false);
+  if (page != nullptr || IsEmpty()) {
+    return page;
+  }
+
+  // Writers kept getting in the way of the latch-free descent, so crab down with read latches.
+  root_latch_.RLock();
+  if (IsEmpty()) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  page = buffer_pool_manager_->FetchPage(root_page_id_);
+  page->RLatch();
+  root_latch_.RUnlock();
+
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  while (!node->IsLeafPage()) {
+    auto *internal_page = static_cast<InternalPage *>(node);
+    page_id_t next;
+    if (leftMost) {
+      next = internal_page->ValueAt(0);
+    } else if (rightMost) {
+      next = internal_page->ValueAt(internal_page->GetSize() - 1);
+    } else {
+      next = internal_page->Lookup(key, comparator_);
+    }
+    Page *child = buffer_pool_manager_->FetchPage(next);
+    child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child;
+    node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  }
+  return page;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost, bool rightMost) -> LeafPage * {
-    if (IsEmpty()) {
+auto BPLUSTREE_TYPE::DescendOptimistic(const KeyType &key, bool leftMost, bool rightMost, OptimisticPath *path)
+    -> bool {
+  const page_id_t root_page_id = root_page_id_;
+  if (root_page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  // The hops of an optimistic descent are not accesses, and may follow ids read from pages changing underneath.
+  path->leaf_ = buffer_pool_manager_->PinPage(root_page_id);
+  if (path->leaf_ == nullptr) {
+    return false;
+  }
+  path->leaf_version_ = path->leaf_->GetVersion();
+  // Replacing the root write-latches it, so from here on its version tells whether it is still the root.
+  if (root_page_id_ != root_page_id) {
+    ReleaseDescent(path);
+    return false;
+  }
+
+  while (true) {
+    auto *node = reinterpret_cast<BPlusTreePage *>(path->leaf_->GetData());
+    if (node->IsLeafPage()) {
+      return true;
+    }
+    if (path->leaf_version_ % 2 == 1) {
+      ReleaseDescent(path);
+      return false;
+    }
+
+    // The page may be torn by a writer, so the size is kept within the page, keys are compared without reading past
+    // their end (see GenericKey::ToValue), and the child is only followed once the version shows the page was not
+    // changed while it was read.
+    auto *internal_page = static_cast<InternalPage *>(node);
+    const int size = std::clamp(internal_page->GetSize(), 1, internal_max_size_ + 1);
+    page_id_t next;
+    if (leftMost) {
+      next = internal_page->ValueAt(0);
+    } else if (rightMost) {
+      next = internal_page->ValueAt(size - 1);
+    } else {
+      next = internal_page->Lookup(key, comparator_, size);
+    }
+    if (!path->leaf_->ValidateVersion(path->leaf_version_)) {
+      ReleaseDescent(path);
+      return false;
+    }
+
+    if (path->parent_ != nullptr) {
+      buffer_pool_manager_->UnpinPage(path->parent_->GetPageId(), false);
+    }
+    path->parent_ = std::exchange(path->leaf_, nullptr);
+    path->parent_version_ = path->leaf_version_;
+    path->leaf_ = buffer_pool_manager_->PinPage(next);
+    if (path->leaf_ == nullptr) {
+      ReleaseDescent(path);
+      return false;
+    }
+    path->leaf_version_ = path->leaf_->GetVersion();
+    // Validating the parent after reading the child's version makes sure the child was still the parent's child then.
+    if (!path->parent_->ValidateVersion(path->parent_version_)) {
+      ReleaseDescent(path);
+      return false;
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::ValidateDescent(const OptimisticPath &path) const -> bool {
+  if (path.parent_ == nullptr) {
+    return root_page_id_ == path.leaf_->GetPageId();
+  }
+  return path.parent_->ValidateVersion(path.parent_version_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseDescent(OptimisticPath *path) {
+  for (Page *page : {path->leaf_, path->parent_}) {
+    if (page != nullptr) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+  }
+  path->leaf_ = nullptr;
+  path->parent_ = nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::LatchLeafOptimistic(const KeyType &key, bool leftMost, bool rightMost, bool exclusive)
+    -> Page * {
+  for (int attempt = 0; attempt < OPTIMISTIC_ATTEMPTS; attempt++) {
+    OptimisticPath path;
+    if (!DescendOptimistic(key, leftMost, rightMost, &path)) {
+      continue;
+    }
+    Page *page = path.leaf_;
+    if (page == nullptr) {
       return nullptr;
     }
-    page_id_t next = root_page_id_;
-    auto page = buffer_pool_manager_->FetchPage(next);
-    auto pointer = reinterpret_cast<BPlusTreePage *>(page->GetData());
-    for (page_id_t cur = root_page_id_; !pointer->IsLeafPage(); cur = next,pointer = FetchPage(cur)) {
-        auto *internal_page = static_cast<InternalPage *>(pointer);
-        if (leftMost) {
-            next = internal_page->ValueAt(0);
-        } else if (rightMost) {
-            next = internal_page->ValueAt(internal_page->GetSize()-1);
-        } else {
-            next = internal_page->Lookup(key, comparator_);
-        }
-        buffer_pool_manager_->UnpinPage(cur, false);
+    if (exclusive) {
+      page->WLatch();
+    } else {
+      page->RLatch();
+    }
+    // Splitting, merging or redistributing the leaf changes its parent, so while the parent keeps its version the
+    // latched page is still the leaf of key.
+    if (ValidateDescent(path)) {
+      path.leaf_ = nullptr;
+      ReleaseDescent(&path);
+      return page;
+    }
+    if (exclusive) {
+      page->WUnlatch();
+    } else {
+      page->RUnlatch();
+    }
+    ReleaseDescent(&path);
+  }
+  return nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, BTreeOperator op) -> Page * {
+  Page *page = LatchLeafOptimistic(key, false, false, true);
+  // Whether the leaf is the root, which its min size depends on, can't change while the leaf is latched.
+  if (page != nullptr && !IsSafe(reinterpret_cast<BPlusTreePage *>(page->GetData()), op)) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    return nullptr;
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPagePessimistic(const KeyType &key, BTreeOperator op, LatchedPath *path) -> Page * {
+  root_latch_.WLock();
+  path->push_back(nullptr);
+  if (IsEmpty()) {
+    return nullptr;
+  }
+
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  page->WLatch();
+  while (true) {
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op)) {
+      ReleasePath(path, false);
+    }
+    path->push_back(page);
+    if (node->IsLeafPage()) {
+      return page;
     }
-    return static_cast<LeafPage *>(pointer);
+    page = buffer_pool_manager_->FetchPage(static_cast<InternalPage *>(node)->Lookup(key, comparator_));
+    page->WLatch();
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::FetchPage(page_id_t page_id) -> BPlusTreePage * {
-    auto page = buffer_pool_manager_->FetchPage(page_id);
-    page->RLatch();
-    return reinterpret_cast<BPlusTreePage *>(page->GetData());
+auto BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, BTreeOperator op) const -> bool {
+  switch (op) {
+    case BTreeOperator::INSERT:
+      return node->GetSize() < node->GetMaxSize();
+    case BTreeOperator::DELETE:
+      // An empty root leaf or a root with one child is replaced, which changes root_page_id_.
+      return node->GetSize() > node->GetMinSize();
+    default:
+      return true;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePath(LatchedPath *path, bool is_dirty) {
+  for (Page *page : *path) {
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  path->clear();
 }
 
 /*
@@ -65,15 +264,42 @@ auto BPLUSTREE_TYPE::FetchPage(page_id_t page_id) -> BPlusTreePage * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-    std::scoped_lock<std::mutex> lock(latch_);
-    auto *tar = FindLeafPage(key);
-    if (tar == nullptr) {
-        return false;
+  for (int attempt = 0; attempt < OPTIMISTIC_ATTEMPTS; attempt++) {
+    OptimisticPath path;
+    if (!DescendOptimistic(key, false, false, &path)) {
+      continue;
     }
-    result->resize(1);
-    auto ret = tar->Lookup(key,result->at(0), comparator_);
-    buffer_pool_manager_->UnpinPage(tar->GetPageId(), false);
-    return ret;
+    if (path.leaf_ == nullptr) {
+      return false;
+    }
+    auto *leaf = reinterpret_cast<LeafPage *>(path.leaf_->GetData());
+    const int size = std::clamp(leaf->GetSize(), 0, leaf_max_size_ + 1);
+    const int index = leaf->KeyIndex(key, comparator_, size);
+    const bool found = index < size && comparator_(leaf->KeyAt(index), key) == 0;
+    const ValueType value = found ? leaf->ValueAt(index) : ValueType();
+    const bool valid = path.leaf_version_ % 2 == 0 && path.leaf_->ValidateVersion(path.leaf_version_);
+    ReleaseDescent(&path);
+    if (valid) {
+      if (found) {
+        result->push_back(value);
+      }
+      return found;
+    }
+  }
+
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return false;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType value;
+  const bool found = leaf->Lookup(key, value, comparator_);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  if (found) {
+    result->push_back(value);
+  }
+  return found;
 }
 
 /*****************************************************************************
@@ -81,82 +307,77 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  *****************************************************************************/
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::CreateRoot(const KeyType &key, const ValueType &value)  {
-    page_id_t new_page_id;
-    Page *root_page = buffer_pool_manager_->NewPage(&new_page_id);
-    assert(root_page != nullptr);
-
-    auto *root = reinterpret_cast<LeafPage *>(root_page->GetData());
+void BPLUSTREE_TYPE::CreateRoot(const KeyType &key, const ValueType &value) {
+  page_id_t new_page_id;
+  Page *root_page = buffer_pool_manager_->NewPageInExtent(&new_page_id, &extent_);
+  assert(root_page != nullptr);
 
-    root->Init(new_page_id, INVALID_PAGE_ID);
-    root_page_id_ = new_page_id;
-    UpdateRootPageId(true);
-    root->Insert(key, value, comparator_);
+  auto *root = reinterpret_cast<LeafPage *>(root_page->GetData());
+  root->Init(new_page_id, INVALID_PAGE_ID, leaf_max_size_);
+  root_page_id_ = new_page_id;
+  UpdateRootPageId(true);
+  root->Insert(key, value, comparator_);
 
-    buffer_pool_manager_->UnpinPage(new_page_id, true);
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
 }
 
-
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-    LeafPage *leaf_page = FindLeafPage(key);
-    ValueType v;
-    bool exist = leaf_page->Lookup(key, v, comparator_);
-    if (exist) {
-        buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
-        return false;
-    }
-    leaf_page->Insert(key, value, comparator_);
-    if (leaf_page->GetSize() > leaf_page->GetMaxSize()) {
-        LeafPage *new_leaf_page = Split(leaf_page);
-        InsertIntoParent(leaf_page, new_leaf_page->KeyAt(0), new_leaf_page, transaction);
-    }
-    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
-    return true;
+auto BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, LatchedPath *path) -> bool {
+  auto *leaf_page = reinterpret_cast<LeafPage *>(path->back()->GetData());
+  ValueType v;
+  if (leaf_page->Lookup(key, v, comparator_)) {
+    return false;
+  }
+  leaf_page->Insert(key, value, comparator_);
+  if (leaf_page->GetSize() > leaf_page->GetMaxSize()) {
+    LeafPage *new_leaf_page = Split(leaf_page);
+    InsertIntoParent(path, path->size() - 1, leaf_page, new_leaf_page->KeyAt(0), new_leaf_page);
+  }
+  return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
-                                      BPlusTreePage *new_node, Transaction *transaction) {
-    if (old_node->IsRootPage()) {
-        Page* const new_page = buffer_pool_manager_->NewPage(&root_page_id_);
-        assert(new_page != nullptr);
-        assert(new_page->GetPinCount() == 1);
-        auto *new_root = reinterpret_cast<InternalPage *>(new_page->GetData());
-        new_root->Init(root_page_id_);
-        new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
-        old_node->SetParentPageId(root_page_id_);
-        new_node->SetParentPageId(root_page_id_);
-        UpdateRootPageId();
-        //  fetch page and new page need to unpin page
-        buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
-        buffer_pool_manager_->UnpinPage(new_root->GetPageId(), true);
-        return;
-    }
-    page_id_t parent_id = old_node->GetParentPageId();
-    auto *page = FetchPage(parent_id);
-    assert(page != nullptr);
-    auto *parent = reinterpret_cast<InternalPage *>(page);
-    new_node->SetParentPageId(parent_id);
+void BPLUSTREE_TYPE::InsertIntoParent(LatchedPath *path, size_t level, BPlusTreePage *old_node, const KeyType &key,
+                                      BPlusTreePage *new_node) {
+  if (old_node->IsRootPage()) {
+    // The root was not safe, so root_latch_ is still held.
+    page_id_t new_root_id;
+    Page *const new_page = buffer_pool_manager_->NewPageInExtent(&new_root_id, &extent_);
+    assert(new_page != nullptr);
+    auto *new_root = reinterpret_cast<InternalPage *>(new_page->GetData());
+    new_root->Init(new_root_id, INVALID_PAGE_ID, internal_max_size_);
+    new_root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(new_root_id);
+    new_node->SetParentPageId(new_root_id);
+    root_page_id_ = new_root_id;
+    UpdateRootPageId();
     buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
-    parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-    if (parent->GetSize() > parent->GetMaxSize()) {
-        auto *new_leaf_page = Split(parent);
-        InsertIntoParent(parent, new_leaf_page->KeyAt(0), new_leaf_page, transaction);
-    }
-    buffer_pool_manager_->UnpinPage(parent_id, true);
+    buffer_pool_manager_->UnpinPage(new_root_id, true);
+    return;
+  }
+
+  // The old node was not safe either, so its parent is the page above it on the path.
+  auto *parent = reinterpret_cast<InternalPage *>((*path)[level - 1]->GetData());
+  new_node->SetParentPageId(parent->GetPageId());
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
+  if (parent->GetSize() > parent->GetMaxSize()) {
+    auto *new_internal_page = Split(parent);
+    InsertIntoParent(path, level - 1, parent, new_internal_page->KeyAt(0), new_internal_page);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 auto BPLUSTREE_TYPE::Split(N *node) -> N * {
-    page_id_t new_page_id;
-    Page* const new_page = buffer_pool_manager_->NewPage(&new_page_id);
-    assert(new_page != nullptr);
-    N *new_node = reinterpret_cast<N *>(new_page->GetData());
-    new_node->Init(new_page_id, node->GetParentPageId());
-    node->MoveHalfTo(new_node, buffer_pool_manager_);
-    return new_node;
+  page_id_t new_page_id;
+  Page *const new_page = buffer_pool_manager_->NewPageInExtent(&new_page_id, &extent_);
+  assert(new_page != nullptr);
+  // The new node is only reachable through the node and its parent, which are both write-latched.
+  N *new_node = reinterpret_cast<N *>(new_page->GetData());
+  new_node->Init(new_page_id, node->GetParentPageId(), node->GetMaxSize());
+  node->MoveHalfTo(new_node, buffer_pool_manager_);
+  return new_node;
 }
 
 /*
@@ -168,12 +389,30 @@ auto BPLUSTREE_TYPE::Split(N *node) -> N * {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-    std::scoped_lock<std::mutex> lock(latch_);
-    if (IsEmpty()) {
-        CreateRoot(key,value);
-        return true;
+  // Most inserts only change their leaf.
+  Page *page = FindLeafPageOptimistic(key, BTreeOperator::INSERT);
+  if (page != nullptr) {
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    ValueType v;
+    const bool inserted = !leaf->Lookup(key, v, comparator_);
+    if (inserted) {
+      leaf->Insert(key, value, comparator_);
     }
-    return InsertIntoLeaf(key,value,transaction);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), inserted);
+    return inserted;
+  }
+
+  LatchedPath path;
+  if (FindLeafPagePessimistic(key, BTreeOperator::INSERT, &path) == nullptr) {
+    CreateRoot(key, value);
+    ReleasePath(&path, false);
+    return true;
+  }
+  const bool inserted = InsertIntoLeaf(key, value, &path);
+  ReleasePath(&path, inserted);
+  DeletePages({});
+  return inserted;
 }
 
 /*****************************************************************************
@@ -188,170 +427,124 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-    std::scoped_lock<std::mutex> lock(latch_);
-    if (IsEmpty()) {
-        return;
-    }
-    auto *delTar = FindLeafPage(key);
-    int curSize = delTar->RemoveAndDeleteRecord(key, comparator_);
-    if (curSize < delTar->GetMinSize()) {
-        CoalesceOrRedistribute(delTar, transaction);
-    }
-    buffer_pool_manager_->UnpinPage(delTar->GetPageId(), true);
-//    assert(Check());
-
-//    auto *node = FindLeafPage(key);
-
-//    if (node->GetSize() == node->RemoveAndDeleteRecord(key, comparator_)) {
-//        buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
-//        return;
-//    }
-
-//    auto node_should_delete = CoalesceOrRedistribute(node, transaction);
+  // Most deletes only change their leaf.
+  Page *page = FindLeafPageOptimistic(key, BTreeOperator::DELETE);
+  if (page != nullptr) {
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    const int size = leaf->GetSize();
+    const bool removed = leaf->RemoveAndDeleteRecord(key, comparator_) < size;
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), removed);
+    return;
+  }
 
-//    if (node_should_delete) {
-//        transaction->AddIntoDeletedPageSet(node->GetPageId());
-//    }
+  LatchedPath path;
+  page = FindLeafPagePessimistic(key, BTreeOperator::DELETE, &path);
+  if (page == nullptr) {
+    ReleasePath(&path, false);
+    return;
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  const int size = leaf->GetSize();
+  if (leaf->RemoveAndDeleteRecord(key, comparator_) == size) {
+    ReleasePath(&path, false);
+    return;
+  }
 
-//    buffer_pool_manager_->UnpinPage(node->GetPageId(), true);
+  std::vector<page_id_t> deleted;
+  CoalesceOrRedistribute<LeafPage>(&path, path.size() - 1, &deleted);
+  ReleasePath(&path, true);
+  // Nothing links to the emptied pages any more, but a scan that pinned one on its way past keeps it until it moves on.
+  DeletePages(deleted);
+}
 
-//    std::for_each(transaction->GetDeletedPageSet()->begin(), transaction->GetDeletedPageSet()->end(),
-//                  [&bpm = buffer_pool_manager_](const page_id_t page_id) { bpm->DeletePage(page_id); });
-//    transaction->GetDeletedPageSet()->clear();
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePages(const std::vector<page_id_t> &page_ids) {
+  std::scoped_lock lock(deferred_latch_);
+  deferred_deletes_.insert(deferred_deletes_.end(), page_ids.begin(), page_ids.end());
+  auto still_pinned = std::remove_if(deferred_deletes_.begin(), deferred_deletes_.end(),
+                                     [this](page_id_t page_id) { return buffer_pool_manager_->DeletePage(page_id); });
+  deferred_deletes_.erase(still_pinned, deferred_deletes_.end());
 }
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
- * @return: true means target leaf page should be deleted, false means no
- * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-auto BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) -> bool {
-    if (node->IsRootPage()) {
-        AdjustRoot(node);
-        return true;
-    }
-
-    if (node->GetSize() >= node->GetMinSize()) {
-        return false;
-    }
-
-    auto parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-    auto *parent_node = reinterpret_cast<InternalPage *>(parent_page->GetData());
-    auto idx = parent_node->ValueIndex(node->GetPageId());
-
-    if (idx > 0) {
-        auto sibling_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(idx - 1));
-//        sibling_page->WLatch();
-        N *sibling_node = reinterpret_cast<N *>(sibling_page->GetData());
-
-        if (sibling_node->GetSize() > sibling_node->GetMinSize()) {
-            Redistribute(sibling_node, node, parent_node, idx, true);
-
-            buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-            sibling_page->WUnlatch();
-            buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-            return false;
-        }
-
-        // coalesce
-        Coalesce(sibling_node, node, parent_node, idx, transaction);
-
-//        if (parent_node_should_delete) {
-//            transaction->AddIntoDeletedPageSet(parent_node->GetPageId());
-//        }
-        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-        sibling_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-        return true;
-    }
-
-    if (idx != parent_node->GetSize() - 1) {
-        auto sibling_page = buffer_pool_manager_->FetchPage(parent_node->ValueAt(idx + 1));
-        sibling_page->WLatch();
-        N *sibling_node = reinterpret_cast<N *>(sibling_page->GetData());
-
-        if (sibling_node->GetSize() > sibling_node->GetMinSize()) {
-            Redistribute(sibling_node, node, parent_node, idx, false);
+void BPLUSTREE_TYPE::CoalesceOrRedistribute(LatchedPath *path, size_t level, std::vector<page_id_t> *deleted) {
+  auto *node = reinterpret_cast<N *>((*path)[level]->GetData());
+  if (node->IsRootPage()) {
+    AdjustRoot(node, deleted);
+    return;
+  }
+  if (node->GetSize() >= node->GetMinSize()) {
+    return;
+  }
 
-            buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-            sibling_page->WUnlatch();
-            buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-            return false;
-        }
-        // coalesce
-        auto sibling_idx = parent_node->ValueIndex(sibling_node->GetPageId());
-        Coalesce(node, sibling_node, parent_node, sibling_idx, transaction);  // NOLINT
-//        transaction->AddIntoDeletedPageSet(sibling_node->GetPageId());
-//        if (parent_node_should_delete) {
-//            transaction->AddIntoDeletedPageSet(parent_node->GetPageId());
-//        }
-        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-        sibling_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
-        return false;
-    }
+  // The node underflowed, so it was not safe and its parent is the page above it on the path.
+  auto *parent = reinterpret_cast<InternalPage *>((*path)[level - 1]->GetData());
+  const int index = parent->ValueIndex(node->GetPageId());
+  const bool from_prev = index > 0;
+  Page *sibling_page = buffer_pool_manager_->FetchPage(parent->ValueAt(from_prev ? index - 1 : index + 1));
+  // Latching the left sibling goes against the latch order. Only scans latch leaves left to right, and they back off.
+  sibling_page->WLatch();
+  auto *sibling = reinterpret_cast<N *>(sibling_page->GetData());
 
-    return false;
-}
+  if (sibling->GetSize() + node->GetSize() > node->GetMaxSize()) {
+    Redistribute(sibling, node, parent, index, from_prev);
+    sibling_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
+    return;
+  }
 
-INDEX_TEMPLATE_ARGUMENTS
-template <typename N>
-auto BPLUSTREE_TYPE::FindSibling(N *node, N * &sibling) -> bool {
-    auto page = FetchPage(node->GetParentPageId());
-    auto *parent = reinterpret_cast<InternalPage *>(page);
-    int index = parent->ValueIndex(node->GetPageId());
-    int sibling_index = index - 1;
-    if (index == 0) {
-        sibling_index = index + 1;
-    }
-    sibling = reinterpret_cast<N *>(FetchPage(parent->ValueAt(sibling_index)));
-    buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-    return index == 0;
+  // Merge right into left, so that the leaf chain only loses the right page.
+  if (from_prev) {
+    Coalesce(sibling, node, parent, index);
+    deleted->push_back(node->GetPageId());
+  } else {
+    Coalesce(node, sibling, parent, index + 1);
+    deleted->push_back(sibling->GetPageId());
+  }
+  sibling_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(sibling_page->GetPageId(), true);
+  CoalesceOrRedistribute<InternalPage>(path, level - 1, deleted);
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
- * take info of deletion into account. Remember to deal with coalesce or
- * redistribute recursively if necessary.
+ * Move all the key & value pairs from one page to its left sibling page. Parent
+ * page must be adjusted to take info of deletion into account.
  * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
+ * @param   neighbor_node      left sibling page of input "node"
+ * @param   node               page emptied into neighbor_node
  * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion
- * happend
+ * @param   index              index of node in parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-auto BPLUSTREE_TYPE::Coalesce(N *neighbor_node, N *node,
-                              BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent, int index,
-                              Transaction *transaction) -> bool {
-    auto middle_key = parent->KeyAt(index);
+void BPLUSTREE_TYPE::Coalesce(N *neighbor_node, N *node, InternalPage *parent, int index) {
+  auto middle_key = parent->KeyAt(index);
 
-    if (node->IsLeafPage()) {
-        auto *leaf_node = reinterpret_cast<LeafPage *>(node);
-        auto *prev_leaf_node = reinterpret_cast<LeafPage *>(neighbor_node);
-        leaf_node->MoveAllTo(prev_leaf_node);
-    } else {
-        auto *internal_node = reinterpret_cast<InternalPage *>(node);
-        auto *prev_internal_node = reinterpret_cast<InternalPage *>(neighbor_node);
-        internal_node->MoveAllTo(prev_internal_node, middle_key, buffer_pool_manager_);
-    }
-
-    parent->Remove(index);
+  if (node->IsLeafPage()) {
+    auto *leaf_node = reinterpret_cast<LeafPage *>(node);
+    auto *prev_leaf_node = reinterpret_cast<LeafPage *>(neighbor_node);
+    leaf_node->MoveAllTo(prev_leaf_node);
+  } else {
+    auto *internal_node = reinterpret_cast<InternalPage *>(node);
+    auto *prev_internal_node = reinterpret_cast<InternalPage *>(neighbor_node);
+    internal_node->MoveAllTo(prev_internal_node, middle_key, buffer_pool_manager_);
+  }
 
-    return CoalesceOrRedistribute(parent, transaction);
+  parent->Remove(index);
 }
 
 /*
- * Redistribute key & value pairs from one page to its sibling page. If index ==
- * 0, move sibling page's first key & value pair into end of input "node",
- * otherwise move sibling page's last key & value pair into head of input
- * "node".
+ * Redistribute key & value pairs from one page to its sibling page. If
+ * from_prev is false, move sibling page's first key & value pair into end of
+ * input "node", otherwise move sibling page's last key & value pair into head
+ * of input "node".
  * Using template N to represent either internal page or leaf page.
  * @param   neighbor_node      sibling page of input "node"
  * @param   node               input from method coalesceOrRedistribute()
@@ -359,29 +552,29 @@ auto BPLUSTREE_TYPE::Coalesce(N *neighbor_node, N *node,
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, InternalPage *parent, int index, bool from_prev) {
-    if (node->IsLeafPage()) {
-        auto *leaf_node = reinterpret_cast<LeafPage *>(node);
-        auto *neighbor_leaf_node = reinterpret_cast<LeafPage *>(neighbor_node);
-
-        if (!from_prev) {
-            neighbor_leaf_node->MoveFirstToEndOf(leaf_node);
-            parent->SetKeyAt(index + 1, neighbor_leaf_node->KeyAt(0));
-        } else {
-            neighbor_leaf_node->MoveLastToFrontOf(leaf_node);
-            parent->SetKeyAt(index, leaf_node->KeyAt(0));
-        }
+  if (node->IsLeafPage()) {
+    auto *leaf_node = reinterpret_cast<LeafPage *>(node);
+    auto *neighbor_leaf_node = reinterpret_cast<LeafPage *>(neighbor_node);
+
+    if (!from_prev) {
+      neighbor_leaf_node->MoveFirstToEndOf(leaf_node);
+      parent->SetKeyAt(index + 1, neighbor_leaf_node->KeyAt(0));
     } else {
-        auto *internal_node = reinterpret_cast<InternalPage *>(node);
-        auto *neighbor_internal_node = reinterpret_cast<InternalPage *>(neighbor_node);
-
-        if (!from_prev) {
-            neighbor_internal_node->MoveFirstToEndOf(internal_node, parent->KeyAt(index + 1), buffer_pool_manager_);
-            parent->SetKeyAt(index + 1, neighbor_internal_node->KeyAt(0));
-        } else {
-            neighbor_internal_node->MoveLastToFrontOf(internal_node, parent->KeyAt(index), buffer_pool_manager_);
-            parent->SetKeyAt(index, internal_node->KeyAt(0));
-        }
+      neighbor_leaf_node->MoveLastToFrontOf(leaf_node);
+      parent->SetKeyAt(index, leaf_node->KeyAt(0));
+    }
+  } else {
+    auto *internal_node = reinterpret_cast<InternalPage *>(node);
+    auto *neighbor_internal_node = reinterpret_cast<InternalPage *>(neighbor_node);
+
+    if (!from_prev) {
+      neighbor_internal_node->MoveFirstToEndOf(internal_node, parent->KeyAt(index + 1), buffer_pool_manager_);
+      parent->SetKeyAt(index + 1, neighbor_internal_node->KeyAt(0));
+    } else {
+      neighbor_internal_node->MoveLastToFrontOf(internal_node, parent->KeyAt(index), buffer_pool_manager_);
+      parent->SetKeyAt(index, internal_node->KeyAt(0));
     }
+  }
 }
 /*
  * Update root page if necessary
@@ -390,32 +583,184 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, InternalPage *paren
  * case 1: when you delete the last element in root page, but root page still
  * has one last child
  * case 2: when you delete the last element in whole b+ tree
- * @return : true means root page should be deleted, false means no deletion
- * happend
+ * The root was not safe, so root_latch_ is held.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node, std::vector<page_id_t> *deleted) {
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() == 0) {
+      root_page_id_ = INVALID_PAGE_ID;
+      UpdateRootPageId();
+      deleted->push_back(old_root_node->GetPageId());
+    }
+    return;
+  }
+  if (old_root_node->GetSize() == 1) {
+    auto *root = reinterpret_cast<InternalPage *>(old_root_node);
+    const page_id_t new_root_id = root->RemoveAndReturnOnlyChild();
+    root_page_id_ = new_root_id;
+    UpdateRootPageId();
+    // set the new root's parent id "INVALID_PAGE_ID"
+    Page *page = buffer_pool_manager_->FetchPage(new_root_id);
+    assert(page != nullptr);
+    auto *new_root = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    new_root->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(new_root_id, true);
+    deleted->push_back(old_root_node->GetPageId());
+  }
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * The tree is built left to right, one level per entry of levels: pairs fill the leaves, and every full page is linked
+ * into the page being filled one level up once the page after it starts. Only the last page of each level may end up
+ * below its min size; it is fixed up from the page before it at the end, bottom up.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
-    if (old_root_node->IsLeafPage()) {
-        buffer_pool_manager_->UnpinPage(old_root_node->GetPageId(), false);
-        buffer_pool_manager_->DeletePage(old_root_node->GetPageId());
-        root_page_id_ = INVALID_PAGE_ID;
-        UpdateRootPageId();
-        return;
-    }
-    if (old_root_node->GetSize() == 1) {
-        auto *root = reinterpret_cast<InternalPage *>(old_root_node);
-        const page_id_t new_root_id = root->RemoveAndReturnOnlyChild();
-        root_page_id_ = new_root_id;
-        UpdateRootPageId();
-        // set the new root's parent id "INVALID_PAGE_ID"
-        Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
-        assert(page != nullptr);
-        auto *new_root = reinterpret_cast<InternalPage *>(page->GetData());
-        new_root->SetParentPageId(INVALID_PAGE_ID);
-        buffer_pool_manager_->UnpinPage(root_page_id_, true);
-        buffer_pool_manager_->UnpinPage(old_root_node->GetPageId(), false);
-        buffer_pool_manager_->DeletePage(old_root_node->GetPageId());
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor) -> bool {
+  root_latch_.WLock();
+  if (!IsEmpty()) {
+    root_latch_.WUnlock();
+    return false;
+  }
+
+  // A page is never packed below half full, which a later delete would have to fix up right away.
+  fill_factor = std::clamp(fill_factor, 0.5, 1.0);
+  const int leaf_fill =
+      std::clamp(static_cast<int>(leaf_max_size_ * fill_factor), (leaf_max_size_ + 1) / 2, leaf_max_size_);
+  const int internal_fill = std::clamp(static_cast<int>(internal_max_size_ * fill_factor),
+                                       std::max((internal_max_size_ + 1) / 2, 2), internal_max_size_);
+
+  std::vector<BulkLevel> levels(1);
+  MappingType pair;
+  while (next(&pair)) {
+    auto *leaf = levels[0].page_ == nullptr ? nullptr : reinterpret_cast<LeafPage *>(levels[0].page_->GetData());
+    if (leaf != nullptr && comparator_(leaf->KeyAt(leaf->GetSize() - 1), pair.first) == 0) {
+      continue;
+    }
+    if (leaf == nullptr || leaf->GetSize() == leaf_fill) {
+      leaf = reinterpret_cast<LeafPage *>(BulkStartPage(&levels, 0, internal_fill)->GetData());
+    }
+    leaf->DirectInsert(pair.first, pair.second);
+  }
+  if (levels[0].page_ == nullptr) {
+    root_latch_.WUnlock();
+    return true;
+  }
+
+  for (size_t level = 0;; level++) {
+    if (levels[level].prev_ == nullptr) {
+      // The only page of the top level is the root, unless a merge below left it with a single child.
+      Page *page = levels[level].page_;
+      auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+      root_page_id_ = page->GetPageId();
+      if (!node->IsLeafPage() && node->GetSize() == 1) {
+        root_page_id_ = static_cast<InternalPage *>(node)->ValueAt(0);
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        DeletePages({page->GetPageId()});
+        page = buffer_pool_manager_->FetchPage(root_page_id_);
+        reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(INVALID_PAGE_ID);
+      }
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+      break;
+    }
+
+    Page *page = levels[level].page_;
+    if (BulkFixLastPage(levels[level])) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      DeletePages({page->GetPageId()});
+    } else {
+      BulkLinkPage(&levels, level, internal_fill);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
     }
+    buffer_pool_manager_->UnpinPage(levels[level].prev_->GetPageId(), true);
+  }
+  UpdateRootPageId(true);
+  root_latch_.WUnlock();
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkStartPage(std::vector<BulkLevel> *levels, size_t level, int internal_fill) -> Page * {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPageInExtent(&page_id, &extent_);
+  assert(page != nullptr);
+  if (level == 0) {
+    reinterpret_cast<LeafPage *>(page->GetData())->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+  } else {
+    reinterpret_cast<InternalPage *>(page->GetData())->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+  }
+
+  // Linking the full page may start pages further up, which can grow levels, so it is only indexed.
+  if (Page *full_page = (*levels)[level].page_; full_page != nullptr) {
+    if (level == 0) {
+      reinterpret_cast<LeafPage *>(full_page->GetData())->SetNextPageId(page_id);
+    }
+    BulkLinkPage(levels, level, internal_fill);
+    if ((*levels)[level].prev_ != nullptr) {
+      buffer_pool_manager_->UnpinPage((*levels)[level].prev_->GetPageId(), true);
+    }
+    (*levels)[level].prev_ = full_page;
+  }
+  (*levels)[level].page_ = page;
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLinkPage(std::vector<BulkLevel> *levels, size_t level, int internal_fill) {
+  auto *node = reinterpret_cast<BPlusTreePage *>((*levels)[level].page_->GetData());
+  // The first key of an internal page being built is the separator its parent gets, not the invalid key.
+  const KeyType key =
+      level == 0 ? static_cast<LeafPage *>(node)->KeyAt(0) : static_cast<InternalPage *>(node)->KeyAt(0);
+  if (levels->size() == level + 1) {
+    levels->emplace_back();
+  }
+
+  Page *parent_page = (*levels)[level + 1].page_;
+  if (parent_page == nullptr ||
+      reinterpret_cast<InternalPage *>(parent_page->GetData())->GetSize() == internal_fill) {
+    parent_page = BulkStartPage(levels, level + 1, internal_fill);
+  }
+  auto *parent = reinterpret_cast<InternalPage *>(parent_page->GetData());
+  parent->SetItem(key, node->GetPageId(), parent->GetSize());
+  parent->IncreaseSize(1);
+  node->SetParentPageId(parent->GetPageId());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkFixLastPage(const BulkLevel &level) -> bool {
+  auto *node = reinterpret_cast<BPlusTreePage *>(level.page_->GetData());
+  // The last page isn't linked into its parent yet, so it would still pass for a root.
+  const int min_size = (node->GetMaxSize() + 1) / 2;
+  if (node->GetSize() >= min_size) {
+    return false;
+  }
+
+  if (node->IsLeafPage()) {
+    auto *prev = reinterpret_cast<LeafPage *>(level.prev_->GetData());
+    auto *leaf = static_cast<LeafPage *>(node);
+    if (prev->GetSize() + leaf->GetSize() <= leaf_max_size_) {
+      leaf->MoveAllTo(prev);
+      return true;
+    }
+    while (leaf->GetSize() < min_size) {
+      prev->MoveLastToFrontOf(leaf);
+    }
+    return false;
+  }
+
+  auto *prev = reinterpret_cast<InternalPage *>(level.prev_->GetData());
+  auto *internal = static_cast<InternalPage *>(node);
+  if (prev->GetSize() + internal->GetSize() <= internal_max_size_) {
+    internal->MoveAllTo(prev, internal->KeyAt(0), buffer_pool_manager_);
+    return true;
+  }
+  while (internal->GetSize() < min_size) {
+    prev->MoveLastToFrontOf(internal, internal->KeyAt(0), buffer_pool_manager_);
+  }
+  return false;
 }
 
 /*****************************************************************************
@@ -428,12 +773,8 @@ void BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-    if (IsEmpty()) {
-        return INDEXITERATOR_TYPE(nullptr,0,buffer_pool_manager_);
-    }
-    KeyType useless;
-    auto start_leaf = FindLeafPage(useless, true, false);
-    return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_);
+  Page *page = FindLeafPage(KeyType(), true, false);
+  return INDEXITERATOR_TYPE(this, page, 0, buffer_pool_manager_);
 }
 
 /*
@@ -443,29 +784,46 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
-    if (IsEmpty()) {
-        return INDEXITERATOR_TYPE(nullptr,0,buffer_pool_manager_);
-    }
-    auto start_leaf = FindLeafPage(key);
-    if (start_leaf == nullptr) {
-        return INDEXITERATOR_TYPE(start_leaf, 0, buffer_pool_manager_);
-    }
-    int idx = start_leaf->KeyIndex(key, comparator_);
-    return INDEXITERATOR_TYPE(start_leaf, idx, buffer_pool_manager_);
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  int idx = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(this, page, idx, buffer_pool_manager_, key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::UpperBound(const KeyType &key) -> INDEXITERATOR_TYPE {
+  Page *page = FindLeafPage(key);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  int idx = leaf->KeyIndex(key, comparator_);
+  if (idx < leaf->GetSize() && comparator_(leaf->KeyAt(idx), key) == 0) {
+    idx++;
+  }
+  return INDEXITERATOR_TYPE(this, page, idx, buffer_pool_manager_, key);
 }
 
 /*
  * Input parameter is void, construct an index iterator representing the end
- * of the key/value pair in the leaf node
+ * of the key/value pair in the leaf node. It holds no latch or pin, so it can be
+ * compared against while scanning.
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
-    if (root_page_id_ == INVALID_PAGE_ID) {
-        return INDEXITERATOR_TYPE(nullptr, 0, nullptr);
-    }
-    auto *leaf_node = FindLeafPage(KeyType(),  false, true);
-    return INDEXITERATOR_TYPE(leaf_node, leaf_node->GetSize(), buffer_pool_manager_);
+  Page *page = FindLeafPage(KeyType(), false, true);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  const auto page_id = leaf->GetPageId();
+  const int size = leaf->GetSize();
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return INDEXITERATOR_TYPE(page_id, size);
 }
 
 /**
@@ -487,14 +845,15 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return root_page_id_; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
-    // update root_page_id in header_page
+  Page *page = buffer_pool_manager_->FetchPage(HEADER_PAGE_ID);
+  auto *header_page = static_cast<HeaderPage *>(page);
+  // Every index shares the header page.
+  page->WLatch();
+  // Insert a record<index_name + root_page_id> the first time; a tree that was emptied and grows again has one.
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
+  page->WUnlatch();
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "storage/index/b_plus_tree_index.h"
+#include "storage/index/external_sorter.h"
 
 namespace bustub {
 /*
@@ -48,6 +49,21 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   container_.GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::BulkLoad(const std::function<bool(Tuple *, RID *)> &next, Transaction *transaction) {
+  auto less = [this](const MappingType &lhs, const MappingType &rhs) { return comparator_(lhs.first, rhs.first) < 0; };
+  ExternalSorter<MappingType, decltype(less)> sorter(less, index_build_memory);
+  Tuple key;
+  MappingType entry;
+  while (next(&key, &entry.second)) {
+    entry.first.SetFromKey(key);
+    sorter.Add(entry);
+  }
+  sorter.Sort();
+
+  container_.BulkLoad([&sorter](MappingType *pair) { return sorter.Next(pair); }, index_fill_factor);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_.Begin(); }
 
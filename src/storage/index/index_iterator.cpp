@@ -1,9 +1,12 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
 #include "storage/index/index_iterator.h"
+#include "storage/index/b_plus_tree.h"
 
 namespace bustub {
 
@@ -15,40 +18,134 @@ INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {
-    if (leaf_ != nullptr) {
-        buffer_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
+INDEXITERATOR_TYPE::~IndexIterator() { Release(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BPlusTree<KeyType, ValueType, KeyComparator> *tree, Page *page, int index,
+                                  BufferPoolManager *bufferPoolManager, std::optional<KeyType> seek_key)
+    : tree_(tree), page_(page), index_(index), buffer_pool_manager_(bufferPoolManager) {
+    if (page_ != nullptr) {
+        version_ = page_->GetVersion();
+        page_id_ = page_->GetPageId();
+        CopyLeaf(page_);
+        page_->RUnlatch();
+        // The leaf's pairs all come before the seek key, so resuming after the last of them could go back past it.
+        if (index_ >= static_cast<int>(items_.size())) {
+            seek_key_ = std::move(seek_key);
+        }
+        SkipExhaustedLeaves();
     }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf, int index, BufferPoolManager *bufferPoolManager)
-            : index_(index), leaf_(leaf), buffer_pool_manager_(bufferPoolManager) {}
+INDEXITERATOR_TYPE::IndexIterator(page_id_t page_id, int index) : page_id_(page_id), index_(index) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept { *this = std::move(other); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept -> INDEXITERATOR_TYPE & {
+    if (this != &other) {
+        Release();
+        tree_ = other.tree_;
+        page_ = std::exchange(other.page_, nullptr);
+        version_ = other.version_;
+        items_ = std::move(other.items_);
+        seek_key_ = std::move(other.seek_key_);
+        next_page_id_ = other.next_page_id_;
+        page_id_ = other.page_id_;
+        index_ = other.index_;
+        buffer_pool_manager_ = other.buffer_pool_manager_;
+        pages_until_read_ahead_ = other.pages_until_read_ahead_;
+    }
+    return *this;
+}
 
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Release() {
+    if (page_ != nullptr) {
+        buffer_pool_manager_->UnpinPage(page_id_, false);
+        page_ = nullptr;
+    }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::IsEnd() -> bool {
-    return nullptr == leaf_ || (leaf_->GetNextPageId() == INVALID_PAGE_ID && index_ >= leaf_->GetSize());
+    return next_page_id_ == INVALID_PAGE_ID && index_ >= static_cast<int>(items_.size());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
-    return leaf_->GetItem(index_);
+    return items_[index_];
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
-    if (index_ == leaf_->GetSize() - 1 && leaf_->GetNextPageId() != INVALID_PAGE_ID) {
-        auto next_page = buffer_pool_manager_->FetchPage(leaf_->GetNextPageId());
-        buffer_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
-        leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(next_page->GetData());
-        index_ = 0;
-    } else {
-        index_++;
-    }
+    index_++;
+    SkipExhaustedLeaves();
     return *this;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+    while (index_ >= static_cast<int>(items_.size()) && next_page_id_ != INVALID_PAGE_ID) {
+        MoveToNextLeaf();
+    }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::CopyLeaf(Page *page) {
+    auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    const int size = std::clamp(leaf->GetSize(), 0, B_PLUS_TREE_LEAF_PAGE_TYPE::MaxSizeFor(page->GetPageSize()) + 1);
+    items_.clear();
+    for (int i = 0; i < size; i++) {
+        items_.push_back(leaf->GetItem(i));
+    }
+    next_page_id_ = leaf->GetNextPageId();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::MoveToNextLeaf() {
+    // Every leaf but an emptied root holds a pair, and this one has been visited up to its end.
+    const KeyType last_key = seek_key_.has_value() ? *seek_key_ : items_.back().first;
+    // The sibling link is only known to be current once the leaf validates, so it may point to a deallocated page.
+    Page *next_page = buffer_pool_manager_->PinPage(next_page_id_);
+    if (next_page != nullptr) {
+        const uint64_t version = next_page->GetVersion();
+        if (version % 2 == 0) {
+            CopyLeaf(next_page);
+            if (next_page->ValidateVersion(version) && page_->ValidateVersion(version_)) {
+                Release();
+                seek_key_.reset();
+                page_ = next_page;
+                version_ = version;
+                page_id_ = next_page->GetPageId();
+                index_ = 0;
+                ReadAhead(page_id_);
+                return;
+            }
+        }
+        buffer_pool_manager_->UnpinPage(next_page->GetPageId(), false);
+    }
+
+    Release();
+    *this = tree_->UpperBound(last_key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::ReadAhead(page_id_t page_id) {
+    if (pages_until_read_ahead_ > 0) {
+        pages_until_read_ahead_--;
+        return;
+    }
+
+    // The current leaf is resident already; the prefetcher only reads it to find the next one.
+    buffer_pool_manager_->PrefetchRange(page_id, READ_AHEAD_PAGES + 1, [](Page *page) {
+        return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())->GetNextPageId();
+    });
+    pages_until_read_ahead_ = READ_AHEAD_PAGES / 2 - 1;
+}
+
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
@@ -40,12 +40,12 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const -> KeyType {
   // replace with your own code
-  return array_[index].first;
+  return KeyRef(index);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
-  array_[index].first = key;
+  KeyRef(index) = key;
 }
 
 /*
@@ -53,16 +53,31 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return array_[index].second; }
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const -> ValueType { return ValueRef(index); }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::ShiftPairs(int index, int offset) {
+    if (offset > 0) {
+        for (int i = GetSize() - 1; i >= index; i--) {
+            KeyRef(i + offset) = KeyRef(i);
+            ValueRef(i + offset) = ValueRef(i);
+        }
+        return;
+    }
+    for (int i = index; i < GetSize(); i++) {
+        KeyRef(i + offset) = KeyRef(i);
+        ValueRef(i + offset) = ValueRef(i);
+    }
+}
 
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::LikeVal(const KeyType &key, const KeyComparator &comparator) -> ValueType {
-  auto target = std::lower_bound(array_ + 1, array_ + GetSize(), key, [&comparator](const auto &pair,auto k) { return comparator(pair.first,k) < 0; });
-  if (target == array_ + GetSize()) {
+  const int target = Slots::Search(slots_, 1, GetSize(), key, comparator, false);
+  if (target == GetSize()) {
     return ValueAt(GetSize()-1);
   }
-  return comparator(target->first,key) == 0 ? target->second : std::prev(target)->second;
+  return comparator(KeyAt(target),key) == 0 ? ValueAt(target) : ValueAt(target - 1);
 }
 
 //INDEX_TEMPLATE_ARGUMENTS
@@ -73,15 +88,11 @@ INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,const ValueType &new_value) -> int {
     int idx = ValueIndex(old_value) + 1;
     assert(idx > 0);
+    ShiftPairs(idx, 1);
     IncreaseSize(1);
-    int cur_size = GetSize();
-    for (int i = cur_size - 1; i > idx; i--) {
-        array_[i].first = array_[i - 1].first;
-        array_[i].second = array_[i - 1].second;
-    }
-    array_[idx].first = new_key;
-    array_[idx].second = new_value;
-    return cur_size;
+    KeyRef(idx) = new_key;
+    ValueRef(idx) = new_value;
+    return GetSize();
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -100,60 +111,31 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &val) -> int{
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,const ValueType &new_value) {
     int index_zero = 0;
-    array_[index_zero].second = old_value;
-    array_[index_zero + 1].first = new_key;
-    array_[index_zero + 1].second = new_value;
+    ValueRef(index_zero) = old_value;
+    KeyRef(index_zero + 1) = new_key;
+    ValueRef(index_zero + 1) = new_value;
     SetSize(2);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,BufferPoolManager *buffer_pool_manager) {
     assert(recipient != nullptr);
-    int start_split_indx = GetMinSize();
-    int original_size = GetSize();
-    SetSize(start_split_indx);
-
-    int size = original_size - start_split_indx;
-    auto *items = array_ + start_split_indx;
-    std::copy(items, items + size, array_ + GetSize());
-
-    for (int i = 0; i < size; i++) {
-        auto page = buffer_pool_manager->FetchPage(ValueAt(i + GetSize()));
-        auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
-        node->SetParentPageId(GetPageId());
-        buffer_pool_manager->UnpinPage(page->GetPageId(), true);
-    }
-    IncreaseSize(size);
-//    int total = GetMaxSize() + 1;
-//    assert(GetSize() == total);
-//    int copyIdx = total/2;
-//    page_id_t recipPageId = recipient->GetPageId();
-//    for (int i = copyIdx; i < total; i++) {
-//        recipient->array_[i - copyIdx].first = array_[i].first;
-//        recipient->array_[i - copyIdx].second = array_[i].second;
-//        auto childRawPage = buffer_pool_manager->FetchPage(array_[i].second);
-//        auto *childTreePage = reinterpret_cast<BPlusTreePage *>(childRawPage->GetData());
-//        childTreePage->SetParentPageId(recipPageId);
-//        buffer_pool_manager->UnpinPage(array_[i].second,true);
-//    }
-//    SetSize(copyIdx);
-//    recipient->SetSize(total - copyIdx);
+    // The first key moved becomes the recipient's invalid key 0, and is pushed up to the parent as the separator.
+    const int keep = (GetSize() + 1) / 2;
+    recipient->CopyNFrom(this, keep, GetSize() - keep, buffer_pool_manager);
+    SetSize(keep);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,const KeyComparator &comparator) const -> ValueType {
     assert(GetSize() > 1);
-    int st = 1;
-    int ed = GetSize() - 1;
-    while (st <= ed) { //find the last key in array <= input
-        int mid = (ed - st) / 2 + st;
-        if (comparator(array_[mid].first,key) <= 0) {
-            st = mid + 1;
-        } else {
-            ed = mid - 1;
-        }
-    }
-    return array_[st - 1].second;
+    return Lookup(key, comparator, GetSize());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,const KeyComparator &comparator, int size) const -> ValueType {
+    // The child is left of the first key greater than key.
+    return ValueAt(Slots::Search(slots_, 1, size, key, comparator, true) - 1);
 }
 
 
@@ -161,23 +143,24 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,const KeyComparat
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
-    for(int i = index; i < GetSize() - 1; i++) {
-        array_[i].first = array_[i + 1].first;
-        array_[i].second = array_[i + 1].second;
-    }
+    ShiftPairs(index + 1, -1);
     IncreaseSize(-1);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,BufferPoolManager *buffer_pool_manager) {
     SetKeyAt(0, middle_key);
-    recipient->CopyNFrom(array_, GetSize(), buffer_pool_manager);
+    recipient->CopyNFrom(this, 0, GetSize(), buffer_pool_manager);
     SetSize(0);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
-    std::copy(items, items + size, array_ + GetSize());
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(const BPlusTreeInternalPage *source, int index, int size,
+                                               BufferPoolManager *buffer_pool_manager) {
+    for (int i = 0; i < size; i++) {
+        KeyRef(GetSize() + i) = source->KeyAt(index + i);
+        ValueRef(GetSize() + i) = source->ValueAt(index + i);
+    }
 
     for (int i = 0; i < size; i++) {
         auto page = buffer_pool_manager->FetchPage(ValueAt(i + GetSize()));
@@ -189,8 +172,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetItem(int index)-> MappingType & {
-    return array_[index];
+auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetItem(int index) const -> MappingType {
+    return {KeyAt(index), ValueAt(index)};
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -203,24 +186,30 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() -> ValueType {
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetItem(const KeyType &key,const ValueType &val,int index) {
-    array_[index].first = key;
-    array_[index].second = val;
+    KeyRef(index) = key;
+    ValueRef(index) = val;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
     assert(GetSize() + 1 <= GetMaxSize());
-    array_[GetSize()] = pair;
+    KeyRef(GetSize()) = pair.first;
+    ValueRef(GetSize()) = pair.second;
     IncreaseSize(1);
+
+    auto page = buffer_pool_manager->FetchPage(pair.second);
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    node->SetParentPageId(GetPageId());
+    buffer_pool_manager->UnpinPage(page->GetPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,BufferPoolManager *buffer_pool_manager) {
     SetKeyAt(0, middle_key);
-    auto first_item = array_[0];
+    auto first_item = GetItem(0);
     recipient->CopyLastFrom(first_item, buffer_pool_manager);
 
-    std::move(array_ + 1, array_ + GetSize(), array_);
+    ShiftPairs(1, -1);
     IncreaseSize(-1);
 }
 
@@ -228,7 +217,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *rec
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                                                        BufferPoolManager *buffer_pool_manager) {
-    auto last_item = array_[GetSize() - 1];
+    auto last_item = GetItem(GetSize() - 1);
     recipient->SetKeyAt(0, middle_key);
     recipient->CopyFirstFrom(last_item, buffer_pool_manager);
     IncreaseSize(-1);
@@ -236,8 +225,9 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *re
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair,BufferPoolManager *buffer_pool_manager) {
-    std::move_backward(array_, array_ + GetSize(), array_ + GetSize() + 1);
-    *array_ = pair;
+    ShiftPairs(0, 1);
+    KeyRef(0) = pair.first;
+    ValueRef(0) = pair.second;
     IncreaseSize(1);
 
     auto page = buffer_pool_manager->FetchPage(pair.second);
@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <sstream>
 #include "common/exception.h"
 
@@ -42,17 +43,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, in
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key,const KeyComparator &comparator) const -> int {
     assert(GetSize() >= 0);
-    int st = 0;
-    int ed = GetSize() - 1;
-    while (st <= ed) {
-        int mid = (ed - st) / 2 + st;
-        if (comparator(array_[mid].first,key) >= 0){
-            ed = mid - 1;
-        }else {
-            st = mid + 1;
-        }
-    }
-    return ed + 1;
+    return KeyIndex(key, comparator, GetSize());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key,const KeyComparator &comparator, int size) const -> int {
+    return Slots::Search(slots_, 0, size, key, comparator, false);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -82,29 +78,36 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  return array_[index].first;
+  return KeyRef(index);
 }
 
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType {
-  return array_[index].second;
+  return ValueRef(index);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,const ValueType &val,const KeyComparator &comparator) {
-    auto target = std::lower_bound(array_,array_ + GetSize(),key,[&comparator](const auto &pair,auto k) { return comparator(pair.first,k) < 0; });
-    int target_index = GetSize();
-    if (target != array_ + GetSize()) {
-        for (int index = GetSize() - 1; ; index--) {
-            array_[index+1] = array_[index];
-            if(comparator(array_[index].first,target->first) == 0){
-                target_index = index;
-                break;
-            }
+void B_PLUS_TREE_LEAF_PAGE_TYPE::ShiftPairs(int index, int offset) {
+    if (offset > 0) {
+        for (int i = GetSize() - 1; i >= index; i--) {
+            KeyRef(i + offset) = KeyRef(i);
+            ValueRef(i + offset) = ValueRef(i);
         }
+        return;
     }
-    array_[target_index] = std::make_pair(key,val);
+    for (int i = index; i < GetSize(); i++) {
+        KeyRef(i + offset) = KeyRef(i);
+        ValueRef(i + offset) = ValueRef(i);
+    }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,const ValueType &val,const KeyComparator &comparator) {
+    int target_index = KeyIndex(key,comparator);
+    ShiftPairs(target_index, 1);
+    KeyRef(target_index) = key;
+    ValueRef(target_index) = val;
     IncreaseSize(1);
 //    int idx = KeyIndex(key,comparator); //first larger than key
 //    assert(idx >= 0);
@@ -120,15 +123,16 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,const ValueType &val,
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::DirectInsert(const KeyType &key, const ValueType &val) {
-    array_[GetSize()] = std::make_pair(key,val);
+    KeyRef(GetSize()) = key;
+    ValueRef(GetSize()) = val;
     IncreaseSize(1);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,const KeyComparator &comparator) const -> bool {
     int idx = KeyIndex(key,comparator);
-    if (idx < GetSize() && comparator(array_[idx].first, key) == 0) {
-        value = array_[idx].second;
+    if (idx < GetSize() && comparator(KeyAt(idx), key) == 0) {
+        value = ValueAt(idx);
         return true;
     }
     return false;
@@ -140,27 +144,23 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient,__attri
     int total = GetMaxSize() + 1;
     assert(GetSize() == total);
     int copy_idx = total/2;
-    for (int i = copy_idx; i < total; i++) {
-        recipient->array_[i - copy_idx].first = array_[i].first;
-        recipient->array_[i - copy_idx].second = array_[i].second;
-    }
+    recipient->CopyNFrom(this, copy_idx, total - copy_idx);
     recipient->SetNextPageId(GetNextPageId());
     SetNextPageId(recipient->GetPageId());
     SetSize(copy_idx);
-    recipient->SetSize(total - copy_idx);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) -> const MappingType & {
-    assert(index >= 0 && index < GetSize());
-    return array_[index];
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const -> MappingType {
+    assert(index >= 0);
+    return {KeyAt(index), ValueAt(index)};
 }
 
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndexPrecise(const KeyType &key,const KeyComparator &comparator) const -> int {
     for(int index = 0; index < GetSize(); index++){
-        if(comparator(array_[index].first,key) == 0){
+        if(comparator(KeyAt(index),key) == 0){
             return index;
         }
     }
@@ -174,33 +174,31 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::Remove(const KeyType &key,const KeyComparator &
     if (index == -1) {
         return;
     }
-    if(index < GetSize() - 1){
-        for (int i = index; i < GetSize() - 1;i ++) {
-            array_[index].first = array_[index + 1].first;
-            array_[index].second = array_[index + 1].second;
-        }
-    }
+    ShiftPairs(index + 1, -1);
     IncreaseSize(-1);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::SetItem(const KeyType &key,const ValueType &val,int index) {
     assert(index < GetSize());
-    array_[index].first = key;
-    array_[index].second = val;
+    KeyRef(index) = key;
+    ValueRef(index) = val;
 }
 
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
-    recipient->CopyNFrom(array_, GetSize());
+    recipient->CopyNFrom(this, 0, GetSize());
     recipient->SetNextPageId(GetNextPageId());
     SetSize(0);
 
 }
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {
-    std::copy(items, items + size, array_ + GetSize());
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(const BPlusTreeLeafPage *source, int index, int size) {
+    for (int i = 0; i < size; i++) {
+        KeyRef(GetSize() + i) = source->KeyAt(index + i);
+        ValueRef(GetSize() + i) = source->ValueAt(index + i);
+    }
     IncreaseSize(size);
 }
 //
@@ -253,14 +251,7 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
     if (fir_idx_larger_equal_than_key >= GetSize() || comparator(key,KeyAt(fir_idx_larger_equal_than_key)) != 0) {
         return GetSize();
     }
-    //quick deletion
-    int tar_idx = fir_idx_larger_equal_than_key;
-//    memmove(array_ + tarIdx, array_ + tarIdx + 1,static_cast<size_t>((GetSize() - tarIdx - 1)*sizeof(MappingType)));
-    int offset = static_cast<size_t>((GetSize() - tar_idx - 1)*sizeof(MappingType));
-    for (int index = 0; index < offset; index ++) {
-        array_[tar_idx + index].first = array_[tar_idx + index + 1].first;
-        array_[tar_idx + index].second = array_[tar_idx + index + 1].second;
-    }
+    ShiftPairs(fir_idx_larger_equal_than_key + 1, -1);
     IncreaseSize(-1);
     return GetSize();
 }
@@ -272,7 +263,7 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
     auto first_item = GetItem(0);
-    std::move(array_ + 1, array_ + GetSize(), array_);
+    ShiftPairs(1, -1);
     IncreaseSize(-1);
     recipient->CopyLastFrom(first_item);
 }
@@ -280,7 +271,8 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient)
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
     assert(GetSize() + 1 <= GetMaxSize());
-    array_[GetSize()] = item;
+    KeyRef(GetSize()) = item.first;
+    ValueRef(GetSize()) = item.second;
     IncreaseSize(1);
 }
 
@@ -294,8 +286,9 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient)
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {
-    std::move_backward(array_, array_ + GetSize(), array_ + GetSize() + 1);
-    *array_ = item;
+    ShiftPairs(0, 1);
+    KeyRef(0) = item.first;
+    ValueRef(0) = item.second;
     IncreaseSize(1);
 }
 
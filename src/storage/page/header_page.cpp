@@ -9,6 +9,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -23,12 +24,17 @@ auto HeaderPage::InsertRecord(const std::string &name, const page_id_t root_id)
   assert(name.length() < 32);
   assert(root_id > INVALID_PAGE_ID);
 
-  int record_num = GetRecordCount();
-  int offset = 4 + record_num * 36;
   // check for duplicate name
   if (FindRecord(name) != -1) {
     return false;
   }
+  // a header page that was never initialized, or is in the legacy format, gets the current one on the first change
+  Format();
+  int record_num = GetRecordCount();
+  int offset = OFFSET_RECORDS + record_num * RECORD_SIZE;
+  if (offset + RECORD_SIZE > static_cast<size_t>(GetPageSize())) {
+    return false;
+  }
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
   memcpy((GetData() + offset + 32), &root_id, 4);
@@ -46,8 +52,9 @@ auto HeaderPage::DeleteRecord(const std::string &name) -> bool {
   if (index == -1) {
     return false;
   }
-  int offset = index * 36 + 4;
-  memmove(GetData() + offset, GetData() + offset + 36, (record_num - index - 1) * 36);
+  Format();
+  int offset = OFFSET_RECORDS + index * RECORD_SIZE;
+  memmove(GetData() + offset, GetData() + offset + RECORD_SIZE, (record_num - index - 1) * RECORD_SIZE);
 
   SetRecordCount(record_num - 1);
   return true;
@@ -61,7 +68,8 @@ auto HeaderPage::UpdateRecord(const std::string &name, const page_id_t root_id)
   if (index == -1) {
     return false;
   }
-  int offset = index * 36 + 4;
+  Format();
+  int offset = OFFSET_RECORDS + index * RECORD_SIZE;
   // update record content, only root_id
   memcpy((GetData() + offset + 32), &root_id, 4);
 
@@ -76,7 +84,7 @@ auto HeaderPage::GetRootId(const std::string &name, page_id_t *root_id) -> bool
   if (index == -1) {
     return false;
   }
-  int offset = (index + 1) * 36;
+  int offset = RecordsOffset() + index * RECORD_SIZE + 32;
   *root_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
 
   return true;
@@ -86,15 +94,56 @@ auto HeaderPage::GetRootId(const std::string &name, page_id_t *root_id) -> bool
  * helper functions
  */
 // record count
-auto HeaderPage::GetRecordCount() -> int { return *reinterpret_cast<int *>(GetData()); }
+auto HeaderPage::GetRecordCount() -> int {
+  const auto offset = IsFormatted() ? OFFSET_RECORD_COUNT : LEGACY_OFFSET_RECORD_COUNT;
+  return *reinterpret_cast<int *>(GetData() + offset);
+}
+
+void HeaderPage::SetRecordCount(int record_count) { memcpy(GetData() + OFFSET_RECORD_COUNT, &record_count, 4); }
+
+// page size
+auto HeaderPage::ReadPageSize(const char *data) -> int {
+  uint32_t magic;
+  memcpy(&magic, data + OFFSET_MAGIC, 4);
+  if (magic != MAGIC) {
+    return std::all_of(data, data + OFFSET_RECORD_COUNT, [](char c) { return c == 0; }) ? 0 : LEGACY_PAGE_SIZE;
+  }
+  int page_size;
+  memcpy(&page_size, data + OFFSET_PAGE_SIZE, 4);
+  return page_size;
+}
+
+void HeaderPage::SetPageSize() {
+  const uint32_t magic = MAGIC;
+  const int page_size = GetPageSize();
+  memcpy(GetData() + OFFSET_MAGIC, &magic, 4);
+  memcpy(GetData() + OFFSET_PAGE_SIZE, &page_size, 4);
+}
+
+auto HeaderPage::IsFormatted() -> bool {
+  uint32_t magic;
+  memcpy(&magic, GetData() + OFFSET_MAGIC, 4);
+  return magic == MAGIC;
+}
+
+auto HeaderPage::RecordsOffset() -> size_t { return IsFormatted() ? OFFSET_RECORDS : LEGACY_OFFSET_RECORDS; }
 
-void HeaderPage::SetRecordCount(int record_count) { memcpy(GetData(), &record_count, 4); }
+void HeaderPage::Format() {
+  if (IsFormatted()) {
+    return;
+  }
+  const int record_num = GetRecordCount();
+  memmove(GetData() + OFFSET_RECORDS, GetData() + LEGACY_OFFSET_RECORDS, record_num * RECORD_SIZE);
+  SetPageSize();
+  SetRecordCount(record_num);
+}
 
 auto HeaderPage::FindRecord(const std::string &name) -> int {
   int record_num = GetRecordCount();
+  const auto records_offset = RecordsOffset();
 
   for (int i = 0; i < record_num; i++) {
-    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i * 36));
+    char *raw_name = reinterpret_cast<char *>(GetData() + (records_offset + i * RECORD_SIZE));
     if (strcmp(raw_name, name.c_str()) == 0) {
       return i;
     }
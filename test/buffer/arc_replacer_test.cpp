@@ -0,0 +1,60 @@
+/**
+ * arc_replacer_test.cpp
+ */
+
+#include "buffer/arc_replacer.h"
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ARCReplacerTest, SampleTest) {
+  ARCReplacer arc_replacer(4);
+
+  // Scenario: frames 0-3 hold pages 10-13, all seen once, so all of them are in T1.
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    arc_replacer.RecordAccess(frame_id, 10 + frame_id);
+    arc_replacer.SetEvictable(frame_id, true);
+  }
+  ASSERT_EQ(4, arc_replacer.Size());
+
+  // Scenario: a second access moves page 11 to T2. T1 is above its target size, so victims come from T1 in LRU
+  // order and their pages are remembered in B1.
+  arc_replacer.RecordAccess(1, 11);
+  frame_id_t value;
+  ASSERT_EQ(true, arc_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(true, arc_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_EQ(2, arc_replacer.Size());
+
+  // Scenario: page 10 comes back while it is in B1. It goes straight to T2, and the target size of T1 grows to 1.
+  arc_replacer.RecordAccess(0, 10);
+  arc_replacer.SetEvictable(0, true);
+
+  // T1 = [13] is no longer above its target, so the LRU page of T2 is evicted and remembered in B2.
+  ASSERT_EQ(true, arc_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+
+  // Scenario: page 11 comes back while it is in B2, which shrinks the target size of T1 to 0 again.
+  arc_replacer.RecordAccess(1, 11);
+  arc_replacer.SetEvictable(1, true);
+  ASSERT_EQ(true, arc_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+
+  // Scenario: pinned frames are skipped. T2 = [11, 10] with frame 1 (page 11) pinned.
+  arc_replacer.SetEvictable(1, false);
+  ASSERT_EQ(1, arc_replacer.Size());
+  ASSERT_EQ(true, arc_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(false, arc_replacer.Evict(&value));
+
+  // Removing a pinned frame is an error, removing an untracked one does nothing.
+  ASSERT_ANY_THROW(arc_replacer.Remove(1));
+  arc_replacer.Remove(2);
+  arc_replacer.SetEvictable(1, true);
+  arc_replacer.Remove(1);
+  ASSERT_EQ(0, arc_replacer.Size());
+}
+
+}  // namespace bustub
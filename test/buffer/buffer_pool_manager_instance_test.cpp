@@ -12,12 +12,26 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>  // NOLINT
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#ifdef __linux__
+#include "storage/disk/disk_manager_uring.h"
+#endif
+#include "storage/page/header_page.h"
 
 namespace bustub {
 
@@ -145,4 +159,925 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+/** A disk manager that counts the pages it reads. */
+class CountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    num_reads_++;
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  std::atomic<size_t> num_reads_{0};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BulkReadStrategyTest) {
+  const size_t buffer_pool_size = 16;
+  const int num_cold_pages = 64;
+  const int num_hot_pages = 4;
+
+  // Write a table four times the size of the pool followed by a few other pages, scan the table once, and return how
+  // many of the other pages had to be read back from disk afterwards.
+  auto scan = [&](BufferAccessStrategy *strategy) -> size_t {
+    auto *disk_manager = new CountingDiskManager();
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+    page_id_t page_id;
+    for (int i = 0; i < num_cold_pages + num_hot_pages; i++) {
+      auto *page = bpm->NewPage(&page_id);
+      EXPECT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    for (page_id_t cold_page = 0; cold_page < num_cold_pages; cold_page++) {
+      auto *page = bpm->FetchPage(cold_page, strategy);
+      EXPECT_NE(nullptr, page);
+      EXPECT_EQ(std::to_string(cold_page), std::string(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(cold_page, false));
+    }
+    size_t num_reads = disk_manager->num_reads_;
+    for (page_id_t hot_page = num_cold_pages; hot_page < num_cold_pages + num_hot_pages; hot_page++) {
+      EXPECT_NE(nullptr, bpm->FetchPage(hot_page));
+      EXPECT_TRUE(bpm->UnpinPage(hot_page, false));
+    }
+    num_reads = disk_manager->num_reads_ - num_reads;
+
+    delete bpm;
+    delete disk_manager;
+    return num_reads;
+  };
+
+  // Scenario: a scan through a ring of two frames reuses its own frames once the ring is full, so the other pages
+  // survive the scan.
+  BufferAccessStrategy strategy(2);
+  EXPECT_EQ(0, scan(&strategy));
+
+  // Scenario: the same scan without a strategy goes through the whole pool and pushes the other pages out.
+  EXPECT_EQ(num_hot_pages, scan(nullptr));
+
+  // Scenario: a scan cannot recycle a ring frame that is still pinned, so it falls back to the rest of the pool.
+  auto *disk_manager = new CountingDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size * 2; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  BufferAccessStrategy pinned_strategy(1);
+  ASSERT_NE(nullptr, bpm->FetchPage(0, &pinned_strategy));
+  ASSERT_NE(nullptr, bpm->FetchPage(1, &pinned_strategy));
+  ASSERT_NE(bpm->FetchPage(0), bpm->FetchPage(1));
+  for (page_id_t pinned_page = 0; pinned_page < 2; pinned_page++) {
+    ASSERT_TRUE(bpm->UnpinPage(pinned_page, false));
+    ASSERT_TRUE(bpm->UnpinPage(pinned_page, false));
+  }
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageCleanerTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_clean_frames = 8;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Fill the pool with dirty pages.
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the cleaner writes back the coldest pages, and only as many as it is asked to keep clean.
+  bpm->RunPageCleaner(num_clean_frames);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->GetBackgroundWrites() < num_clean_frames && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopPageCleaner();
+  ASSERT_EQ(num_clean_frames, bpm->GetBackgroundWrites());
+
+  // Scenario: new pages now evict the clean frames first, so they do not have to write anything.
+  for (size_t i = 0; i < num_clean_frames; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundWrites());
+
+  // Scenario: evicting pages the cleaner did not get to writes them in the foreground. Nothing was lost either way.
+  for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(i), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(buffer_pool_size - num_clean_frames, bpm->GetForegroundWrites());
+  EXPECT_EQ(num_clean_frames, bpm->GetBackgroundWrites());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const size_t buffer_pool_size = 16;
+  const int num_pages = 64;
+
+  auto *disk_manager = new CountingDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Every page stores the id of the page two further on, forming the chain 0 -> 2 -> 4 -> ...
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    *reinterpret_cast<page_id_t *>(page->GetData()) = page_id + 2 < num_pages ? page_id + 2 : INVALID_PAGE_ID;
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  auto wait_for_reads = [&](size_t num_reads) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (disk_manager->num_reads_ < num_reads && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(num_reads, disk_manager->num_reads_);
+  };
+  auto expect_resident = [&](page_id_t page_id) {
+    auto num_reads = disk_manager->num_reads_.load();
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    EXPECT_EQ(num_reads, disk_manager->num_reads_);
+  };
+
+  // Scenario: a range of consecutive pages is read in the background, and fetching them afterwards is all hits.
+  bpm->PrefetchRange(0, 4);
+  wait_for_reads(4);
+  for (page_id_t i = 0; i < 4; i++) {
+    expect_resident(i);
+  }
+
+  // Scenario: prefetching a resident page does not read anything.
+  bpm->PrefetchPage(0);
+  bpm->PrefetchPage(8);
+  wait_for_reads(5);
+  expect_resident(8);
+
+  // Scenario: a chain is followed through the pages as they come in.
+  auto next_page = [](Page *page) { return *reinterpret_cast<page_id_t *>(page->GetData()); };
+  bpm->PrefetchRange(20, 4, next_page);
+  wait_for_reads(9);
+  for (page_id_t i = 20; i < 28; i += 2) {
+    expect_resident(i);
+  }
+
+  // Scenario: following a chain stops at its end. The last pages are still resident, so only page 40 is read.
+  bpm->PrefetchRange(num_pages - 4, buffer_pool_size, next_page);
+  bpm->PrefetchPage(40);
+  wait_for_reads(10);
+  expect_resident(40);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+#ifdef __linux__
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, AsyncDiskManagerTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 32;
+  remove(db_name.c_str());
+
+  // FlushAllPages writes the whole pool as one batch.
+  {
+    DiskManagerUring disk_manager(db_name);
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+    page_id_t page_id;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    bpm.FlushAllPages();
+    EXPECT_EQ(buffer_pool_size, disk_manager.GetNumWrites());
+    for (page_id_t i = 0; i < static_cast<page_id_t>(buffer_pool_size); i++) {
+      EXPECT_FALSE(bpm.FetchPage(i)->IsDirty());
+      ASSERT_TRUE(bpm.UnpinPage(i, false));
+    }
+  }
+
+  // A consecutive range is read ahead as one batch. Fetching the pages afterwards finds what was written.
+  {
+    DiskManagerUring disk_manager(db_name);
+    BufferPoolManagerInstance bpm(buffer_pool_size / 2, &disk_manager, 2);
+    bpm.PrefetchRange(4, 8);
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); page_id++) {
+      auto *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), page->GetData());
+      ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+    }
+  }
+
+  // Scenario: fetches race batches read ahead of the same pages, which are read without the latch. A fetch of a page
+  // being read ahead waits for it rather than read it into a second frame, where the fetches counted in the page would
+  // be lost, and one that finds every other frame reading a page ahead waits for a frame rather than fail.
+  {
+    DiskManagerUring disk_manager(db_name);
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    const size_t count_offset = 64;
+    const int num_fetchers = 3;
+    std::atomic<bool> done{false};
+    std::atomic<int> num_fetches{0};
+    std::vector<std::thread> fetchers;
+    for (int t = 0; t < num_fetchers; t++) {
+      fetchers.emplace_back([&, t] {
+        std::mt19937 rng(t);
+        while (!done) {
+          const auto page_id = static_cast<page_id_t>(rng() % buffer_pool_size);
+          auto *page = bpm.FetchPage(page_id);
+          ASSERT_NE(nullptr, page);
+          page->WLatch();
+          EXPECT_EQ("page " + std::to_string(page_id), page->GetData());
+          reinterpret_cast<int *>(page->GetData() + count_offset)[0]++;
+          page->WUnlatch();
+          ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+          num_fetches++;
+        }
+      });
+    }
+    for (int round = 0; round < 2000; round++) {
+      const auto first_page_id = static_cast<page_id_t>(round % (buffer_pool_size - 3));
+      bpm.ReadAheadPages({first_page_id, first_page_id + 1, first_page_id + 2, first_page_id + 3}, nullptr);
+    }
+    done = true;
+    for (auto &fetcher : fetchers) {
+      fetcher.join();
+    }
+    EXPECT_EQ(0, bpm.GetNumPinnedFrames());
+
+    int num_counted = 0;
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); page_id++) {
+      auto *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      num_counted += reinterpret_cast<int *>(page->GetData() + count_offset)[0];
+      ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(num_fetches, num_counted);
+  }
+
+  remove(db_name.c_str());
+  remove("test.log");
+  remove("test.fsm");
+}
+#endif
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FreePageReuseTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  remove(db_name.c_str());
+
+  page_id_t page_id;
+  {
+    DiskManager disk_manager(db_name);
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+    for (page_id_t i = 0; i < 6; i++) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      EXPECT_EQ(i, page_id);
+      ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    // Page 1 was evicted, page 4 is resident. Both are freed.
+    EXPECT_TRUE(bpm.DeletePage(1));
+    EXPECT_TRUE(bpm.DeletePage(4));
+    bpm.FlushAllPages();
+  }
+
+  // After a restart, new pages fill the holes before the database grows.
+  DiskManager disk_manager(db_name);
+  BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+  for (page_id_t expected : {1, 4, 6}) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    EXPECT_EQ(expected, page_id);
+    ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+  }
+  disk_manager.ShutDown();
+
+  remove(db_name.c_str());
+  remove("test.log");
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ExtentTest) {
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(8, disk_manager, 2);
+  PageExtent table_extent(4);
+  PageExtent index_extent(4);
+
+  // Two objects growing at the same time each get runs of consecutive pages.
+  std::vector<page_id_t> table_pages;
+  std::vector<page_id_t> index_pages;
+  page_id_t page_id;
+  for (int i = 0; i < 6; i++) {
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &table_extent));
+    table_pages.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &index_extent));
+    index_pages.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ((std::vector<page_id_t>{0, 1, 2, 3, 8, 9}), table_pages);
+  EXPECT_EQ((std::vector<page_id_t>{4, 5, 6, 7, 12, 13}), index_pages);
+
+  // Pages without an extent go after the reserved runs, and freed pages are reused for the next run.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(16, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  for (page_id_t free_page_id : {0, 1, 2, 3}) {
+    ASSERT_TRUE(bpm->DeletePage(free_page_id));
+  }
+  PageExtent other_extent(4);
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &other_extent));
+  EXPECT_EQ(0, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // A page that cannot get a frame goes back to the extent.
+  std::vector<page_id_t> pinned;
+  while (bpm->NewPage(&page_id) != nullptr) {
+    pinned.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPageInExtent(&page_id, &other_extent));
+  for (auto pinned_page_id : pinned) {
+    ASSERT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &other_extent));
+  EXPECT_EQ(1, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/** A disk manager that records the first page and the length of every write. */
+class RecordingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    RecordWrite(page_id, 1);
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+  }
+
+  void WritePages(page_id_t first_page_id, const std::vector<const char *> &pages) override {
+    RecordWrite(first_page_id, pages.size());
+    for (size_t i = 0; i < pages.size(); i++) {
+      DiskManagerUnlimitedMemory::WritePage(first_page_id + static_cast<page_id_t>(i), pages[i]);
+    }
+  }
+
+  void RecordWrite(page_id_t first_page_id, size_t num_pages) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    writes_.emplace_back(first_page_id, num_pages);
+  }
+
+  std::mutex mutex_;
+  std::vector<std::pair<page_id_t, size_t>> writes_;
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushAllTest) {
+  auto *disk_manager = new RecordingDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager, 2);
+
+  // Pages 0-9 are dirty except for page 4; pages 10 and 11 are clean. Page 7 is still pinned.
+  page_id_t page_id;
+  for (int i = 0; i < 12; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, page_id < 10 && page_id != 4));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(7));
+  // NewPage writes nothing; only the flush does.
+  ASSERT_TRUE(disk_manager->writes_.empty());
+
+  // The dirty pages go out as one write per run of consecutive ids, pinned pages included, and end up clean.
+  bpm->FlushAllPages();
+  EXPECT_EQ((std::vector<std::pair<page_id_t, size_t>>{{0, 4}, {5, 5}}), disk_manager->writes_);
+  char buf[BUSTUB_PAGE_SIZE];
+  disk_manager->ReadPage(8, buf);
+  EXPECT_EQ(std::string("page 8"), buf);
+  for (page_id_t i = 0; i < 12; i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_FALSE(page->IsDirty());
+    ASSERT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  // Nothing is dirty any more, so a second flush writes nothing.
+  disk_manager->writes_.clear();
+  bpm->FlushAllPages();
+  EXPECT_TRUE(disk_manager->writes_.empty());
+  ASSERT_TRUE(bpm->UnpinPage(7, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageSizeTest) {
+  const std::string db_name = "test.db";
+  const int page_size = 16384;
+  remove(db_name.c_str());
+  remove("test.fsm");
+
+  EXPECT_THROW(DiskManager(db_name, 12288), Exception);
+  EXPECT_THROW(DiskManager(db_name, 2 * BUSTUB_MAX_PAGE_SIZE), Exception);
+
+  // A new database gets the page size it is created with, and its frames are that large.
+  {
+    DiskManager disk_manager(db_name, page_size);
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    EXPECT_EQ(page_size, bpm.GetPageSize());
+    page_id_t page_id;
+    auto *header_page = static_cast<HeaderPage *>(bpm.NewPage(&page_id));
+    ASSERT_EQ(HEADER_PAGE_ID, page_id);
+    EXPECT_EQ(page_size, header_page->GetPageSize());
+    ASSERT_TRUE(header_page->InsertRecord("foo", 1));
+    ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+
+    // The last byte of a page survives the trip to disk, at an offset that a 4K page size would not reach.
+    for (int i = 0; i < 6; i++) {
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), page_size, "page %d", page_id);
+      page->GetData()[page_size - 1] = static_cast<char>('a' + page_id);
+      ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    bpm.FlushAllPages();
+  }
+
+  // Reopening it with another page size still uses the one recorded in the header page.
+  {
+    DiskManager disk_manager(db_name);
+    EXPECT_EQ(page_size, disk_manager.GetPageSize());
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    auto *header_page = static_cast<HeaderPage *>(bpm.FetchPage(HEADER_PAGE_ID));
+    page_id_t root_id;
+    ASSERT_TRUE(header_page->GetRootId("foo", &root_id));
+    EXPECT_EQ(1, root_id);
+    ASSERT_TRUE(bpm.UnpinPage(HEADER_PAGE_ID, false));
+    for (page_id_t i = 1; i <= 6; i++) {
+      auto *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), page->GetData());
+      EXPECT_EQ(static_cast<char>('a' + i), page->GetData()[page_size - 1]);
+      ASSERT_TRUE(bpm.UnpinPage(i, false));
+    }
+  }
+
+  // Scenario: the in-memory disk managers keep whole pages of the size they are given, too.
+  EXPECT_THROW(DiskManagerUnlimitedMemory(12288), Exception);
+  DiskManagerUnlimitedMemory unlimited_memory(page_size);
+  DiskManagerMemory memory(8, page_size);
+  for (DiskManager *disk_manager : std::vector<DiskManager *>{&unlimited_memory, &memory}) {
+    BufferPoolManagerInstance bpm(2, disk_manager, 2);
+    EXPECT_EQ(page_size, bpm.GetPageSize());
+    page_id_t page_id;
+    for (int i = 0; i < 6; i++) {
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      page->GetData()[page_size - 1] = static_cast<char>('a' + page_id);
+      ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    // The pool holds two pages, so the first ones come back from the disk manager.
+    for (page_id_t i = 0; i < 6; i++) {
+      auto *page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(static_cast<char>('a' + i), page->GetData()[page_size - 1]);
+      ASSERT_TRUE(bpm.UnpinPage(i, false));
+    }
+  }
+
+  remove(db_name.c_str());
+  remove("test.log");
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, LegacyHeaderPageTest) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+  remove("test.fsm");
+
+  // A database written before the header page recorded the page size: the record count is at offset 0.
+  {
+    std::vector<char> data(HeaderPage::LEGACY_PAGE_SIZE);
+    const int record_count = 2;
+    const page_id_t root_ids[] = {3, 7};
+    memcpy(data.data(), &record_count, 4);
+    for (int i = 0; i < record_count; i++) {
+      const auto offset = HeaderPage::LEGACY_OFFSET_RECORDS + i * HeaderPage::RECORD_SIZE;
+      snprintf(data.data() + offset, 32, "index_%d", i);
+      memcpy(data.data() + offset + 32, &root_ids[i], 4);
+    }
+    FILE *file = fopen(db_name.c_str(), "wb");
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(data.size(), fwrite(data.data(), 1, data.size(), file));
+    fclose(file);
+  }
+
+  // It opens as a 4K database whatever page size is asked for, and its records read as they were written.
+  {
+    DiskManager disk_manager(db_name, 16384);
+    EXPECT_EQ(HeaderPage::LEGACY_PAGE_SIZE, disk_manager.GetPageSize());
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    auto *header_page = static_cast<HeaderPage *>(bpm.FetchPage(HEADER_PAGE_ID));
+    ASSERT_NE(nullptr, header_page);
+    EXPECT_EQ(2, header_page->GetRecordCount());
+    page_id_t root_id;
+    ASSERT_TRUE(header_page->GetRootId("index_1", &root_id));
+    EXPECT_EQ(7, root_id);
+
+    // The first change converts the page to the current format, keeping the records.
+    ASSERT_TRUE(header_page->InsertRecord("index_2", 9));
+    EXPECT_EQ(HeaderPage::LEGACY_PAGE_SIZE, HeaderPage::ReadPageSize(header_page->GetData()));
+    EXPECT_EQ(3, header_page->GetRecordCount());
+    ASSERT_TRUE(header_page->GetRootId("index_0", &root_id));
+    EXPECT_EQ(3, root_id);
+    ASSERT_TRUE(bpm.UnpinPage(HEADER_PAGE_ID, true));
+    bpm.FlushAllPages();
+  }
+
+  {
+    DiskManager disk_manager(db_name, 16384);
+    EXPECT_EQ(HeaderPage::LEGACY_PAGE_SIZE, disk_manager.GetPageSize());
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    auto *header_page = static_cast<HeaderPage *>(bpm.FetchPage(HEADER_PAGE_ID));
+    ASSERT_NE(nullptr, header_page);
+    page_id_t root_id;
+    ASSERT_TRUE(header_page->GetRootId("index_2", &root_id));
+    EXPECT_EQ(9, root_id);
+    ASSERT_TRUE(bpm.UnpinPage(HEADER_PAGE_ID, false));
+  }
+
+  remove(db_name.c_str());
+  remove("test.log");
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, HotPagesTest) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+  remove("test.fsm");
+  remove("test.hot");
+
+  DiskManager disk_manager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(8, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 8; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Pages 5 and 2 are used twice, page 5 more recently. Page 3 is pinned, which makes it the hottest.
+  for (page_id_t hot_page_id : {5, 2}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(hot_page_id));
+    ASSERT_TRUE(bpm->UnpinPage(hot_page_id, false));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  const std::vector<page_id_t> hot_pages{3, 5, 2, 7, 6, 4, 1, 0};
+  EXPECT_EQ(hot_pages, bpm->GetHotPages());
+
+  bpm->FlushAllPages();
+  bpm->SaveHotPages();
+  EXPECT_EQ(hot_pages, BufferPoolManagerInstance::ReadHotPageFile("test.hot"));
+  ASSERT_TRUE(bpm->UnpinPage(3, false));
+  delete bpm;
+
+  // A smaller pool gets the hottest pages, ranked as they were.
+  bpm = new BufferPoolManagerInstance(4, &disk_manager, 2);
+  EXPECT_EQ(4, bpm->PreloadHotPages());
+  EXPECT_EQ((std::vector<page_id_t>{3, 5, 2, 7}), bpm->GetHotPages());
+  for (page_id_t i : {3, 5, 2, 7}) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), page->GetData());
+    ASSERT_TRUE(bpm->UnpinPage(i, false));
+  }
+  delete bpm;
+
+  // Pages deleted since the list was saved are skipped, and pages already resident are not read again.
+  disk_manager.DeallocatePage(2);
+  bpm = new BufferPoolManagerInstance(8, &disk_manager, 2);
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(6, bpm->PreloadHotPages());
+  EXPECT_EQ((std::vector<page_id_t>{0, 3, 5, 7, 6, 4, 1}), bpm->GetHotPages());
+  ASSERT_TRUE(bpm->UnpinPage(0, false));
+  delete bpm;
+
+  disk_manager.ShutDown();
+  remove(db_name.c_str());
+  remove("test.log");
+  remove("test.fsm");
+  remove("test.hot");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const std::string db_name = "test.db";
+  remove(db_name.c_str());
+  remove("test.fsm");
+
+  DiskManager disk_manager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(4, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+  EXPECT_EQ(4, bpm->GetNumPinnedFrames());
+
+  // Scenario: with one unpinned frame, a new page evicts its dirty page and a fetch of that page evicts the new one.
+  ASSERT_TRUE(bpm->UnpinPage(3, true));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(3));
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(4, bpm->GetNumPinnedFrames());
+
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(1, stats.hits_);
+  EXPECT_EQ(1, stats.misses_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(1, stats.dirty_evictions_);
+  EXPECT_EQ(4, stats.pinned_high_water_);
+  EXPECT_EQ(0, stats.latch_waits_);
+  EXPECT_EQ(1, disk_manager.GetNumReads());
+  EXPECT_EQ(1, disk_manager.GetReadLatency().Count());
+  EXPECT_EQ(1, disk_manager.GetWriteLatency().Count());
+
+  // Scenario: unpinning every frame brings the count back to zero but leaves the high-water mark.
+  for (page_id_t i : {0, 0, 1, 2, 3}) {
+    ASSERT_TRUE(bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(0, bpm->GetNumPinnedFrames());
+  EXPECT_EQ(4, bpm->GetStats().pinned_high_water_);
+  delete bpm;
+
+  // Scenario: percentiles are rounded up to a power of two nanoseconds; the mean is exact.
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.PercentileNs(50));
+  for (int i = 0; i < 99; i++) {
+    histogram.Record(1000);
+  }
+  histogram.Record(1000000);
+  EXPECT_EQ(100, histogram.Count());
+  EXPECT_EQ(10990, histogram.MeanNs());
+  EXPECT_EQ(1024, histogram.PercentileNs(50));
+  EXPECT_EQ(1 << 20, histogram.PercentileNs(99));
+
+  disk_manager.ShutDown();
+  remove(db_name.c_str());
+  remove("test.fsm");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FrameArenaTest) {
+  // Scenario: a pool of at least one huge page starts on a huge page boundary, if huge pages are in use.
+  const size_t num_frames = 1000;
+  FrameArena arena(num_frames, BUSTUB_PAGE_SIZE, true);
+  if (arena.UsesHugePages()) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % FrameArena::HUGE_PAGE_SIZE);
+  }
+  // Scenario: every frame is zeroed, writable, and aligned for direct I/O, for small pools and larger pages too.
+  FrameArena small_arena(3, 16384, true);
+  EXPECT_FALSE(small_arena.UsesHugePages());
+  for (auto *frame_arena : {&arena, &small_arena}) {
+    for (frame_id_t i = 0; i < 3; i++) {
+      char *frame = frame_arena->GetFrame(i);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(frame) % FrameArena::FRAME_ALIGNMENT);
+      EXPECT_EQ(0, frame[0]);
+      frame[0] = 'x';
+    }
+  }
+  EXPECT_EQ(BUSTUB_PAGE_SIZE, arena.GetFrame(1) - arena.GetFrame(0));
+  arena.GetFrame(num_frames - 1)[BUSTUB_PAGE_SIZE - 1] = 'x';
+
+  // Scenario: the pages of a buffer pool point into its arena.
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager, 2);
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(bpm->GetPages()[i].GetData()) % FrameArena::FRAME_ALIGNMENT);
+  }
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager, 2, nullptr, ReplacerPolicy::LRU_K, 8);
+  EXPECT_EQ(8, bpm->GetMaxPoolSize());
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(9));
+
+  // Scenario: growing adds free frames right away.
+  std::vector<page_id_t> page_ids(8);
+  for (size_t i = 0; i < 4; i++) {
+    auto *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+  }
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->Resize(8));
+  EXPECT_EQ(8, bpm->GetPoolSize());
+  for (size_t i = 4; i < 8; i++) {
+    auto *page = bpm->NewPage(&page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+  }
+
+  // Scenario: shrinking evicts the pages beyond the new size in the background, waiting for the pinned ones.
+  for (size_t i = 0; i < 8; i++) {
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+  auto *pinned = bpm->FetchPage(page_ids[7]);
+  ASSERT_NE(nullptr, pinned);
+  ASSERT_TRUE(bpm->Resize(2));
+  EXPECT_EQ(2, bpm->GetPoolSize());
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_TRUE(bpm->IsShrinking());
+  EXPECT_STREQ("page 7", pinned->GetData());
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[7], false));
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (bpm->IsShrinking() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_FALSE(bpm->IsShrinking());
+
+  // Scenario: only two pages fit now, and every page reads back from disk intact.
+  std::vector<Page *> pages;
+  for (size_t i = 0; i < 2; i++) {
+    pages.push_back(bpm->FetchPage(page_ids[i]));
+    ASSERT_NE(nullptr, pages.back());
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[2]));
+  for (size_t i = 0; i < 2; i++) {
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  for (size_t i = 0; i < 8; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+
+  // Scenario: growing again brings the retired frames back.
+  ASSERT_TRUE(bpm->Resize(6));
+  for (size_t i = 0; i < 6; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[6]));
+  for (size_t i = 0; i < 6; i++) {
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+
+  // Scenario: queries keep running, and see their pages intact, while the pool is resized back and forth.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; t++) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      while (!done) {
+        const auto i = rng() % page_ids.size();
+        auto *page = bpm->FetchPage(page_ids[i]);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+        bpm->UnpinPage(page_ids[i], false);
+      }
+    });
+  }
+  for (size_t pool_size : {2, 8, 3, 7, 1, 5, 8}) {
+    ASSERT_TRUE(bpm->Resize(pool_size));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  done = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentEvictionTest) {
+  const size_t pool_size = 4;
+  const size_t num_pages = 12;
+  for (auto policy : {ReplacerPolicy::LRU_K, ReplacerPolicy::ARC, ReplacerPolicy::TWO_Q}) {
+    auto *disk_manager = new DiskManagerUnlimitedMemory();
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, 2, nullptr, policy);
+    std::vector<page_id_t> page_ids(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      auto *page = bpm->NewPage(&page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+    }
+
+    // Scenario: threads race to fetch and unpin the same few pages while the pool keeps evicting them, so that hits
+    // pin frames being claimed and unpins follow pins that failed. Every fetch sees its own page.
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 8; t++) {
+      threads.emplace_back([&, t] {
+        std::mt19937 rng(t);
+        for (size_t n = 0; n < 5000; n++) {
+          // Most fetches go to the first pages, the rest make the pool evict them.
+          const auto i = rng() % 4 == 0 ? rng() % num_pages : rng() % pool_size;
+          auto *page = bpm->FetchPage(page_ids[i]);
+          if (page == nullptr) {
+            // Every frame is pinned by the other threads.
+            continue;
+          }
+          EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+          EXPECT_TRUE(bpm->UnpinPage(page_ids[i], rng() % 2 == 0));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    // Scenario: no frame was left pinned, nor out of the replacer's reach: the whole pool can be evicted again.
+    EXPECT_EQ(0, bpm->GetNumPinnedFrames());
+    for (size_t i = 0; i < pool_size; i++) {
+      page_id_t page_id;
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    }
+    EXPECT_EQ(pool_size, bpm->GetNumPinnedFrames());
+    for (size_t i = 0; i < num_pages; i++) {
+      EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[i]));
+    }
+
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+/**
+ * Fill a pool of pool_size frames with pinned hot pages except for a handful of frames, then cycle through twice as
+ * many cold pages as there are unpinned frames so that every fetch is a miss. Returns the average miss latency in ns.
+ */
+auto MissLatencyBenchmarkCall(size_t pool_size) -> size_t {
+  const size_t unpinned_frames = 16;
+  const int num_misses = 200000;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, 2);
+
+  // The pinned pages take the lowest frames and have been accessed twice, so they sit in the replacer's cache list.
+  page_id_t page_id;
+  for (size_t i = 0; i < pool_size - unpinned_frames; i++) {
+    bpm->NewPage(&page_id);
+    bpm->FetchPage(page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+  std::vector<page_id_t> cold_pages;
+  for (size_t i = 0; i < 2 * unpinned_frames; i++) {
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(page_id, true);
+    cold_pages.push_back(page_id);
+  }
+
+  auto clock_start = std::chrono::system_clock::now();
+  for (int i = 0; i < num_misses; i++) {
+    auto cold_page = cold_pages[i % cold_pages.size()];
+    bpm->FetchPage(cold_page);
+    bpm->UnpinPage(cold_page, false);
+  }
+  auto clock_end = std::chrono::system_clock::now();
+
+  delete bpm;
+  delete disk_manager;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_end - clock_start).count() / num_misses;
+}
+
+TEST(BufferPoolManagerInstanceTest, DISABLED_MissLatencyBenchmark) {  // NOLINT
+  std::cout << "This test shows that the latency of a buffer pool miss does not depend on the pool size." << std::endl;
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t pool_size = 1 << 10; pool_size <= 1 << 16; pool_size <<= 2) {
+    auto ns = MissLatencyBenchmarkCall(pool_size);
+    std::cout << "Pool size: " << pool_size << " Miss latency (ns): " << ns << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
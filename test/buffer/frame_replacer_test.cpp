@@ -0,0 +1,257 @@
+/**
+ * frame_replacer_test.cpp
+ */
+
+#include "buffer/frame_replacer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+static const std::vector<ReplacerPolicy> ALL_POLICIES{ReplacerPolicy::LRU_K, ReplacerPolicy::ARC,
+                                                      ReplacerPolicy::TWO_Q};
+
+/**
+ * An OLTP-style trace: hot_pages pages accessed at random, interrupted every scan_interval accesses by a sequential
+ * scan over scan_pages pages that are never seen again.
+ */
+auto MakeScanTrace(int hot_pages, int scan_pages, int num_scans, int scan_interval) -> std::vector<page_id_t> {
+  std::mt19937 generator(15445);
+  std::uniform_int_distribution<page_id_t> hot(0, hot_pages - 1);
+  std::vector<page_id_t> trace;
+  page_id_t next_scan_page = hot_pages;
+  for (int scan = 0; scan < num_scans; scan++) {
+    for (int i = 0; i < scan_interval; i++) {
+      trace.push_back(hot(generator));
+    }
+    for (int i = 0; i < scan_pages; i++) {
+      trace.push_back(next_scan_page++);
+    }
+  }
+  return trace;
+}
+
+TEST(FrameReplacerTest, PolicyNameTest) {
+  for (auto policy : ALL_POLICIES) {
+    ReplacerPolicy parsed;
+    ASSERT_TRUE(ParseReplacerPolicy(ReplacerPolicyToString(policy), &parsed));
+    ASSERT_EQ(policy, parsed);
+  }
+  ReplacerPolicy parsed;
+  ASSERT_FALSE(ParseReplacerPolicy("clock", &parsed));
+}
+
+TEST(FrameReplacerTest, ScanResistanceTest) {
+  // The hot set fits in the pool with room to spare, but every scan alone is larger than the pool. A scan-resistant
+  // policy only loses what it needs to make room for the scan, so the hot set stays cached across scans.
+  const int hot_pages = 48;
+  const int scan_pages = 256;
+  const int num_scans = 20;
+  const int scan_interval = 2000;
+  auto trace = MakeScanTrace(hot_pages, scan_pages, num_scans, scan_interval);
+
+  // Every scan access is a compulsory miss, so at best every hot access but the very first ones hits.
+  const double best_hit_ratio = static_cast<double>(num_scans * scan_interval - hot_pages) / trace.size();
+  for (auto policy : ALL_POLICIES) {
+    auto result = ReplayTrace(policy, 64, 2, trace);
+    ASSERT_EQ(trace.size(), result.accesses_);
+    EXPECT_GT(result.HitRatio(), 0.95 * best_hit_ratio) << ReplacerPolicyToString(policy);
+  }
+}
+
+TEST(FrameReplacerTest, PeekVictimsTest) {
+  const size_t num_frames = 8;
+  for (auto policy : ALL_POLICIES) {
+    auto replacer = MakeFrameReplacer(policy, num_frames, 2);
+    for (size_t i = 0; i < num_frames; i++) {
+      replacer->RecordAccess(i, i);
+      replacer->SetEvictable(i, i != 3);
+    }
+    replacer->RecordAccess(5, 5);
+
+    // Peeking lists evictable frames only, and neither evicts them nor changes their order.
+    auto victims = replacer->PeekVictims(3);
+    ASSERT_EQ(3, victims.size());
+    auto all_victims = replacer->PeekVictims(num_frames);
+    ASSERT_EQ(num_frames - 1, all_victims.size());
+    EXPECT_EQ(all_victims.end(), std::find(all_victims.begin(), all_victims.end(), 3));
+    EXPECT_EQ(victims, std::vector<frame_id_t>(all_victims.begin(), all_victims.begin() + 3));
+    EXPECT_EQ(num_frames - 1, replacer->Size());
+
+    // Pinning a cold frame for a moment without an access, as the page cleaner does, leaves it where it was.
+    replacer->SetEvictable(victims[1], false);
+    replacer->SetEvictable(victims[1], true);
+    EXPECT_EQ(all_victims, replacer->PeekVictims(num_frames));
+
+    frame_id_t frame_id;
+    ASSERT_TRUE(replacer->Evict(&frame_id));
+    EXPECT_EQ(victims[0], frame_id) << ReplacerPolicyToString(policy);
+  }
+
+  // LRU-K lists its victims in exactly the order it evicts them.
+  auto replacer = MakeFrameReplacer(ReplacerPolicy::LRU_K, num_frames, 2);
+  for (size_t i = 0; i < num_frames; i++) {
+    replacer->RecordAccess((i * 3) % num_frames, 0);
+    replacer->SetEvictable((i * 3) % num_frames, true);
+    if (i % 2 == 0) {
+      replacer->RecordAccess((i * 3) % num_frames, 0);
+    }
+  }
+  auto victims = replacer->PeekVictims(num_frames);
+  ASSERT_EQ(num_frames, victims.size());
+  for (auto victim : victims) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(replacer->Evict(&frame_id));
+    EXPECT_EQ(victim, frame_id);
+  }
+}
+
+TEST(FrameReplacerTest, RestoreTest) {
+  const size_t num_frames = 8;
+  for (auto policy : ALL_POLICIES) {
+    // Two replacers see the same accesses, with pages that leave their frames and come back, but on one of them every
+    // eviction is first undone once, as when the buffer pool finds its victim pinned.
+    auto replacer = MakeFrameReplacer(policy, num_frames, 2);
+    auto twin = MakeFrameReplacer(policy, num_frames, 2);
+    std::vector<page_id_t> frames(num_frames, INVALID_PAGE_ID);
+    std::mt19937 generator(15445);
+    std::uniform_int_distribution<page_id_t> pages(0, 2 * num_frames);
+    frame_id_t next_free_frame = 0;
+    for (int i = 0; i < 500; i++) {
+      const auto page_id = pages(generator);
+      auto frame = std::find(frames.begin(), frames.end(), page_id);
+      frame_id_t frame_id;
+      if (frame != frames.end()) {
+        frame_id = static_cast<frame_id_t>(frame - frames.begin());
+      } else if (static_cast<size_t>(next_free_frame) < num_frames) {
+        frame_id = next_free_frame++;
+      } else {
+        const auto victims = replacer->PeekVictims(num_frames);
+        ASSERT_TRUE(replacer->Evict(&frame_id));
+        replacer->Restore(frame_id);
+        ASSERT_EQ(victims, replacer->PeekVictims(num_frames)) << ReplacerPolicyToString(policy);
+        ASSERT_EQ(num_frames, replacer->Size());
+
+        ASSERT_TRUE(replacer->Evict(&frame_id));
+        frame_id_t twin_frame_id;
+        ASSERT_TRUE(twin->Evict(&twin_frame_id));
+        ASSERT_EQ(twin_frame_id, frame_id) << ReplacerPolicyToString(policy);
+      }
+      frames[frame_id] = page_id;
+      for (auto *r : {replacer.get(), twin.get()}) {
+        r->RecordAccess(frame_id, page_id);
+        r->SetEvictable(frame_id, true);
+      }
+    }
+    EXPECT_EQ(twin->PeekVictims(num_frames), replacer->PeekVictims(num_frames)) << ReplacerPolicyToString(policy);
+
+    // A frame that has been tracked again since it was evicted is left alone.
+    frame_id_t frame_id;
+    ASSERT_TRUE(replacer->Evict(&frame_id));
+    replacer->RecordAccess(frame_id, 100);
+    replacer->Restore(frame_id);
+    EXPECT_EQ(num_frames - 1, replacer->Size());
+  }
+}
+
+TEST(FrameReplacerTest, ResizeTest) {
+  for (auto policy : ALL_POLICIES) {
+    auto replacer = MakeFrameReplacer(policy, 4, 2);
+    for (frame_id_t i = 0; i < 4; i++) {
+      replacer->RecordAccess(i, i);
+      replacer->SetEvictable(i, true);
+    }
+    const auto victims = replacer->PeekVictims(4);
+
+    // Growing keeps the frames and their order, and the new frames can be used right away.
+    replacer->Resize(6);
+    EXPECT_EQ(victims, replacer->PeekVictims(4)) << ReplacerPolicyToString(policy);
+    replacer->RecordAccess(5, 5);
+    replacer->SetEvictable(5, true);
+    EXPECT_EQ(5, replacer->Size());
+
+    // Shrinking below the frames that were removed keeps the others in order.
+    replacer->Remove(5);
+    replacer->Remove(3);
+    replacer->Resize(3);
+    std::vector<frame_id_t> remaining;
+    for (auto victim : victims) {
+      if (victim != 3) {
+        remaining.push_back(victim);
+      }
+    }
+    EXPECT_EQ(remaining, replacer->PeekVictims(3)) << ReplacerPolicyToString(policy);
+    for (auto victim : remaining) {
+      frame_id_t frame_id;
+      ASSERT_TRUE(replacer->Evict(&frame_id));
+      EXPECT_EQ(victim, frame_id);
+    }
+    EXPECT_EQ(0, replacer->Size());
+  }
+}
+
+TEST(FrameReplacerTest, BufferPoolManagerTest) {
+  // Every policy must work as the replacer of a buffer pool, including skipping pinned frames.
+  const size_t buffer_pool_size = 10;
+  for (auto policy : ALL_POLICIES) {
+    auto *disk_manager = new DiskManagerUnlimitedMemory();
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2, nullptr, policy);
+
+    // Fill the pool, then keep the even pages pinned and cycle through three times as many pages.
+    page_id_t page_id;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+      if (page_id % 2 == 1) {
+        ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    }
+    for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    for (page_id_t i = 0; i < static_cast<page_id_t>(3 * buffer_pool_size); i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page) << ReplacerPolicyToString(policy);
+      EXPECT_EQ(std::to_string(i), std::string(page->GetData()));
+      ASSERT_TRUE(bpm->UnpinPage(i, false));
+    }
+
+    // Only the pinned even pages are left pinned, so there is exactly room for the odd half of the pool.
+    for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    }
+    ASSERT_EQ(nullptr, bpm->NewPage(&page_id));
+
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+TEST(FrameReplacerTest, DISABLED_ScanResistanceBenchmark) {
+  std::cout << "This test replays traces of a hot working set interrupted by large scans." << std::endl;
+  std::cout << "<<< BEGIN" << std::endl;
+  const size_t num_frames = 1024;
+  for (int hot_pages : {512, 1024, 2048}) {
+    auto trace = MakeScanTrace(hot_pages, 4 * num_frames, 50, 20000);
+    for (auto policy : ALL_POLICIES) {
+      auto result = ReplayTrace(policy, num_frames, LRUK_REPLACER_K, trace);
+      std::cout << "Hot pages: " << hot_pages << " Policy: " << ReplacerPolicyToString(policy)
+                << " Hit ratio: " << result.HitRatio() << std::endl;
+    }
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
@@ -97,4 +97,38 @@ TEST(LRUKReplacerTest, SampleTest) {
   lru_replacer.Remove(1);
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, BackwardKDistanceTest) {
+  LRUKReplacer lru_replacer(4, 2);
+
+  // Frame 1 is accessed at t0 and t3, frame 2 at t1 and t2. Frame 1 was accessed most recently, but its second most
+  // recent access is the oldest, so it has the largest backward 2-distance.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(2, true);
+  lru_replacer.SetEvictable(1, true);
+
+  int value;
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+
+  // Accessing an evictable frame moves it within the list. Frame 3 has +inf backward k-distance and goes first.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.SetEvictable(1, true);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.RecordAccess(2);
+  ASSERT_EQ(3, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  // Frame 2 is now keyed by its access at t2, frame 1 by its access at t4.
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_EQ(false, lru_replacer.Evict(&value));
+}
 }  // namespace bustub
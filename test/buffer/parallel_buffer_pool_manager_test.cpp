@@ -0,0 +1,240 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 2;
+  const size_t k = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, k);
+  EXPECT_EQ(num_instances * buffer_pool_size, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: We should be able to create new pages until we fill up every instance. Allocation is round-robin, so
+  // the page ids are handed out by alternating instances.
+  for (size_t i = 1; i < num_instances * buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(static_cast<page_id_t>(i), page_id_temp);
+  }
+
+  // Scenario: Once every instance is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < num_instances * buffer_pool_size; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning the even pages {0, 2, 4, 6, 8}, only the first instance has free frames. NewPage must
+  // skip the full instance and still hand out pages that map back to the first instance.
+  for (int i = 0; i < 10; i += 2) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+  }
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(0, page_id_temp % static_cast<page_id_t>(num_instances));
+  }
+
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: If we unpin page 0 and then make a new page, all the buffer pages should
+  // now be pinned. Fetching page 0 should fail.
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->FetchPage(0));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ExtentTest) {
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(3, 4, disk_manager, 2);
+  PageExtent extent(5);
+
+  // The pages of an extent are consecutive, so each one lives in the instance that owns its id.
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(0, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  for (page_id_t expected = 1; expected <= 7; expected++) {
+    auto *page = bpm->NewPageInExtent(&page_id, &extent);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(expected, page_id);
+    EXPECT_EQ(page, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Pages without an extent are not taken from the reserved runs.
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_GE(page_id, 11);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, StatsTest) {
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(3, 4, disk_manager, 2);
+
+  // Scenario: the pinned high-water mark is that of the busiest instance, not the sum over the instances.
+  std::vector<page_id_t> page_ids;
+  std::vector<uint64_t> pinned(3, 0);
+  page_id_t page_id;
+  for (int i = 0; i < 7; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+    pinned[page_id % 3]++;
+  }
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(3, stats.num_instances_);
+  EXPECT_EQ(*std::max_element(pinned.begin(), pinned.end()), stats.pinned_high_water_);
+
+  for (auto id : page_ids) {
+    ASSERT_TRUE(bpm->UnpinPage(id, false));
+  }
+  EXPECT_EQ(stats.pinned_high_water_, bpm->GetStats().pinned_high_water_);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const size_t num_threads = 8;
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 16;
+  const int pages_per_thread = 64;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid]() {
+      std::vector<page_id_t> page_ids;
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        auto *page = bpm->NewPage(&page_id);
+        ASSERT_NE(nullptr, page);
+        snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%zu-%d", tid, page_id);
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+        page_ids.push_back(page_id);
+      }
+      for (auto page_id : page_ids) {
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(std::to_string(tid) + "-" + std::to_string(page_id), std::string(page->GetData()));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/** Run a FetchPage/UnpinPage workload on num_threads threads and return the elapsed time in milliseconds. */
+auto ParallelBufferPoolBenchmarkCall(size_t num_threads, size_t num_instances) -> size_t {
+  const size_t total_frames = 256;
+  const int ops_per_thread = 200000;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, total_frames / num_instances, disk_manager);
+
+  // Each thread works on its own small set of pages, so the workload is almost entirely buffer pool hits.
+  std::vector<std::vector<page_id_t>> pages(num_threads);
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    for (int i = 0; i < 8; i++) {
+      page_id_t page_id;
+      bpm->NewPage(&page_id);
+      bpm->UnpinPage(page_id, true);
+      pages[tid].push_back(page_id);
+    }
+  }
+
+  auto clock_start = std::chrono::system_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, &pages, tid]() {
+      const auto &my_pages = pages[tid];
+      for (int i = 0; i < ops_per_thread; i++) {
+        auto page_id = my_pages[i % my_pages.size()];
+        if (bpm->FetchPage(page_id) != nullptr) {
+          bpm->UnpinPage(page_id, false);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::system_clock::now();
+
+  delete bpm;
+  delete disk_manager;
+  return std::chrono::duration_cast<std::chrono::milliseconds>(clock_end - clock_start).count();
+}
+
+TEST(ParallelBufferPoolManagerTest, DISABLED_ScalingBenchmark) {  // NOLINT
+  const size_t num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 2);
+  std::cout << "This test shows how buffer pool throughput scales with the number of instances." << std::endl;
+  std::cout << "<<< BEGIN" << std::endl;
+  std::cout << "Threads: " << num_threads << std::endl;
+  for (size_t num_instances = 1; num_instances <= 16; num_instances *= 2) {
+    auto ms = ParallelBufferPoolBenchmarkCall(num_threads, num_instances);
+    std::cout << "Instances: " << num_instances << " Time (ms): " << ms << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
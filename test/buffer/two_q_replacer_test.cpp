@@ -0,0 +1,55 @@
+/**
+ * two_q_replacer_test.cpp
+ */
+
+#include "buffer/two_q_replacer.h"
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(TwoQReplacerTest, SampleTest) {
+  // With 8 frames, A1in may hold 2 frames before it gets reclaimed first, and A1out remembers 4 pages.
+  TwoQReplacer two_q_replacer(8);
+
+  // Scenario: frames 0-3 hold pages 10-13, all seen once, so all of them are in A1in.
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    two_q_replacer.RecordAccess(frame_id, 10 + frame_id);
+    two_q_replacer.SetEvictable(frame_id, true);
+  }
+  ASSERT_EQ(4, two_q_replacer.Size());
+
+  // Scenario: a repeated access while in A1in does not promote a page. A1in is over its share, so it is reclaimed in
+  // FIFO order and the evicted pages go to A1out.
+  two_q_replacer.RecordAccess(0, 10);
+  frame_id_t value;
+  ASSERT_EQ(true, two_q_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(true, two_q_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+
+  // Scenario: page 10 is accessed again while in A1out, so it is hot and goes to Am.
+  two_q_replacer.RecordAccess(0, 10);
+  two_q_replacer.SetEvictable(0, true);
+
+  // A1in = [13, 12] is within its share, so the victim comes from Am, and it is not remembered.
+  ASSERT_EQ(true, two_q_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_EQ(2, two_q_replacer.Size());
+
+  // Scenario: page 11 is promoted to Am as well, but stays pinned. With no evictable frame in Am, A1in is used even
+  // though it is within its share.
+  two_q_replacer.RecordAccess(0, 11);
+  ASSERT_EQ(true, two_q_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_EQ(true, two_q_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(false, two_q_replacer.Evict(&value));
+
+  ASSERT_ANY_THROW(two_q_replacer.Remove(0));
+  two_q_replacer.SetEvictable(0, true);
+  two_q_replacer.Remove(0);
+  ASSERT_EQ(0, two_q_replacer.Size());
+}
+
+}  // namespace bustub
@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/external_sorter.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+// helper function to check the sizes and parent links of every page below page_id; returns the number of leaves
+auto CheckSubtree(BufferPoolManager *bpm, page_id_t page_id, page_id_t parent_id) -> int {
+  auto *page = bpm->FetchPage(page_id);
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  EXPECT_EQ(node->GetParentPageId(), parent_id);
+  EXPECT_LE(node->GetSize(), node->GetMaxSize());
+  EXPECT_GE(node->GetSize(), node->GetMinSize());
+
+  int leaves = 1;
+  if (!node->IsLeafPage()) {
+    leaves = 0;
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      leaves += CheckSubtree(bpm, internal->ValueAt(i), page_id);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+  return leaves;
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // Scenario: sizes around the boundaries of the leaves and the levels, at the least, default and full fill factors.
+  for (double fill_factor : {0.5, 0.9, 1.0}) {
+    for (int64_t num_keys : {0, 1, 4, 5, 9, 23, 24, 25, 157, 2000}) {
+      auto *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 5);
+      GenericKey<8> index_key;
+      RID rid;
+
+      // create and fetch header_page
+      page_id_t page_id;
+      auto header_page = bpm->NewPage(&page_id);
+      (void)header_page;
+
+      // Scenario: every key comes twice; the second one is skipped, as an insert would reject it.
+      int64_t next_key = 0;
+      bool repeat = false;
+      ASSERT_TRUE(tree.BulkLoad(
+          [&](std::pair<GenericKey<8>, RID> *pair) {
+            if (!repeat) {
+              next_key++;
+            }
+            if (next_key > num_keys) {
+              return false;
+            }
+            pair->first.SetFromInteger(next_key);
+            pair->second.Set(0, static_cast<uint32_t>(next_key) + (repeat ? 1000000 : 0));
+            repeat = !repeat;
+            return true;
+          },
+          fill_factor));
+      ASSERT_EQ(tree.IsEmpty(), num_keys == 0);
+
+      if (num_keys > 0) {
+        const int leaves = CheckSubtree(bpm, tree.GetRootPageId(), INVALID_PAGE_ID);
+        // The leaves are packed to the fill factor, apart from the last two.
+        const int leaf_fill = std::max(static_cast<int>(4 * fill_factor), 2);
+        EXPECT_LE(leaves, (num_keys + leaf_fill - 1) / leaf_fill + 1);
+      }
+
+      std::vector<RID> rids;
+      for (int64_t key = 1; key <= num_keys; key++) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        ASSERT_TRUE(tree.GetValue(index_key, &rids));
+        EXPECT_EQ(rids[0].GetSlotNum(), key);
+      }
+      int64_t current_key = 1;
+      for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+        EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+        current_key = current_key + 1;
+      }
+      EXPECT_EQ(current_key, num_keys + 1);
+
+      // Scenario: the loaded tree takes inserts and deletes like any other.
+      auto *transaction = new Transaction(0);
+      index_key.SetFromInteger(num_keys + 1);
+      rid.Set(0, static_cast<uint32_t>(num_keys + 1));
+      EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+      EXPECT_FALSE(tree.BulkLoad([](std::pair<GenericKey<8>, RID> *pair) { return false; }, fill_factor));
+      for (int64_t key = 1; key <= num_keys + 1; key++) {
+        index_key.SetFromInteger(key);
+        tree.Remove(index_key, transaction);
+        if (key % 7 == 0 && key <= num_keys) {
+          CheckSubtree(bpm, tree.GetRootPageId(), INVALID_PAGE_ID);
+        }
+      }
+      EXPECT_TRUE(tree.IsEmpty());
+      delete transaction;
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete bpm;
+      delete disk_manager;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+}
+
+TEST(BPlusTreeTests, ExternalSorterTest) {
+  std::vector<int64_t> values(10000);
+  for (size_t i = 0; i < values.size(); i++) {
+    values[i] = static_cast<int64_t>(i / 2);
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937(0));
+
+  // Scenario: a budget of 100 values spills a run for every 100 values added.
+  ExternalSorter<int64_t, std::less<>> sorter(std::less<>(), 100 * sizeof(int64_t));
+  for (auto value : values) {
+    sorter.Add(value);
+  }
+  sorter.Sort();
+  EXPECT_EQ(sorter.Size(), values.size());
+  EXPECT_EQ(sorter.NumRuns(), values.size() / 100);
+
+  std::sort(values.begin(), values.end());
+  int64_t value;
+  for (auto expected : values) {
+    ASSERT_TRUE(sorter.Next(&value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_FALSE(sorter.Next(&value));
+
+  // Scenario: within the budget, the values are sorted in memory.
+  ExternalSorter<int64_t, std::less<>> small_sorter(std::less<>(), 1 << 20);
+  for (auto it = values.rbegin(); it != values.rend(); ++it) {
+    small_sorter.Add(*it);
+  }
+  small_sorter.Sort();
+  EXPECT_EQ(small_sorter.NumRuns(), 0);
+  for (auto expected : values) {
+    ASSERT_TRUE(small_sorter.Next(&value));
+    EXPECT_EQ(value, expected);
+  }
+  EXPECT_FALSE(small_sorter.Next(&value));
+}
+
+}  // namespace bustub
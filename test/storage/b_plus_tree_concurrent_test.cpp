@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -333,4 +334,140 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, SmallNodeMixTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  // Scenario: small nodes, so that the concurrent inserts and deletes keep splitting and merging pages.
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int64_t num_keys = 2000;
+  std::vector<int64_t> even_keys;
+  std::vector<int64_t> odd_keys;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    (key % 2 == 0 ? even_keys : odd_keys).push_back(key);
+  }
+  InsertHelper(&tree, even_keys);
+
+  // Scenario: two threads insert the odd keys, two delete the even ones and two scan, all at once.
+  const int total_threads = 2;
+  std::thread inserter([&] { LaunchParallelTest(total_threads, InsertHelperSplit, &tree, odd_keys, total_threads); });
+  std::thread deleter([&] { LaunchParallelTest(total_threads, DeleteHelperSplit, &tree, even_keys, total_threads); });
+  std::vector<std::thread> scanners;
+  for (int i = 0; i < 2; i++) {
+    scanners.emplace_back([&] {
+      for (int pass = 0; pass < 5; pass++) {
+        int64_t last_key = 0;
+        for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+          auto key = static_cast<int64_t>((*iterator).second.GetSlotNum());
+          EXPECT_GT(key, last_key);
+          last_key = key;
+        }
+      }
+    });
+  }
+  inserter.join();
+  deleter.join();
+  for (auto &scanner : scanners) {
+    scanner.join();
+  }
+
+  std::vector<RID> rids;
+  for (auto key : odd_keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, &rids);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  size_t size = 0;
+  for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), odd_keys[size]);
+    size = size + 1;
+  }
+  EXPECT_EQ(size, odd_keys.size());
+
+  DeleteHelper(&tree, odd_keys);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, OptimisticLookupTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // Scenario: every third key stays in the tree, while writers keep inserting and removing the keys in between.
+  const int64_t num_keys = 1500;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> churn_keys;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    (key % 3 == 0 ? stable_keys : churn_keys).push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int round = 0; round < 3; round++) {
+      InsertHelper(&tree, churn_keys);
+      DeleteHelper(&tree, churn_keys);
+    }
+    done = true;
+  });
+
+  // Scenario: lookups of the stable keys run without latches as the pages around them split and merge.
+  auto reader = [&](__attribute__((unused)) uint64_t thread_itr) {
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    while (!done) {
+      for (auto key : stable_keys) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        ASSERT_TRUE(tree.GetValue(index_key, &rids));
+        ASSERT_EQ(rids.size(), 1);
+        ASSERT_EQ(rids[0].GetSlotNum(), key);
+      }
+    }
+  };
+  LaunchParallelTest(2, reader);
+  writer.join();
+
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), stable_keys[size]);
+    size = size + 1;
+  }
+  EXPECT_EQ(size, stable_keys.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <set>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -20,6 +21,27 @@
 
 namespace bustub {
 
+// buffer pool that counts the pages it deleted, and records the ones it refused to delete since they were pinned
+class DeleteCountingBufferPool : public BufferPoolManagerInstance {
+ public:
+  using BufferPoolManagerInstance::BufferPoolManagerInstance;
+  size_t deleted_{0};
+  size_t refused_{0};
+  std::set<page_id_t> refused_pages_;
+
+ protected:
+  auto DeletePgImp(page_id_t page_id) -> bool override {
+    const bool deleted = BufferPoolManagerInstance::DeletePgImp(page_id);
+    if (deleted) {
+      deleted_++;
+    } else {
+      refused_++;
+      refused_pages_.insert(page_id);
+    }
+    return deleted;
+  }
+};
+
 TEST(BPlusTreeTests, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
@@ -163,4 +185,65 @@ TEST(BPlusTreeTests, DeleteTest2) {
   remove("test.db");
   remove("test.log");
 }
+TEST(BPlusTreeTests, DeferredDeleteTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new DeleteCountingBufferPool(200, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  for (int64_t key = 1; key <= 50; key++) {
+    rid.Set(0, static_cast<uint32_t>(key));
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  // Scenario: every page is pinned, as by scans on their way past, while the tree merges pages away.
+  const page_id_t num_pages = disk_manager->GetNumPages();
+  for (page_id_t pinned = 1; pinned < num_pages; pinned++) {
+    ASSERT_NE(bpm->FetchPage(pinned), nullptr);
+  }
+  for (int64_t key = 1; key <= 40; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_EQ(bpm->deleted_, 0);
+  EXPECT_GT(bpm->refused_, 0);
+
+  // Scenario: once the pages are unpinned, the next change that latches its way down deletes them.
+  for (page_id_t pinned = 1; pinned < num_pages; pinned++) {
+    bpm->UnpinPage(pinned, false);
+  }
+  const size_t refused = bpm->refused_;
+  for (int64_t key = 51; key <= 60; key++) {
+    rid.Set(0, static_cast<uint32_t>(key));
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  EXPECT_EQ(bpm->deleted_, bpm->refused_pages_.size());
+  EXPECT_EQ(bpm->refused_, refused);
+
+  int64_t current_key = 41;
+  for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key++;
+  }
+  EXPECT_EQ(current_key, 61);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_page_search_test.cpp
+//
+// Identification: test/storage/b_plus_tree_page_search_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// helper function to build the key of a row of the key schema, with every column set to value
+template <size_t KeySize>
+auto MakeKey(const Schema &schema, int64_t value) -> GenericKey<KeySize> {
+  std::vector<Value> values;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    if (schema.GetColumn(i).GetType() == TypeId::INTEGER) {
+      values.emplace_back(TypeId::INTEGER, static_cast<int32_t>(value));
+    } else {
+      values.emplace_back(TypeId::BIGINT, value);
+    }
+  }
+  GenericKey<KeySize> key;
+  key.SetFromKey(Tuple(values, &schema));
+  return key;
+}
+
+// helper function to check the searches of full leaf and internal pages against std::lower_bound and std::upper_bound
+template <size_t KeySize>
+void CheckPageSearch(const std::string &create_stmt, int64_t min, int64_t max) {
+  using LeafPage = BPlusTreeLeafPage<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+  using InternalPage = BPlusTreeInternalPage<GenericKey<KeySize>, page_id_t, GenericComparator<KeySize>>;
+  auto key_schema = ParseCreateStatement(create_stmt);
+  GenericComparator<KeySize> comparator(key_schema.get());
+
+  std::mt19937_64 random(KeySize);
+  std::uniform_int_distribution<int64_t> distribution(min + 1, max - 1);
+  std::vector<int64_t> values{min, max};
+  while (static_cast<int>(values.size()) < LeafPage::MaxSizeFor(BUSTUB_PAGE_SIZE)) {
+    values.push_back(distribution(random));
+  }
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  std::vector<int64_t> probes{min, max};
+  for (auto value : values) {
+    probes.push_back(value);
+    probes.push_back(value > min ? value - 1 : value);
+    probes.push_back(value < max ? value + 1 : value);
+  }
+
+  // Scenario: a leaf filled in random order finds the first key not less than each probe.
+  std::vector<char> leaf_data(BUSTUB_PAGE_SIZE);
+  auto *leaf = reinterpret_cast<LeafPage *>(leaf_data.data());
+  leaf->Init(1, INVALID_PAGE_ID, LeafPage::MaxSizeFor(BUSTUB_PAGE_SIZE));
+  std::vector<int64_t> shuffled(values);
+  std::shuffle(shuffled.begin(), shuffled.end(), random);
+  for (auto value : shuffled) {
+    leaf->Insert(MakeKey<KeySize>(*key_schema, value), RID(0, static_cast<uint32_t>(value)), comparator);
+  }
+  ASSERT_EQ(leaf->GetSize(), static_cast<int>(values.size()));
+  for (auto probe : probes) {
+    const auto expected = std::lower_bound(values.begin(), values.end(), probe) - values.begin();
+    ASSERT_EQ(leaf->KeyIndex(MakeKey<KeySize>(*key_schema, probe), comparator), expected) << probe;
+  }
+  for (int i = 0; i < leaf->GetSize(); i++) {
+    ASSERT_EQ(leaf->ValueAt(i).GetSlotNum(), static_cast<uint32_t>(values[i]));
+  }
+
+  // Scenario: an internal page follows the child left of the first key greater than each probe; key 0 is ignored.
+  std::vector<char> internal_data(BUSTUB_PAGE_SIZE);
+  auto *internal = reinterpret_cast<InternalPage *>(internal_data.data());
+  const int internal_size = std::min<int>(InternalPage::MaxSizeFor(BUSTUB_PAGE_SIZE), values.size());
+  internal->Init(2, INVALID_PAGE_ID, InternalPage::MaxSizeFor(BUSTUB_PAGE_SIZE));
+  internal->SetItem(MakeKey<KeySize>(*key_schema, max), 0, 0);
+  internal->IncreaseSize(1);
+  for (int i = 1; i < internal_size; i++) {
+    internal->SetItem(MakeKey<KeySize>(*key_schema, values[i]), i, i);
+    internal->IncreaseSize(1);
+  }
+  for (auto probe : probes) {
+    const auto expected = std::upper_bound(values.begin() + 1, values.begin() + internal_size, probe) - values.begin();
+    ASSERT_EQ(internal->Lookup(MakeKey<KeySize>(*key_schema, probe), comparator), expected - 1) << probe;
+  }
+}
+
+TEST(BPlusTreeTests, PageSearchTest) {
+  // Scenario: integer keys, compared a block at a time.
+  CheckPageSearch<4>("a integer", std::numeric_limits<int32_t>::min() + 1, std::numeric_limits<int32_t>::max());
+  CheckPageSearch<8>("a integer", std::numeric_limits<int32_t>::min() + 1, std::numeric_limits<int32_t>::max());
+  CheckPageSearch<8>("a bigint", std::numeric_limits<int64_t>::min() + 1, std::numeric_limits<int64_t>::max());
+  // Scenario: small integer keys, where most probes fall between neighbouring keys.
+  CheckPageSearch<8>("a bigint", -300, 300);
+  // Scenario: keys of two columns, compared as values.
+  CheckPageSearch<16>("a bigint,b bigint", -100000, 100000);
+  CheckPageSearch<64>("a bigint,b bigint", -100000, 100000);
+}
+
+TEST(BPlusTreeTests, TornKeyTest) {
+  auto key_schema = ParseCreateStatement("a varchar(8)");
+  GenericComparator<32> comparator(key_schema.get());
+  auto make_key = [&](const std::string &value) {
+    GenericKey<32> key;
+    key.SetFromKey(Tuple({ValueFactory::GetVarcharValue(value)}, key_schema.get()));
+    return key;
+  };
+
+  // Scenario: VARCHAR keys that fit in the key compare by their strings.
+  const auto abc = make_key("abc");
+  const auto abd = make_key("abd");
+  EXPECT_EQ(-1, comparator(abc, abd));
+  EXPECT_EQ(1, comparator(abd, abc));
+  EXPECT_EQ(0, comparator(abc, make_key("abc")));
+  EXPECT_EQ("abc", abc.ToValue(key_schema.get(), 0).ToString());
+
+  // Scenario: a key read while it was half written, with an offset or a length past its end, reads as NULL.
+  auto torn = abc;
+  const int32_t offset = 1 << 20;
+  memcpy(torn.data_, &offset, sizeof(offset));
+  EXPECT_TRUE(torn.ToValue(key_schema.get(), 0).IsNull());
+  comparator(torn, abc);
+
+  torn = abc;
+  int32_t value_offset;
+  memcpy(&value_offset, torn.data_, sizeof(value_offset));
+  const uint32_t length = 1 << 20;
+  memcpy(torn.data_ + value_offset, &length, sizeof(length));
+  EXPECT_TRUE(torn.ToValue(key_schema.get(), 0).IsNull());
+  comparator(abc, torn);
+}
+
+}  // namespace bustub
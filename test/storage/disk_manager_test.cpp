@@ -10,11 +10,24 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_compressed.h"
+#include "storage/disk/disk_manager_mmap.h"
+#ifdef __linux__
+#include "storage/disk/disk_manager_uring.h"
+#endif
+#include "storage/disk/page_compressor.h"
+#include "storage/page/header_page.h"
 
 namespace bustub {
 
@@ -24,12 +37,16 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.ptm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.fsm");
+    remove("test.ptm");
   };
 };
 
@@ -55,6 +72,442 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeOffsetTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A page past 2GB.", sizeof(data));
+
+  // The page starts beyond what a 32-bit offset can address. The file is sparse, so this does not use 2GB of disk.
+  const page_id_t page_id = (1 << 19) + 7;
+  dm.WritePage(page_id, data);
+  dm.ReadPage(page_id, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // A page in the hole before it reads back as zeros.
+  std::memset(buf, 1, sizeof(buf));
+  dm.ReadPage(page_id - 1, buf);
+  EXPECT_EQ(std::memcmp(buf, std::string(BUSTUB_PAGE_SIZE, '\0').data(), sizeof(buf)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWriteTest) {
+  const int num_threads = 4;
+  const int pages_per_thread = 32;
+  const int rounds = 4;
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // Threads write and read back interleaved pages at the same time.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char buf[BUSTUB_PAGE_SIZE];
+      char data[BUSTUB_PAGE_SIZE];
+      for (int round = 0; round < rounds; round++) {
+        for (int i = 0; i < pages_per_thread; i++) {
+          const page_id_t page_id = i * num_threads + tid;
+          std::memset(data, 'a' + (page_id + round) % 26, sizeof(data));
+          dm.WritePage(page_id, data);
+          dm.ReadPage(page_id, buf);
+          ASSERT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * pages_per_thread * rounds, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
+#ifdef __linux__
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWriteTest) {
+  // More pages than the queue and the completion queue hold, so batches are submitted and waited for along the way.
+  const int num_pages = 40;
+  // A queue depth of 0 does not set up a ring and falls back to synchronous I/O.
+  for (unsigned queue_depth : {8U, 0U}) {
+    remove("test.db");
+    DiskManagerUring dm("test.db", queue_depth);
+    if (queue_depth == 0) {
+      EXPECT_FALSE(dm.IsAsync());
+    }
+
+    std::vector<char> data(num_pages * BUSTUB_PAGE_SIZE);
+    std::vector<std::future<void>> writes;
+    for (int i = 0; i < num_pages; i++) {
+      std::memset(&data[i * BUSTUB_PAGE_SIZE], 'a' + i % 26, BUSTUB_PAGE_SIZE);
+      writes.push_back(dm.WritePageAsync(i, &data[i * BUSTUB_PAGE_SIZE]));
+    }
+    dm.SubmitIO();
+    for (auto &write : writes) {
+      write.wait();
+    }
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+    // Read everything back, plus one page past the end of the file, which comes back as zeros.
+    std::vector<char> buf((num_pages + 1) * BUSTUB_PAGE_SIZE, 1);
+    std::vector<std::future<void>> reads;
+    for (int i = 0; i <= num_pages; i++) {
+      reads.push_back(dm.ReadPageAsync(i, &buf[i * BUSTUB_PAGE_SIZE]));
+    }
+    dm.SubmitIO();
+    for (auto &read : reads) {
+      read.wait();
+    }
+    EXPECT_EQ(std::memcmp(buf.data(), data.data(), data.size()), 0);
+    EXPECT_EQ(std::string(&buf[num_pages * BUSTUB_PAGE_SIZE], BUSTUB_PAGE_SIZE), std::string(BUSTUB_PAGE_SIZE, '\0'));
+
+    // Synchronous I/O still works alongside.
+    char page[BUSTUB_PAGE_SIZE];
+    dm.ReadPage(3, page);
+    EXPECT_EQ(std::memcmp(page, &data[3 * BUSTUB_PAGE_SIZE], BUSTUB_PAGE_SIZE), 0);
+  }
+}
+#endif
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, VectoredWriteTest) {
+  std::string db_file("test.db");
+  const size_t num_pages = 8;
+  std::vector<char> data(num_pages * BUSTUB_PAGE_SIZE);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(i * 7 % 251);
+  }
+  std::vector<const char *> pages;
+  for (size_t i = 0; i < num_pages; i++) {
+    pages.push_back(&data[i * BUSTUB_PAGE_SIZE]);
+  }
+
+  // A run counts one write per page, and lands at the offset of its first page.
+  DiskManager dm(db_file);
+  dm.WritePages(2, pages);
+  EXPECT_EQ(static_cast<int>(num_pages), dm.GetNumWrites());
+  char buf[BUSTUB_PAGE_SIZE];
+  for (size_t i = 0; i < num_pages; i++) {
+    dm.ReadPage(static_cast<page_id_t>(2 + i), buf);
+    EXPECT_EQ(std::memcmp(buf, pages[i], BUSTUB_PAGE_SIZE), 0);
+  }
+  dm.ShutDown();
+
+#ifdef __linux__
+  // Through io_uring, the run is a single vectored write. Overwrite it in reverse order to see the new data arrive.
+  std::reverse(pages.begin(), pages.end());
+  DiskManagerUring uring_dm(db_file);
+  auto done = uring_dm.WritePagesAsync(2, pages);
+  uring_dm.SubmitIO();
+  done.wait();
+  EXPECT_EQ(static_cast<int>(num_pages), uring_dm.GetNumWrites());
+  for (size_t i = 0; i < num_pages; i++) {
+    uring_dm.ReadPage(static_cast<page_id_t>(2 + i), buf);
+    EXPECT_EQ(std::memcmp(buf, pages[i], BUSTUB_PAGE_SIZE), 0);
+  }
+#endif
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIOTest) {
+  std::string db_file("test.db");
+  DiskManager dm(db_file);
+  if (!dm.EnableDirectIO()) {
+    GTEST_SKIP() << "the file system does not support O_DIRECT";
+  }
+  EXPECT_TRUE(dm.IsDirectIO());
+
+  // Aligned buffers bypass the page cache, unaligned ones go through it; either kind reads what the other wrote.
+  const size_t alignment = DiskManager::DIRECT_IO_ALIGNMENT;
+  std::unique_ptr<char[]> storage(new char[3 * BUSTUB_PAGE_SIZE + alignment]);
+  char *aligned = storage.get() + (alignment - reinterpret_cast<uintptr_t>(storage.get()) % alignment);
+  char *unaligned = aligned + 2 * BUSTUB_PAGE_SIZE + 1;
+  for (int i = 0; i < BUSTUB_PAGE_SIZE; i++) {
+    aligned[i] = static_cast<char>(i % 251);
+    aligned[BUSTUB_PAGE_SIZE + i] = static_cast<char>(i % 13);
+  }
+  dm.WritePage(1, aligned);
+  dm.ReadPage(1, unaligned);
+  EXPECT_EQ(0, std::memcmp(aligned, unaligned, BUSTUB_PAGE_SIZE));
+  dm.WritePage(2, unaligned);
+  dm.ReadPage(2, aligned + BUSTUB_PAGE_SIZE);
+  EXPECT_EQ(0, std::memcmp(aligned + BUSTUB_PAGE_SIZE, unaligned, BUSTUB_PAGE_SIZE));
+
+  // Scenario: a run with an unaligned buffer falls back to the page cache as a whole.
+  dm.WritePages(3, {aligned, unaligned});
+  dm.WritePages(5, {aligned, aligned + BUSTUB_PAGE_SIZE});
+  for (page_id_t page_id : {3, 4, 5}) {
+    dm.ReadPage(page_id, aligned + BUSTUB_PAGE_SIZE);
+    EXPECT_EQ(0, std::memcmp(aligned + BUSTUB_PAGE_SIZE, aligned, BUSTUB_PAGE_SIZE));
+  }
+
+  // Scenario: a page past the end of the file reads as zeros.
+  dm.ReadPage(100, aligned);
+  EXPECT_EQ(std::vector<char>(BUSTUB_PAGE_SIZE, 0), std::vector<char>(aligned, aligned + BUSTUB_PAGE_SIZE));
+  dm.ShutDown();
+  EXPECT_FALSE(dm.IsDirectIO());
+
+#ifdef __linux__
+  // Scenario: io_uring submits aligned pages directly.
+  DiskManagerUring uring_dm(db_file);
+  ASSERT_TRUE(uring_dm.EnableDirectIO());
+  for (int i = 0; i < BUSTUB_PAGE_SIZE; i++) {
+    aligned[BUSTUB_PAGE_SIZE + i] = static_cast<char>(i % 251);
+  }
+  auto done = uring_dm.ReadPageAsync(1, aligned);
+  uring_dm.SubmitIO();
+  done.wait();
+  EXPECT_EQ(0, std::memcmp(aligned, aligned + BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE));
+  uring_dm.ShutDown();
+#endif
+
+  // Scenario: the mmap disk manager has no direct mode.
+  DiskManagerMmap mmap_dm(db_file);
+  EXPECT_FALSE(mmap_dm.EnableDirectIO());
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapReadWriteTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  // A page in the second chunk makes the mapping grow, and likely move, while the first pages are in it.
+  const page_id_t far_page_id = DiskManagerMmap::MMAP_GROW_SIZE / BUSTUB_PAGE_SIZE + 3;
+  {
+    DiskManagerMmap dm(db_file);
+    EXPECT_EQ(0, dm.GetMappedSize());
+    dm.ReadPage(0, buf);  // tolerate empty read
+
+    std::strncpy(data, "A test string.", sizeof(data));
+    dm.WritePage(0, data);
+    EXPECT_EQ(DiskManagerMmap::MMAP_GROW_SIZE, dm.GetMappedSize());
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+    // An unwritten page of the chunk reads as zeros.
+    std::memset(buf, 1, sizeof(buf));
+    dm.ReadPage(1, buf);
+    EXPECT_EQ(std::memcmp(buf, std::string(BUSTUB_PAGE_SIZE, '\0').data(), sizeof(buf)), 0);
+
+    std::strncpy(data, "Another page.", sizeof(data));
+    dm.WritePage(far_page_id, data);
+    EXPECT_EQ(2 * DiskManagerMmap::MMAP_GROW_SIZE, dm.GetMappedSize());
+    dm.SyncPage(far_page_id);
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(std::string("A test string."), buf);
+    dm.Sync();
+    EXPECT_EQ(2, dm.GetNumWrites());
+    dm.ShutDown();
+  }
+
+  // The pages are in the file, where a regular disk manager finds them, and the mapping covers the whole file again.
+  DiskManager dm(db_file);
+  dm.ReadPage(far_page_id, buf);
+  EXPECT_EQ(std::string("Another page."), buf);
+  dm.ShutDown();
+  DiskManagerMmap mmap_dm(db_file);
+  EXPECT_EQ(2 * DiskManagerMmap::MMAP_GROW_SIZE, mmap_dm.GetMappedSize());
+  mmap_dm.ReadPage(0, buf);
+  EXPECT_EQ(std::string("A test string."), buf);
+  mmap_dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageTest) {
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    DiskManager dm(db_file);
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+      dm.WritePage(page_id, data);
+    }
+    dm.DeallocatePage(5);
+    dm.DeallocatePage(2);
+    dm.DeallocatePage(2);
+    EXPECT_FALSE(dm.IsAllocated(2));
+    // The lowest free page is reused first.
+    EXPECT_EQ(2, dm.AllocatePage());
+    EXPECT_TRUE(dm.IsAllocated(2));
+    dm.DeallocatePage(6);
+    dm.DeallocatePage(7);
+    dm.ShutDown();
+  }
+
+  // The page count and the free pages survive a restart.
+  {
+    DiskManager dm(db_file);
+    EXPECT_EQ(8, dm.GetNumPages());
+    EXPECT_TRUE(dm.IsAllocated(2));
+    EXPECT_FALSE(dm.IsAllocated(5));
+
+    // A partition only gets its own page ids. Page 8 is skipped over by the odd one and left to the even one.
+    EXPECT_EQ(5, dm.AllocatePage(2, 1));
+    EXPECT_EQ(7, dm.AllocatePage(2, 1));
+    EXPECT_EQ(9, dm.AllocatePage(2, 1));
+    EXPECT_EQ(6, dm.AllocatePage(2, 0));
+    EXPECT_EQ(8, dm.AllocatePage(2, 0));
+    EXPECT_EQ(10, dm.AllocatePage(2, 0));
+
+    // Only the free pages at the end can be truncated.
+    dm.DeallocatePage(10);
+    dm.DeallocatePage(9);
+    dm.DeallocatePage(3);
+    EXPECT_EQ(2, dm.TruncateFreeTail());
+    EXPECT_EQ(9, dm.GetNumPages());
+    EXPECT_EQ(0, dm.TruncateFreeTail());
+    dm.ShutDown();
+  }
+
+  // Without its free-space map, every page in the database file is taken as allocated.
+  remove("test.fsm");
+  {
+    DiskManager dm(db_file);
+    EXPECT_EQ(9, dm.GetNumPages());
+    EXPECT_TRUE(dm.IsAllocated(3));
+    EXPECT_EQ(9, dm.AllocatePage());
+    dm.ShutDown();
+  }
+
+  // The free-space map of a database file that was deleted does not apply to a new one.
+  remove("test.db");
+  {
+    DiskManager dm(db_file);
+    EXPECT_EQ(0, dm.GetNumPages());
+    EXPECT_EQ(0, dm.AllocatePage());
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ExtentTest) {
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    DiskManager dm(db_file);
+    EXPECT_EQ(0, dm.ReserveExtent(4));
+    dm.AllocateReservedPage(0);
+    dm.AllocateReservedPage(1);
+    dm.WritePage(0, data);
+    EXPECT_TRUE(dm.IsAllocated(1));
+    EXPECT_FALSE(dm.IsAllocated(2));
+    // Reserved pages are not handed out to others.
+    EXPECT_EQ(4, dm.AllocatePage());
+
+    // A run of free pages at the end of the database is extended.
+    dm.DeallocatePage(4);
+    EXPECT_EQ(4, dm.ReserveExtent(2));
+    EXPECT_EQ(6, dm.GetNumPages());
+    dm.ShutDown();
+  }
+
+  // The reserved pages that were never allocated are free again after a restart.
+  DiskManager dm(db_file);
+  EXPECT_EQ(6, dm.GetNumPages());
+  EXPECT_EQ(2, dm.ReserveExtent(4));
+  EXPECT_EQ(6, dm.ReserveExtent(1));
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageCompressorTest) {
+  const size_t page_size = 16384;
+  std::vector<char> page(page_size);
+  std::vector<char> compressed(page_size);
+  std::vector<char> buf(page_size);
+
+  // A page of small, slowly growing integers followed by free space shrinks a lot.
+  for (size_t i = 0; i < page_size / 2 / sizeof(int32_t); i++) {
+    const auto value = static_cast<int32_t>(i / 16);
+    std::memcpy(&page[i * sizeof(int32_t)], &value, sizeof(value));
+  }
+  auto compressed_size = PageCompressor::Compress(page.data(), page_size, compressed.data(), compressed.size());
+  ASSERT_NE(0, compressed_size);
+  EXPECT_LT(compressed_size, page_size / 4);
+  ASSERT_TRUE(PageCompressor::Decompress(compressed.data(), compressed_size, buf.data(), page_size));
+  EXPECT_EQ(page, buf);
+
+  // A cut-off page does not decompress.
+  EXPECT_FALSE(PageCompressor::Decompress(compressed.data(), compressed_size / 2, buf.data(), page_size));
+
+  // Random bytes do not fit in less than the page.
+  uint32_t state = 42;
+  for (auto &byte : page) {
+    state = state * 1103515245 + 12345;
+    byte = static_cast<char>(state >> 16);
+  }
+  EXPECT_EQ(0, PageCompressor::Compress(page.data(), page_size, compressed.data(), page_size - 1));
+  // They still round-trip with room for the tokens.
+  compressed.resize(2 * page_size);
+  compressed_size = PageCompressor::Compress(page.data(), page_size, compressed.data(), compressed.size());
+  ASSERT_NE(0, compressed_size);
+  ASSERT_TRUE(PageCompressor::Decompress(compressed.data(), compressed_size, buf.data(), page_size));
+  EXPECT_EQ(page, buf);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressedReadWriteTest) {
+  std::string db_file("test.db");
+  const int page_size = 16384;
+  std::vector<char> header(page_size);
+  std::vector<char> repetitive(page_size);
+  std::vector<char> random(page_size);
+  std::vector<char> buf(page_size);
+  std::memcpy(&header[HeaderPage::OFFSET_MAGIC], &HeaderPage::MAGIC, sizeof(HeaderPage::MAGIC));
+  std::memcpy(&header[HeaderPage::OFFSET_PAGE_SIZE], &page_size, sizeof(page_size));
+  for (size_t i = 0; i < repetitive.size(); i++) {
+    repetitive[i] = static_cast<char>(i % 8 == 0 ? i / 512 : 0);
+  }
+  uint32_t state = 7;
+  for (auto &byte : random) {
+    state = state * 1103515245 + 12345;
+    byte = static_cast<char>(state >> 16);
+  }
+
+  {
+    DiskManagerCompressed dm(db_file, page_size);
+    dm.ReadPage(1, buf.data());  // tolerate empty read
+
+    // The header page and the incompressible page are stored as is, the repetitive one compressed.
+    dm.WritePage(0, header.data());
+    dm.WritePage(1, repetitive.data());
+    dm.WritePage(2, random.data());
+    EXPECT_EQ(page_size, dm.GetStoredSize(0));
+    EXPECT_LT(dm.GetStoredSize(1), page_size / 2);
+    EXPECT_EQ(page_size, dm.GetStoredSize(2));
+    EXPECT_EQ(3, dm.GetNumWrites());
+
+    dm.ReadPage(1, buf.data());
+    EXPECT_EQ(repetitive, buf);
+    dm.ReadPage(2, buf.data());
+    EXPECT_EQ(random, buf);
+
+    // Overwriting a compressed page with one that does not compress fills its slot again, and the other way round.
+    dm.WritePages(1, {random.data(), repetitive.data()});
+    EXPECT_EQ(page_size, dm.GetStoredSize(1));
+    EXPECT_LT(dm.GetStoredSize(2), page_size / 2);
+    dm.ReadPage(1, buf.data());
+    EXPECT_EQ(random, buf);
+    dm.ShutDown();
+  }
+
+  // The page translation map survives a restart, and the page size is still read from the uncompressed header page.
+  DiskManagerCompressed dm(db_file);
+  EXPECT_EQ(page_size, dm.GetPageSize());
+  EXPECT_LT(dm.GetStoredSize(2), page_size / 2);
+  dm.ReadPage(0, buf.data());
+  EXPECT_EQ(header, buf);
+  dm.ReadPage(1, buf.data());
+  EXPECT_EQ(random, buf);
+  dm.ReadPage(2, buf.data());
+  EXPECT_EQ(repetitive, buf);
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
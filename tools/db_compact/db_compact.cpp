@@ -0,0 +1,54 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "argparse/argparse.hpp"
+#include "common/config.h"
+#include "common/exception.h"
+#include "fmt/core.h"
+#include "storage/disk/disk_manager.h"
+
+/**
+ * Shrinks a database file by the free pages at its end, as recorded in its free-space map. Pages are not moved, so
+ * free pages in the middle of the file stay allocated on disk. Only run this while no BusTub instance has the database
+ * open.
+ */
+auto main(int argc, char **argv) -> int {  // NOLINT
+  argparse::ArgumentParser program("bustub-db-compact");
+  program.add_argument("file").help("the database file to compact");
+  program.add_argument("--dry-run").help("only report the free pages").default_value(false).implicit_value(true);
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  auto filename = program.get<std::string>("file");
+  if (!std::ifstream(filename)) {
+    std::cerr << "Failed to open " << filename << std::endl;
+    return 1;
+  }
+  try {
+    bustub::DiskManager disk_manager(filename);
+    const auto num_pages = disk_manager.GetNumPages();
+    bustub::page_id_t num_free = 0;
+    for (bustub::page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      num_free += disk_manager.IsAllocated(page_id) ? 0 : 1;
+    }
+    fmt::print("{} pages of {} bytes, {} free\n", num_pages, disk_manager.GetPageSize(), num_free);
+
+    if (!program.get<bool>("--dry-run")) {
+      const auto num_removed = disk_manager.TruncateFreeTail();
+      fmt::print("truncated {} pages ({} bytes) from the end of {}\n", num_removed,
+                 static_cast<uint64_t>(num_removed) * disk_manager.GetPageSize(), filename);
+    }
+    disk_manager.ShutDown();
+  } catch (const bustub::Exception &e) {
+    std::cerr << "Failed to open " << filename << ": " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/frame_replacer.h"
+#include "common/config.h"
+#include "fmt/core.h"
+
+/**
+ * Replays a recorded page access trace against every buffer pool replacement policy (or just the one given with
+ * --replacer) and reports the hit ratio of each. The trace file lists page ids in access order, separated by
+ * whitespace.
+ */
+auto main(int argc, char **argv) -> int {  // NOLINT
+  argparse::ArgumentParser program("bustub-replacer-trace");
+  program.add_argument("file").help("the page access trace to replay");
+  program.add_argument("--frames").help("number of buffer pool frames").default_value(1024).scan<'i', int>();
+  program.add_argument("-k").help("lookback constant of LRU-K").default_value(bustub::LRUK_REPLACER_K).scan<'i', int>();
+  program.add_argument("--replacer").help("only replay with this policy: lru-k, arc or 2q");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  std::vector<bustub::ReplacerPolicy> policies{bustub::ReplacerPolicy::LRU_K, bustub::ReplacerPolicy::ARC,
+                                               bustub::ReplacerPolicy::TWO_Q};
+  if (auto name = program.present("--replacer")) {
+    bustub::ReplacerPolicy policy;
+    if (!bustub::ParseReplacerPolicy(*name, &policy)) {
+      std::cerr << "Unknown replacer policy " << *name << std::endl;
+      return 1;
+    }
+    policies = {policy};
+  }
+
+  auto filename = program.get<std::string>("file");
+  std::ifstream file(filename);
+  if (!file) {
+    std::cerr << "Failed to open " << filename << std::endl;
+    return 1;
+  }
+  std::vector<bustub::page_id_t> trace;
+  bustub::page_id_t page_id;
+  while (file >> page_id) {
+    trace.push_back(page_id);
+  }
+
+  auto frames = program.get<int>("--frames");
+  auto k = program.get<int>("-k");
+  if (frames <= 0 || k <= 0) {
+    std::cerr << "--frames and -k must be positive" << std::endl;
+    return 1;
+  }
+
+  fmt::print("{} accesses, {} frames\n", trace.size(), frames);
+  for (auto policy : policies) {
+    auto result = bustub::ReplayTrace(policy, frames, k, trace);
+    fmt::print("{:<6} hits: {:>10} hit ratio: {:.4f}\n", bustub::ReplacerPolicyToString(policy), result.hits_,
+               result.HitRatio());
+  }
+  return 0;
+}
@@ -8,6 +8,7 @@
 #include <utility>
 
 #include "argparse/argparse.hpp"
+#include "buffer/frame_replacer.h"
 #include "common/bustub_instance.h"
 #include "common/exception.h"
 #include "common/util/string_util.h"
@@ -147,6 +148,22 @@ auto main(int argc, char **argv) -> int {  // NOLINT
   program.add_argument("--verbose").help("increase output verbosity").default_value(false).implicit_value(true);
   program.add_argument("-d", "--diff").help("write diff file").default_value(false).implicit_value(true);
   program.add_argument("--in-memory").help("use in-memory backend").default_value(false).implicit_value(true);
+  program.add_argument("--replacer")
+      .help("buffer pool replacement policy: lru-k, arc or 2q")
+      .default_value(std::string("lru-k"));
+  program.add_argument("--page-size")
+      .help("page size of a new database file, a power of two from 4096 to 65536")
+      .default_value(bustub::BUSTUB_PAGE_SIZE)
+      .scan<'i', int>();
+  program.add_argument("--compress-pages")
+      .help("compress the pages of the database file on disk")
+      .default_value(false)
+      .implicit_value(true);
+
+  program.add_argument("--direct-io")
+      .help("read and write the pages of the database file with O_DIRECT, bypassing the OS page cache")
+      .default_value(false)
+      .implicit_value(true);
 
   try {
     program.parse_args(argc, argv);
@@ -171,6 +188,14 @@ auto main(int argc, char **argv) -> int {  // NOLINT
 
   auto result = bustub::SQLLogicTestParser::Parse(script);
 
+  if (!bustub::ParseReplacerPolicy(program.get<std::string>("--replacer"), &bustub::replacer_policy)) {
+    std::cerr << "Unknown replacer policy " << program.get<std::string>("--replacer") << std::endl;
+    return 1;
+  }
+  bustub::database_page_size = program.get<int>("--page-size");
+  bustub::enable_page_compression = program.get<bool>("--compress-pages");
+  bustub::enable_direct_io = program.get<bool>("--direct-io");
+
   std::unique_ptr<bustub::BustubInstance> bustub;
 
   if (program.get<bool>("--in-memory")) {